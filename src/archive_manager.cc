@@ -80,6 +80,9 @@ describe(const fs::path& filename)
 #if HAVE_ARCHIVE_H
     static constexpr auto RAW_FORMAT_NAME = "raw"_frag;
     static constexpr auto GZ_FILTER_NAME = "gzip"_frag;
+#ifdef HAVE_ZSTD_H
+    static constexpr auto ZSTD_FILTER_NAME = "zstd"_frag;
+#endif
 
     auto_mem<archive> arc(archive_read_free);
 
@@ -111,6 +114,12 @@ describe(const fs::path& filename)
                 if (filter_count == 2 && GZ_FILTER_NAME == first_filter_name) {
                     return Ok(describe_result{unknown_file{}});
                 }
+#ifdef HAVE_ZSTD_H
+                if (filter_count == 2 && ZSTD_FILTER_NAME == first_filter_name)
+                {
+                    return Ok(describe_result{unknown_file{}});
+                }
+#endif
             }
             log_info(
                 "detected archive: %s -- %s", filename.c_str(), format_name);
@@ -36,6 +36,7 @@
 #include "ansi_vars.hh"
 #include "base/lnav_log.hh"
 #include "base/opt_util.hh"
+#include "base/string_util.hh"
 #include "config.h"
 #include "pcrepp/pcre2pp.hh"
 #include "scn/scan.h"
@@ -52,6 +53,10 @@ ansi_regex()
 size_t
 erase_ansi_escapes(string_fragment input)
 {
+    if (!has_ansi_escape_bytes(input)) {
+        return input.length();
+    }
+
     thread_local auto md = lnav::pcre2pp::match_data::unitialized();
 
     const auto& regex = ansi_regex();
@@ -133,6 +138,12 @@ scrub_ansi_string(std::string& str, string_attrs_t* sa)
     int erased = 0;
 
     std::replace(str.begin(), str.end(), '\0', ' ');
+    // Every alternative in the regex starts with or contains one of these
+    // bytes, so most lines can skip the match loop entirely.
+    if (!has_ansi_escape_bytes(str)) {
+        return;
+    }
+
     auto matcher = regex.capture_from(str).into(md);
     while (true) {
         auto match_res = matcher.matches(PCRE2_NO_UTF_CHECK);
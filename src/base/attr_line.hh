@@ -57,6 +57,11 @@ struct string_attr {
     {
     }
 
+    string_attr(const line_range& lr, string_attr_pair&& value)
+        : sa_range(lr), sa_type(value.first), sa_value(std::move(value.second))
+    {
+    }
+
     string_attr() = default;
 
     bool operator==(const string_attr& other) const
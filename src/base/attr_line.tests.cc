@@ -36,6 +36,55 @@
 
 using namespace lnav::roles::literals;
 
+TEST_CASE("attr_line_t::reuse-allocations")
+{
+    static const auto LINE = std::string(
+        "2024-01-01T00:00:00.000Z INFO a line that is long enough to need "
+        "heap storage for the string");
+
+    auto fill = [](attr_line_t& al) {
+        al.append(LINE);
+        al.al_attrs.emplace_back(line_range{0, 24},
+                                 VC_ROLE.value(role_t::VCR_ADJUSTED_TIME));
+        al.al_attrs.emplace_back(line_range{25, 29},
+                                 VC_STYLE.value(text_attrs::with_bold()));
+        al.al_attrs.emplace_back(line_range{30, 36},
+                                 VC_ROLE.value(role_t::VCR_KEYWORD));
+        al.al_attrs.emplace_back(line_range{0, -1}, SA_LEVEL.value(3));
+    };
+
+    attr_line_t al;
+
+    fill(al);
+    const auto* str_data = al.get_string().data();
+    const auto* attrs_data = al.get_attrs().data();
+    auto str_cap = al.get_string().capacity();
+    auto attrs_cap = al.get_attrs().capacity();
+    al.clear();
+    CHECK(al.get_attrs().capacity() == attrs_cap);
+
+    fill(al);
+
+    CHECK(al.get_attrs().size() == 4);
+    CHECK(al.get_string().capacity() == str_cap);
+    CHECK(al.get_attrs().capacity() == attrs_cap);
+    CHECK(al.get_string().data() == str_data);
+    CHECK(al.get_attrs().data() == attrs_data);
+}
+
+TEST_CASE("string_attr::move-value")
+{
+    auto msg = std::string(
+        "an error message that is long enough to need heap storage");
+    const auto* msg_data = msg.data();
+    string_attrs_t sa;
+
+    sa.emplace_back(line_range{0, -1}, SA_ERROR.value(std::move(msg)));
+
+    // The payload is moved into the attribute instead of copied.
+    CHECK(sa.back().sa_value.get<std::string>().data() == msg_data);
+}
+
 TEST_CASE("line_range")
 {
     line_range lr1{0, 95};
@@ -29,10 +29,17 @@
  * @file date_time_scanner.cc
  */
 
+#include <bitset>
 #include <chrono>
+#include <optional>
+#include <vector>
 
 #include "date_time_scanner.hh"
 
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
 #include "config.h"
 #include "date_time_scanner.cfg.hh"
 #include "injector.hh"
@@ -98,6 +105,536 @@ next_format(const char* const fmt[], int& index, int& locked_index)
     return retval;
 }
 
+namespace {
+
+/**
+ * Character classes for the leading bytes of a timestamp, one bit per byte.
+ */
+struct time_shape {
+    static constexpr size_t WINDOW = 64;
+
+    time_shape(const char* str, size_t len);
+
+    bool test(uint64_t mask, size_t pos) const
+    {
+        return pos < WINDOW && (mask >> pos) & 1;
+    }
+
+    /**
+     * Check if the bytes from the given position on have enough digits and
+     * colons for the rest of a format.
+     */
+    bool has_remaining(size_t pos, uint8_t digits, uint8_t colons) const
+    {
+        if (this->ts_len > WINDOW || pos >= WINDOW) {
+            // The rest of the timestamp might be outside of the window.
+            return true;
+        }
+
+        return count_bits(this->ts_digits >> pos) >= digits
+            && count_bits(this->ts_colons >> pos) >= colons;
+    }
+
+    static int count_bits(uint64_t bits)
+    {
+        // The builtin is a library call when POPCNT is not enabled.
+        bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+        bits = (bits & 0x3333333333333333ULL)
+            + ((bits >> 2) & 0x3333333333333333ULL);
+        bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return (bits * 0x0101010101010101ULL) >> 56;
+    }
+
+    const char* ts_str;
+    size_t ts_len;
+    uint64_t ts_digits{0};
+    uint64_t ts_alphas{0};
+    uint64_t ts_spaces{0};
+    uint64_t ts_colons{0};
+};
+
+time_shape::time_shape(const char* str, size_t len) : ts_str(str), ts_len(len)
+{
+    alignas(16) char buf[WINDOW] = {};
+
+    memcpy(buf, str, std::min(len, WINDOW));
+
+#if defined(__SSE2__)
+    const auto zero_minus_one = _mm_set1_epi8('0' - 1);
+    const auto nine_plus_one = _mm_set1_epi8('9' + 1);
+    const auto a_minus_one = _mm_set1_epi8('a' - 1);
+    const auto z_plus_one = _mm_set1_epi8('z' + 1);
+    const auto lower_bit = _mm_set1_epi8(0x20);
+    const auto space = _mm_set1_epi8(' ');
+    const auto colon = _mm_set1_epi8(':');
+    const auto to_bits = [](__m128i cmp, size_t index) {
+        return (uint64_t) (uint16_t) _mm_movemask_epi8(cmp) << index;
+    };
+
+    for (size_t index = 0; index < WINDOW; index += sizeof(__m128i)) {
+        auto chunk = _mm_load_si128((const __m128i*) &buf[index]);
+        auto lower = _mm_or_si128(chunk, lower_bit);
+
+        // The comparisons are signed, so bytes with the high bit set are
+        // not counted as digits or letters.
+        this->ts_digits
+            |= to_bits(_mm_and_si128(_mm_cmpgt_epi8(chunk, zero_minus_one),
+                                     _mm_cmplt_epi8(chunk, nine_plus_one)),
+                       index);
+        this->ts_alphas
+            |= to_bits(_mm_and_si128(_mm_cmpgt_epi8(lower, a_minus_one),
+                                     _mm_cmplt_epi8(lower, z_plus_one)),
+                       index);
+        this->ts_spaces |= to_bits(_mm_cmpeq_epi8(chunk, space), index);
+        this->ts_colons |= to_bits(_mm_cmpeq_epi8(chunk, colon), index);
+    }
+#else
+    for (size_t index = 0; index < WINDOW; index++) {
+        const auto ch = buf[index];
+        const auto lower = ch | 0x20;
+        const auto bit = uint64_t{1} << index;
+
+        if ('0' <= ch && ch <= '9') {
+            this->ts_digits |= bit;
+        } else if ('a' <= lower && lower <= 'z') {
+            this->ts_alphas |= bit;
+        } else if (ch == ' ') {
+            this->ts_spaces |= bit;
+        } else if (ch == ':') {
+            this->ts_colons |= bit;
+        }
+    }
+#endif
+}
+
+/**
+ * A trie of the shapes of the builtin time formats, used to rule out the
+ * formats that cannot match an input before running the real parsers.  The
+ * tokens mirror the widths consumed by the ptime_* functions for each
+ * specifier.  A specifier with a width that cannot be determined from the
+ * character classes ends the positional match and only the digits and
+ * colons needed by the rest of the format are counted.  Runs of fixed-width
+ * tokens are collapsed into a single node that is checked against the class
+ * masks of the input all at once.
+ */
+class format_shapes {
+public:
+    static constexpr size_t MAX_FORMATS = 256;
+
+    using candidates = std::bitset<MAX_FORMATS>;
+
+    static const format_shapes& builtin()
+    {
+        static const format_shapes retval(PTIMEC_FORMAT_STR);
+
+        return retval;
+    }
+
+    explicit format_shapes(const char* const fmts[]);
+
+    bool enabled() const { return this->fs_enabled; }
+
+    candidates match(const time_shape& shape) const
+    {
+        candidates retval;
+
+        this->match_node(shape, 0, 0, retval);
+        return retval;
+    }
+
+private:
+    enum class token_kind : uint8_t {
+        root,
+        literal,
+        digit,
+        digit_or_space,
+        alpha,
+        opt_digit,
+        month,
+        upto,
+        upto_end,
+        variable,
+    };
+
+    struct token {
+        token_kind t_kind;
+        char t_literal{'\0'};
+        uint8_t t_min_digits{0};
+
+        bool operator==(const token& other) const
+        {
+            return this->t_kind == other.t_kind
+                && this->t_literal == other.t_literal;
+        }
+    };
+
+    static bool is_fixed(token_kind kind)
+    {
+        switch (kind) {
+            case token_kind::literal:
+            case token_kind::digit:
+            case token_kind::digit_or_space:
+            case token_kind::alpha:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /* A format that can match once the input reaches a node. */
+    struct terminal {
+        int t_format;
+        uint8_t t_min_digits;
+        uint8_t t_min_colons;
+    };
+
+    struct node {
+        std::vector<token> n_tokens;
+        /* For a run of fixed-width tokens, the classes needed at each byte. */
+        uint64_t n_digits{0};
+        uint64_t n_digits_or_spaces{0};
+        uint64_t n_alphas{0};
+        std::vector<std::pair<uint8_t, char>> n_literals;
+        std::vector<uint32_t> n_children;
+        /* Formats whose positional part ends at this node. */
+        std::vector<terminal> n_terminals;
+        /* For a month, the formats to consider when the name is localized. */
+        std::vector<terminal> n_fallbacks;
+        candidates n_subtree;
+
+        token_kind kind() const { return this->n_tokens.front().t_kind; }
+    };
+
+    static std::vector<token> tokenize(const char* fmt);
+
+    void compress(uint32_t index);
+
+    void match_node(const time_shape& shape,
+                    uint32_t index,
+                    size_t pos,
+                    candidates& retval) const;
+
+    bool fs_enabled{true};
+    std::vector<node> fs_nodes;
+};
+
+std::vector<format_shapes::token>
+format_shapes::tokenize(const char* fmt)
+{
+    using tk = token_kind;
+
+    std::vector<token> retval;
+    auto add = [&retval](tk kind, uint8_t min_digits = 0, char lit = '\0') {
+        retval.emplace_back(token{kind, lit, min_digits});
+    };
+
+    for (const auto* curr = fmt; *curr; curr++) {
+        if (*curr != '%') {
+            add(tk::literal, 0, *curr);
+            continue;
+        }
+
+        curr += 1;
+        switch (*curr) {
+            case 'Y':
+                for (int lpc = 0; lpc < 4; lpc++) {
+                    add(tk::digit, 1);
+                }
+                break;
+            case 'y':
+            case 'M':
+            case 'S':
+                add(tk::digit, 1);
+                add(tk::digit, 1);
+                break;
+            case 'd':
+            case 'H':
+            case 'I':
+                add(tk::digit_or_space);
+                add(tk::digit, 1);
+                break;
+            case 'm':
+            case 'k':
+                add(tk::digit, 1);
+                add(tk::opt_digit);
+                break;
+            case 'j':
+                add(tk::digit, 1);
+                add(tk::opt_digit);
+                add(tk::opt_digit);
+                break;
+            case 'e':
+                add(tk::digit_or_space);
+                add(tk::opt_digit);
+                break;
+            case 'p':
+                add(tk::alpha);
+                add(tk::alpha);
+                break;
+            case 'b':
+                add(tk::month);
+                break;
+            case 'a':
+            case 'Z':
+                if (curr[1] == '\0') {
+                    add(tk::upto_end);
+                } else {
+                    add(tk::upto, 0, curr[1]);
+                }
+                break;
+            case 'l':
+                add(tk::variable, 1);
+                break;
+            case '%':
+                add(tk::literal, 0, '%');
+                break;
+            case '\0':
+                return retval;
+            default:
+                add(tk::variable);
+                break;
+        }
+    }
+
+    return retval;
+}
+
+format_shapes::format_shapes(const char* const fmts[])
+{
+    this->fs_nodes.emplace_back();
+    this->fs_nodes.back().n_tokens.emplace_back(token{token_kind::root});
+    for (int fmt_index = 0; fmts[fmt_index] != nullptr; fmt_index++) {
+        if ((size_t) fmt_index >= MAX_FORMATS) {
+            this->fs_enabled = false;
+            return;
+        }
+
+        auto tokens = tokenize(fmts[fmt_index]);
+        std::vector<uint8_t> min_digits(tokens.size() + 1);
+        std::vector<uint8_t> min_colons(tokens.size() + 1);
+        for (auto lpc = tokens.size(); lpc > 0; lpc--) {
+            const auto& tok = tokens[lpc - 1];
+
+            min_digits[lpc - 1] = min_digits[lpc] + tok.t_min_digits;
+            min_colons[lpc - 1] = min_colons[lpc]
+                + (tok.t_kind == token_kind::literal && tok.t_literal == ':');
+        }
+
+        uint32_t curr = 0;
+        size_t tok_index = 0;
+        this->fs_nodes[curr].n_subtree.set(fmt_index);
+        for (; tok_index < tokens.size(); tok_index++) {
+            const auto& tok = tokens[tok_index];
+
+            if (tok.t_kind == token_kind::variable) {
+                break;
+            }
+
+            std::optional<uint32_t> next;
+            for (const auto child : this->fs_nodes[curr].n_children) {
+                if (this->fs_nodes[child].n_tokens.front() == tok) {
+                    next = child;
+                    break;
+                }
+            }
+            if (!next) {
+                next = this->fs_nodes.size();
+                this->fs_nodes.emplace_back();
+                this->fs_nodes.back().n_tokens.emplace_back(tok);
+                this->fs_nodes[curr].n_children.emplace_back(next.value());
+            }
+            curr = next.value();
+            this->fs_nodes[curr].n_subtree.set(fmt_index);
+            if (tok.t_kind == token_kind::month) {
+                this->fs_nodes[curr].n_fallbacks.emplace_back(
+                    terminal{fmt_index,
+                             min_digits[tok_index + 1],
+                             min_colons[tok_index + 1]});
+            }
+        }
+        this->fs_nodes[curr].n_terminals.emplace_back(
+            terminal{fmt_index, min_digits[tok_index], min_colons[tok_index]});
+    }
+
+    this->compress(0);
+}
+
+void
+format_shapes::compress(uint32_t index)
+{
+    auto& curr = this->fs_nodes[index];
+
+    if (is_fixed(curr.kind())) {
+        while (curr.n_terminals.empty() && curr.n_children.size() == 1
+               && curr.n_tokens.size() < time_shape::WINDOW)
+        {
+            auto& child = this->fs_nodes[curr.n_children.front()];
+
+            if (!is_fixed(child.kind())) {
+                break;
+            }
+            curr.n_tokens.emplace_back(child.n_tokens.front());
+            curr.n_terminals = std::move(child.n_terminals);
+            curr.n_children = std::move(child.n_children);
+        }
+
+        for (size_t lpc = 0; lpc < curr.n_tokens.size(); lpc++) {
+            const auto& tok = curr.n_tokens[lpc];
+            const auto bit = uint64_t{1} << lpc;
+
+            switch (tok.t_kind) {
+                case token_kind::literal:
+                    curr.n_literals.emplace_back(lpc, tok.t_literal);
+                    break;
+                case token_kind::digit:
+                    curr.n_digits |= bit;
+                    break;
+                case token_kind::digit_or_space:
+                    curr.n_digits_or_spaces |= bit;
+                    break;
+                case token_kind::alpha:
+                    curr.n_alphas |= bit;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    for (const auto child : curr.n_children) {
+        this->compress(child);
+    }
+}
+
+void
+format_shapes::match_node(const time_shape& shape,
+                          uint32_t index,
+                          size_t pos,
+                          candidates& retval) const
+{
+    using tk = token_kind;
+
+    const auto& curr = this->fs_nodes[index];
+
+    if (pos >= time_shape::WINDOW) {
+        retval |= curr.n_subtree;
+        return;
+    }
+
+    for (const auto& term : curr.n_terminals) {
+        if (shape.has_remaining(pos, term.t_min_digits, term.t_min_colons)) {
+            retval.set(term.t_format);
+        }
+    }
+
+    for (const auto child_index : curr.n_children) {
+        const auto& child = this->fs_nodes[child_index];
+        const auto& tok = child.n_tokens.front();
+        auto next_pos = pos + child.n_tokens.size();
+
+        switch (tok.t_kind) {
+            case tk::root:
+            case tk::variable:
+                continue;
+            case tk::literal:
+            case tk::digit:
+            case tk::digit_or_space:
+            case tk::alpha: {
+                if (next_pos > time_shape::WINDOW) {
+                    retval |= child.n_subtree;
+                    continue;
+                }
+
+                const auto digits = shape.ts_digits >> pos;
+                const auto spaces = shape.ts_spaces >> pos;
+                const auto alphas = shape.ts_alphas >> pos;
+
+                if ((digits & child.n_digits) != child.n_digits
+                    || ((digits | spaces) & child.n_digits_or_spaces)
+                        != child.n_digits_or_spaces
+                    || (alphas & child.n_alphas) != child.n_alphas)
+                {
+                    continue;
+                }
+
+                auto literals_match = true;
+                for (const auto& lit : child.n_literals) {
+                    const auto lit_pos = pos + lit.first;
+
+                    if (lit_pos >= shape.ts_len
+                        || shape.ts_str[lit_pos] != lit.second)
+                    {
+                        literals_match = false;
+                        break;
+                    }
+                }
+                if (!literals_match) {
+                    continue;
+                }
+                break;
+            }
+            case tk::opt_digit:
+                if (!shape.test(shape.ts_digits, pos)) {
+                    next_pos = pos;
+                }
+                break;
+            case tk::upto:
+            case tk::upto_end: {
+                // Mirrors ptime_Z_upto()
+                const auto* rest = &shape.ts_str[pos];
+                const auto avail = pos < shape.ts_len ? shape.ts_len - pos : 0;
+
+                if (avail >= 3
+                    && (memcmp(rest, "UTC", 3) == 0
+                        || memcmp(rest, "GMT", 3) == 0))
+                {
+                    next_pos = pos + 3;
+                } else if (tok.t_kind == tk::upto_end) {
+                    next_pos = shape.ts_len;
+                } else {
+                    const auto* term = (const char*) memchr(
+                        rest, tok.t_literal, avail);
+
+                    if (term == nullptr) {
+                        continue;
+                    }
+                    next_pos = term - shape.ts_str;
+                }
+                break;
+            }
+            case tk::month: {
+                exttm tm;
+
+                if (pos + 3 < shape.ts_len
+                    && ptime_b_int(&tm, shape.ts_str, pos))
+                {
+                    next_pos = pos + 3;
+                    break;
+                }
+                // Localized month names start with a letter or a multibyte
+                // character.
+                if (pos < shape.ts_len
+                    && (shape.test(shape.ts_alphas, pos)
+                        || (unsigned char) shape.ts_str[pos] >= 0x80))
+                {
+                    for (const auto& term : child.n_fallbacks) {
+                        if (shape.has_remaining(
+                                pos, term.t_min_digits, term.t_min_colons))
+                        {
+                            retval.set(term.t_format);
+                        }
+                    }
+                }
+                continue;
+            }
+        }
+
+        this->match_node(shape, child_index, next_pos, retval);
+    }
+}
+
+}  // namespace
+
 const char*
 date_time_scanner::scan(const char* time_dest,
                         size_t time_len,
@@ -118,7 +655,30 @@ date_time_scanner::scan(const char* time_dest,
     }
 
     this->dts_zoned_to_local = cfg.c_zoned_to_local;
-    while (next_format(time_fmt, curr_time_fmt, this->dts_fmt_lock)) {
+    if (this->dts_prefix_memo_valid) {
+        retval = this->scan_memoized(
+            time_dest, time_len, time_fmt, tm_out, tv_out, convert_local);
+        if (retval != nullptr) {
+            found = true;
+        } else {
+            this->dts_prefix_memo_valid = false;
+        }
+    }
+    std::optional<format_shapes::candidates> candidates;
+    if (!found && this->dts_fmt_lock == -1 && time_fmt == PTIMEC_FORMAT_STR
+        && time_len > 0 && time_dest[0] != '+'
+        && format_shapes::builtin().enabled())
+    {
+        // Rule out the builtin formats that cannot match instead of trying
+        // each one in turn.
+        candidates = format_shapes::builtin().match(
+            time_shape{time_dest, time_len});
+    }
+    while (!found && next_format(time_fmt, curr_time_fmt, this->dts_fmt_lock))
+    {
+        if (candidates && !candidates->test(curr_time_fmt)) {
+            continue;
+        }
         *tm_out = this->dts_base_tm;
         tm_out->et_tm.tm_yday = -1;
         tm_out->et_flags = 0;
@@ -202,7 +762,8 @@ date_time_scanner::scan(const char* time_dest,
                     && last_tm.tm_mon == tm_out->et_tm.tm_mon
                     && last_tm.tm_mday == tm_out->et_tm.tm_mday
                     && last_tm.tm_hour == tm_out->et_tm.tm_hour
-                    && last_tm.tm_min == tm_out->et_tm.tm_min)
+                    && last_tm.tm_min == tm_out->et_tm.tm_min
+                    && this->dts_last_tm.et_gmtoff == tm_out->et_gmtoff)
                 {
                     const auto sec_diff = tm_out->et_tm.tm_sec - last_tm.tm_sec;
 
@@ -217,6 +778,8 @@ date_time_scanner::scan(const char* time_dest,
 
                 this->dts_fmt_lock = curr_time_fmt;
                 this->dts_fmt_len = retval - time_dest;
+                this->save_prefix_memo(
+                    time_dest, time_len, time_fmt, convert_local);
 
                 found = true;
                 break;
@@ -266,7 +829,8 @@ date_time_scanner::scan(const char* time_dest,
                     && last_tm.tm_mon == tm_out->et_tm.tm_mon
                     && last_tm.tm_mday == tm_out->et_tm.tm_mday
                     && last_tm.tm_hour == tm_out->et_tm.tm_hour
-                    && last_tm.tm_min == tm_out->et_tm.tm_min)
+                    && last_tm.tm_min == tm_out->et_tm.tm_min
+                    && this->dts_last_tm.et_gmtoff == tm_out->et_gmtoff)
                 {
                     const auto sec_diff = tm_out->et_tm.tm_sec - last_tm.tm_sec;
 
@@ -281,6 +845,8 @@ date_time_scanner::scan(const char* time_dest,
 
                 this->dts_fmt_lock = curr_time_fmt;
                 this->dts_fmt_len = retval - time_dest;
+                this->save_prefix_memo(
+                    time_dest, time_len, time_fmt, convert_local);
 
                 found = true;
                 break;
@@ -337,6 +903,168 @@ date_time_scanner::scan(const char* time_dest,
     return retval;
 }
 
+const char*
+date_time_scanner::scan_memoized(const char* time_dest,
+                                 size_t time_len,
+                                 const char* const time_fmt[],
+                                 struct exttm* tm_out,
+                                 struct timeval& tv_out,
+                                 bool convert_local)
+{
+    const auto& pm = this->dts_prefix_memo;
+
+    if (pm.pm_fmt != time_fmt || pm.pm_fmt_lock != this->dts_fmt_lock
+        || pm.pm_convert_local != convert_local
+        || pm.pm_local_time != this->dts_local_time
+        || pm.pm_zoned_to_local != this->dts_zoned_to_local
+        || pm.pm_keep_base_tz != this->dts_keep_base_tz
+        || pm.pm_default_zone != this->dts_default_zone)
+    {
+        return nullptr;
+    }
+
+    const auto prefix_len = pm.pm_prefix.size();
+    if (time_len < prefix_len + 2
+        || memcmp(time_dest, pm.pm_prefix.data(), prefix_len) != 0)
+    {
+        return nullptr;
+    }
+
+    const auto sec_hi = time_dest[prefix_len];
+    const auto sec_lo = time_dest[prefix_len + 1];
+    if (!isdigit(sec_hi) || !isdigit(sec_lo)) {
+        return nullptr;
+    }
+    const auto sec = (sec_hi - '0') * 10 + (sec_lo - '0');
+    const auto new_sec = this->dts_last_tm.et_tm.tm_sec + (sec - pm.pm_sec);
+    if (sec >= 60 || new_sec < 0 || new_sec >= 60) {
+        return nullptr;
+    }
+
+    auto tm = this->dts_last_tm;
+    off_t off = prefix_len + 2;
+    if (!pm.pm_frac_fmt.empty()
+        && !ptime_fmt(pm.pm_frac_fmt.c_str(), &tm, time_dest, off, time_len))
+    {
+        return nullptr;
+    }
+
+    const auto tail_len = pm.pm_tail.size();
+    if (off + tail_len > time_len
+        || memcmp(&time_dest[off], pm.pm_tail.data(), tail_len) != 0)
+    {
+        return nullptr;
+    }
+    off += tail_len;
+
+    const int next = (size_t) off < time_len ? time_dest[off] : -1;
+    if (pm.pm_tail_has_spec && next != pm.pm_next) {
+        // The tail fields might have consumed more input.
+        return nullptr;
+    }
+    if (time_fmt != PTIMEC_FORMAT_STR && next != -1 && next != '.'
+        && next != ',')
+    {
+        return nullptr;
+    }
+
+    tm.et_tm.tm_sec = new_sec;
+    *tm_out = tm;
+    tv_out = this->dts_last_tv;
+    tv_out.tv_sec += sec - pm.pm_sec;
+    tv_out.tv_usec = tm_out->et_nsec / 1000;
+    this->dts_prefix_memo.pm_sec = sec;
+    this->dts_fmt_len = off;
+
+    return &time_dest[off];
+}
+
+void
+date_time_scanner::save_prefix_memo(const char* time_dest,
+                                    size_t time_len,
+                                    const char* const time_fmt[],
+                                    bool convert_local)
+{
+    const auto* fmt = time_fmt[this->dts_fmt_lock];
+    const char* sec_spec = nullptr;
+
+    this->dts_prefix_memo_valid = false;
+    for (const auto* curr = fmt; *curr; curr++) {
+        if (*curr != '%') {
+            continue;
+        }
+        curr += 1;
+        switch (*curr) {
+            case 'S':
+                if (sec_spec == nullptr) {
+                    sec_spec = curr - 1;
+                }
+                break;
+            case '@':
+            case '6':
+            case 'i':
+            case 'q':
+            case 's':
+                // Epoch-based fields replace the whole time.
+                return;
+            case '\0':
+                return;
+        }
+    }
+    if (sec_spec == nullptr) {
+        return;
+    }
+
+    auto& pm = this->dts_prefix_memo;
+    const auto prefix_fmt = std::string(fmt, sec_spec);
+    auto scratch = this->dts_base_tm;
+    off_t off = 0;
+    if (!ptime_fmt(prefix_fmt.c_str(), &scratch, time_dest, off, time_len)
+        || (size_t) off + 2 > time_len || !isdigit(time_dest[off])
+        || !isdigit(time_dest[off + 1]))
+    {
+        return;
+    }
+    pm.pm_prefix.assign(time_dest, off);
+    pm.pm_sec = (time_dest[off] - '0') * 10 + (time_dest[off + 1] - '0');
+    off += 2;
+
+    const auto* rest = sec_spec + 2;
+    auto frac_len = 0;
+    if (rest[0] != '\0' && strchr(".,:", rest[0]) != nullptr && rest[1] == '%'
+        && rest[2] != '\0' && strchr("LfN", rest[2]) != nullptr)
+    {
+        frac_len = 3;
+    } else if (rest[0] == '%' && rest[1] != '\0'
+               && strchr("LfN", rest[1]) != nullptr)
+    {
+        frac_len = 2;
+    }
+    pm.pm_frac_fmt.assign(rest, frac_len);
+    if (frac_len > 0
+        && !ptime_fmt(pm.pm_frac_fmt.c_str(), &scratch, time_dest, off, time_len))
+    {
+        return;
+    }
+    if (off > this->dts_fmt_len) {
+        return;
+    }
+    pm.pm_tail.assign(&time_dest[off], this->dts_fmt_len - off);
+    pm.pm_tail_has_spec = strchr(rest + frac_len, '%') != nullptr;
+    pm.pm_next = (size_t) this->dts_fmt_len < time_len
+        ? time_dest[this->dts_fmt_len]
+        : -1;
+
+    pm.pm_fmt = time_fmt;
+    pm.pm_fmt_lock = this->dts_fmt_lock;
+    pm.pm_convert_local = convert_local;
+    pm.pm_local_time = this->dts_local_time;
+    pm.pm_zoned_to_local = this->dts_zoned_to_local;
+    pm.pm_keep_base_tz = this->dts_keep_base_tz;
+    pm.pm_default_zone = this->dts_default_zone;
+    this->dts_prefix_memo_valid = true;
+}
+
 void
 date_time_scanner::clear()
 {
@@ -348,6 +1076,7 @@ date_time_scanner::clear()
     this->dts_last_tm = exttm{};
     this->dts_localtime_cached_gmt = 0;
     this->dts_localtime_cached_tm = tm{};
+    this->dts_prefix_memo_valid = false;
 }
 
 void
@@ -357,6 +1086,7 @@ date_time_scanner::set_base_time(time_t base_time, const tm& local_tm)
     this->dts_base_tm.et_tm = local_tm;
     this->dts_last_tm = exttm{};
     this->dts_last_tv = timeval{};
+    this->dts_prefix_memo_valid = false;
 }
 
 void
@@ -102,6 +102,31 @@ struct date_time_scanner {
     tm dts_localtime_cached_tm{};
     const date::time_zone* dts_default_zone{nullptr};
 
+    /**
+     * The bytes leading up to the seconds field of the last timestamp that
+     * was fully parsed.  Consecutive timestamps usually share the same date,
+     * hour, and minute, so, when the prefix matches, only the seconds and
+     * any fractional part need to be parsed and applied to dts_last_tm.
+     */
+    struct prefix_memo {
+        const char* const* pm_fmt{nullptr};
+        int pm_fmt_lock{-1};
+        bool pm_convert_local{false};
+        bool pm_local_time{false};
+        bool pm_zoned_to_local{false};
+        bool pm_keep_base_tz{false};
+        const date::time_zone* pm_default_zone{nullptr};
+        std::string pm_prefix;
+        int pm_sec{0};
+        std::string pm_frac_fmt;
+        std::string pm_tail;
+        bool pm_tail_has_spec{false};
+        int pm_next{-1};
+    };
+
+    bool dts_prefix_memo_valid{false};
+    prefix_memo dts_prefix_memo;
+
     static const int EXPIRE_TIME = 15 * 60;
 
     const char* scan(const char* time_src,
@@ -111,6 +136,18 @@ struct date_time_scanner {
                      struct timeval& tv_out,
                      bool convert_local = true);
 
+    const char* scan_memoized(const char* time_src,
+                              size_t time_len,
+                              const char* const time_fmt[],
+                              struct exttm* tm_out,
+                              struct timeval& tv_out,
+                              bool convert_local);
+
+    void save_prefix_memo(const char* time_src,
+                          size_t time_len,
+                          const char* const time_fmt[],
+                          bool convert_local);
+
     size_t ftime(char* dst,
                  size_t len,
                  const char* const time_fmt[],
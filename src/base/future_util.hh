@@ -30,13 +30,22 @@
 #ifndef lnav_future_util_hh
 #define lnav_future_util_hh
 
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 #include "progress.hh"
 
 namespace lnav::futures {
 
+template<typename T>
+class detached_task;
+
 /**
  * Create a future that is ready to immediately return a result.
  *
@@ -118,6 +127,243 @@ public:
     size_t fq_max_queue_size;
 };
 
+namespace details {
+
+/**
+ * The part of a detached_task's state that the task registry needs.
+ */
+class task_state {
+public:
+    /**
+     * @return True if the handle was dropped, or lnav is exiting, and the
+     * result is no longer needed.
+     */
+    bool is_cancelled() const { return this->ts_cancelled.load(); }
+
+protected:
+    friend class task_registry;
+    template<typename T>
+    friend class lnav::futures::detached_task;
+
+    std::atomic<bool> ts_cancelled{false};
+    std::atomic<bool> ts_exited{false};
+};
+
+/**
+ * Keeps track of the threads started for detached tasks so they can be
+ * joined before exiting.
+ */
+class task_registry {
+public:
+    static task_registry& singleton()
+    {
+        static task_registry retval;
+
+        return retval;
+    }
+
+    ~task_registry() { this->cancel_and_join(); }
+
+    void add(std::shared_ptr<task_state> state, std::thread th)
+    {
+        std::lock_guard<std::mutex> lg(this->tr_mutex);
+
+        // Join the threads that are done so the list does not grow.
+        auto iter = this->tr_entries.begin();
+        while (iter != this->tr_entries.end()) {
+            if (iter->e_state->ts_exited.load()) {
+                iter->e_thread.join();
+                iter = this->tr_entries.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        this->tr_entries.emplace_back(entry{std::move(state), std::move(th)});
+    }
+
+    size_t cancel_and_join()
+    {
+        std::deque<entry> entries;
+
+        {
+            std::lock_guard<std::mutex> lg(this->tr_mutex);
+
+            entries.swap(this->tr_entries);
+        }
+        for (auto& ent : entries) {
+            ent.e_state->ts_cancelled.store(true);
+        }
+        for (auto& ent : entries) {
+            ent.e_thread.join();
+        }
+
+        return entries.size();
+    }
+
+private:
+    struct entry {
+        std::shared_ptr<task_state> e_state;
+        std::thread e_thread;
+    };
+
+    std::mutex tr_mutex;
+    std::deque<entry> tr_entries;
+};
+
+}  // namespace details
+
+/**
+ * Cancel the detached tasks that are still running and wait for their
+ * threads to exit.  This should be called before main() returns so that
+ * no task is still running while the globals are destroyed.
+ *
+ * @return The number of threads that were joined.
+ */
+inline size_t
+join_detached_tasks()
+{
+    return details::task_registry::singleton().cancel_and_join();
+}
+
+/**
+ * A handle for work that runs on its own thread.  Unlike the future
+ * returned by std::async, destroying the handle does not wait for the work
+ * to finish.  The work is asked to stop instead and the thread frees the
+ * shared state when it exits.  The thread is joined later, either when
+ * another task is started or by join_detached_tasks().
+ *
+ * @tparam T The result of the work.
+ */
+template<typename T>
+class detached_task {
+public:
+    /**
+     * The state shared by the handle and the thread doing the work.
+     */
+    class context : public details::task_state {
+    public:
+        void set_progress(size_t done, size_t total)
+        {
+            this->c_done.store(done);
+            this->c_total.store(total);
+        }
+
+    private:
+        friend detached_task;
+
+        std::atomic<size_t> c_done{0};
+        std::atomic<size_t> c_total{0};
+        std::mutex c_mutex;
+        std::condition_variable c_cond;
+        bool c_finished{false};
+        std::optional<T> c_result;
+        std::exception_ptr c_error;
+    };
+
+    /**
+     * Start the work on a new thread.
+     *
+     * @param func The work to do, which is passed the context so that it
+     *   can check for cancellation and report progress.
+     */
+    template<typename F>
+    static detached_task start(F func)
+    {
+        detached_task retval;
+        auto ctx = std::make_shared<context>();
+
+        retval.dt_context = ctx;
+        auto th = std::thread([ctx, func = std::move(func)]() mutable {
+            std::optional<T> result;
+            std::exception_ptr error;
+
+            try {
+                result.emplace(func(*ctx));
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lg(ctx->c_mutex);
+                ctx->c_result = std::move(result);
+                ctx->c_error = error;
+                ctx->c_finished = true;
+                ctx->c_cond.notify_all();
+            }
+            ctx->ts_exited.store(true);
+        });
+        details::task_registry::singleton().add(ctx, std::move(th));
+
+        return retval;
+    }
+
+    detached_task() = default;
+    detached_task(const detached_task&) = delete;
+    detached_task& operator=(const detached_task&) = delete;
+    detached_task(detached_task&& other) noexcept = default;
+
+    detached_task& operator=(detached_task&& other) noexcept
+    {
+        this->cancel();
+        this->dt_context = std::move(other.dt_context);
+        return *this;
+    }
+
+    ~detached_task() { this->cancel(); }
+
+    bool valid() const { return this->dt_context != nullptr; }
+
+    bool is_ready() const
+    {
+        std::lock_guard<std::mutex> lg(this->dt_context->c_mutex);
+
+        return this->dt_context->c_finished;
+    }
+
+    /**
+     * @return The progress last reported by the work as a pair of the
+     * amount done and the total, which is zero if it is not known.
+     */
+    std::pair<size_t, size_t> get_progress() const
+    {
+        return {
+            this->dt_context->c_done.load(),
+            this->dt_context->c_total.load(),
+        };
+    }
+
+    /**
+     * Wait for the work to finish and return its result.  The handle is no
+     * longer valid afterward.
+     */
+    T get()
+    {
+        auto ctx = std::move(this->dt_context);
+        std::unique_lock<std::mutex> lk(ctx->c_mutex);
+
+        ctx->c_cond.wait(lk, [&ctx]() { return ctx->c_finished; });
+        if (ctx->c_error) {
+            std::rethrow_exception(ctx->c_error);
+        }
+
+        return std::move(ctx->c_result.value());
+    }
+
+    /**
+     * Ask the work to stop and release the handle without waiting.
+     */
+    void cancel()
+    {
+        if (this->dt_context != nullptr) {
+            this->dt_context->ts_cancelled.store(true);
+            this->dt_context.reset();
+        }
+    }
+
+private:
+    std::shared_ptr<context> dt_context;
+};
+
 }  // namespace lnav::futures
 
 #endif
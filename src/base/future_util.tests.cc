@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2024, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "base/future_util.hh"
+
+#include "config.h"
+#include "doctest/doctest.h"
+
+using int_task = lnav::futures::detached_task<int>;
+
+TEST_CASE("detached_task::get")
+{
+    auto task = int_task::start([](int_task::context& ctx) {
+        ctx.set_progress(1, 2);
+        return 42;
+    });
+
+    CHECK(task.valid());
+    CHECK(task.get() == 42);
+    CHECK_FALSE(task.valid());
+}
+
+TEST_CASE("detached_task::error")
+{
+    auto task = int_task::start([](int_task::context&) -> int {
+        throw std::runtime_error("failed");
+    });
+
+    CHECK_THROWS_AS(task.get(), std::runtime_error);
+}
+
+TEST_CASE("detached_task::cancel")
+{
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+
+    {
+        auto task = int_task::start([cancelled](int_task::context& ctx) {
+            while (!ctx.is_cancelled()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            cancelled->store(true);
+            return 0;
+        });
+
+        CHECK_FALSE(task.is_ready());
+    }
+
+    // Dropping the handle should not wait for the work to finish, only
+    // ask it to stop.
+    for (int lpc = 0; lpc < 5000 && !cancelled->load(); lpc++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(cancelled->load());
+}
+
+TEST_CASE("detached_task::join")
+{
+    auto task = int_task::start([](int_task::context& ctx) {
+        while (!ctx.is_cancelled()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 1;
+    });
+
+    // The handle is still alive, so only the shutdown can stop the work.
+    CHECK(lnav::futures::join_detached_tasks() >= 1);
+    CHECK(task.is_ready());
+    CHECK(task.get() == 1);
+    CHECK(lnav::futures::join_detached_tasks() == 0);
+}
@@ -30,38 +30,97 @@
  */
 
 #include <mutex>
+#include <vector>
 
 #include "intern_string.hh"
 
 #include <string.h>
 
+#include "ArenaAlloc/arenaalloc.h"
 #include "config.h"
 #include "fmt/ostream.h"
 #include "lnav_log.hh"
 #include "pcrepp/pcre2pp.hh"
+#include "string_util.hh"
 #include "unictype.h"
 #include "uniwidth.h"
 #include "ww898/cp_utf8.hpp"
 #include "xxHash/xxhash.h"
 
-const static int TABLE_SIZE = 4095;
+namespace {
 
-struct intern_string::intern_table {
-    ~intern_table()
-    {
-        for (auto is : this->it_table) {
-            auto curr = is;
+// The table is split into shards, each with its own lock, so that
+// threads interning different strings rarely contend with each other.
+constexpr size_t SHARD_COUNT = 64;
+constexpr int SHARD_SHIFT = 58;
+constexpr size_t INITIAL_BUCKET_COUNT = 64;
+constexpr size_t CACHE_SIZE = 512;
+constexpr size_t ARENA_BLOCK_SIZE = 16 * 1024;
 
-            while (curr != nullptr) {
-                auto next = curr->is_next;
+// The full 64-bit hash is used, even where unsigned long is 32 bits, since
+// the shard is picked from the top bits.
+uint64_t
+intern_hash(const char* str, size_t len)
+{
+    return XXH3_64bits(str, len);
+}
+
+struct lookup_cache_entry {
+    uint64_t lce_hash{0};
+    const intern_string* lce_value{nullptr};
+};
 
-                delete curr;
-                curr = next;
+// Most lookups are for a small working set of field and format names,
+// so a per-thread cache avoids taking a lock for them at all.
+thread_local lookup_cache_entry LOOKUP_CACHE[CACHE_SIZE];
+
+}  // namespace
+
+struct intern_string::intern_table {
+    struct shard {
+        std::mutex s_mutex;
+        std::vector<intern_string*> s_buckets
+            = std::vector<intern_string*>(INITIAL_BUCKET_COUNT);
+        size_t s_count{0};
+        // Interned strings live until the table is destroyed, so they are
+        // carved out of large blocks instead of being allocated one by one.
+        ArenaAlloc::Alloc<char> s_allocator{ARENA_BLOCK_SIZE};
+
+        intern_string* create(const char* str, ssize_t len)
+        {
+            auto* mem = this->s_allocator.allocate(sizeof(intern_string)
+                                                   + len + 1);
+            auto* str_copy = mem + sizeof(intern_string);
+
+            memcpy(str_copy, str, len);
+            str_copy[len] = '\0';
+
+            return new (mem) intern_string(str_copy, len);
+        }
+
+        void grow()
+        {
+            auto new_buckets
+                = std::vector<intern_string*>(this->s_buckets.size() * 2);
+            const auto mask = new_buckets.size() - 1;
+
+            for (auto* curr : this->s_buckets) {
+                while (curr != nullptr) {
+                    auto* next = curr->is_next;
+                    auto h = intern_hash(curr->is_str.data(),
+                                         curr->is_str.length());
+                    auto& bucket = new_buckets[h & mask];
+
+                    curr->is_next = bucket;
+                    bucket = curr;
+                    curr = next;
+                }
             }
+            this->s_buckets = std::move(new_buckets);
         }
-    }
+    };
 
-    intern_string* it_table[TABLE_SIZE];
+    shard it_shards[SHARD_COUNT];
 };
 
 intern_table_lifetime
@@ -81,36 +140,46 @@ hash_str(const char* str, size_t len)
 const intern_string*
 intern_string::lookup(const char* str, ssize_t len) noexcept
 {
-    unsigned long h;
-    intern_string* curr;
-
     if (len == -1) {
         len = strlen(str);
     }
-    h = hash_str(str, len) % TABLE_SIZE;
 
+    const auto h = intern_hash(str, len);
+    auto& cache_entry = LOOKUP_CACHE[h % CACHE_SIZE];
+    const auto* cached = cache_entry.lce_value;
+    if (cached != nullptr && cache_entry.lce_hash == h
+        && static_cast<ssize_t>(cached->is_str.length()) == len
+        && memcmp(cached->is_str.data(), str, len) == 0)
     {
-        static std::mutex table_mutex;
+        return cached;
+    }
 
-        std::lock_guard<std::mutex> lk(table_mutex);
-        auto tab = get_table_lifetime();
+    auto tab = get_table_lifetime();
+    auto& sh = tab->it_shards[(h >> SHARD_SHIFT) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lk(sh.s_mutex);
+    auto& bucket = sh.s_buckets[h & (sh.s_buckets.size() - 1)];
+    intern_string* curr = bucket;
 
-        curr = tab->it_table[h];
-        while (curr != nullptr) {
-            if (static_cast<ssize_t>(curr->is_str.size()) == len
-                && strncmp(curr->is_str.c_str(), str, len) == 0)
-            {
-                return curr;
-            }
-            curr = curr->is_next;
+    while (curr != nullptr) {
+        if (static_cast<ssize_t>(curr->is_str.length()) == len
+            && memcmp(curr->is_str.data(), str, len) == 0)
+        {
+            cache_entry = {h, curr};
+            return curr;
         }
+        curr = curr->is_next;
+    }
 
-        curr = new intern_string(str, len);
-        curr->is_next = tab->it_table[h];
-        tab->it_table[h] = curr;
-
-        return curr;
+    curr = sh.create(str, len);
+    curr->is_next = bucket;
+    bucket = curr;
+    sh.s_count += 1;
+    if (sh.s_count > sh.s_buckets.size()) {
+        sh.grow();
     }
+    cache_entry = {h, curr};
+
+    return curr;
 }
 
 const intern_string*
@@ -669,6 +738,16 @@ string_fragment::column_width() const
     size_t retval = 0;
 
     while (index < this->sf_end) {
+        auto ascii_len
+            = printable_ascii_prefix(string_fragment::from_byte_range(
+                this->sf_string, index, this->sf_end));
+
+        retval += ascii_len;
+        index += ascii_len;
+        if (index >= this->sf_end) {
+            break;
+        }
+
         auto read_res = ww898::utf::utf8::read(
             [this, &index]() { return this->sf_string[index++]; });
         if (read_res.isErr()) {
@@ -800,16 +800,13 @@ public:
 
     static const intern_string* lookup(const std::string& str) noexcept;
 
-    const char* get() const { return this->is_str.c_str(); };
+    const char* get() const { return this->is_str.data(); };
 
-    size_t size() const { return this->is_str.size(); }
+    size_t size() const { return this->is_str.length(); }
 
-    std::string to_string() const { return this->is_str; }
+    std::string to_string() const { return this->is_str.to_string(); }
 
-    string_fragment to_string_fragment() const
-    {
-        return string_fragment{this->is_str};
-    }
+    string_fragment to_string_fragment() const { return this->is_str; }
 
     bool startswith(const char* prefix) const;
 
@@ -819,13 +816,17 @@ public:
 private:
     friend intern_table;
 
+    /**
+     * @param str The NUL-terminated copy of the string, which is owned by
+     *   the table.
+     */
     intern_string(const char* str, ssize_t len)
-        : is_next(nullptr), is_str(str, (size_t) len)
+        : is_next(nullptr), is_str(string_fragment::from_bytes(str, len))
     {
     }
 
     intern_string* is_next;
-    std::string is_str;
+    string_fragment is_str;
 };
 
 using intern_table_lifetime = std::shared_ptr<intern_string::intern_table>;
@@ -29,12 +29,60 @@
 
 #include <cctype>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "intern_string.hh"
 
 #include "config.h"
 #include "doctest/doctest.h"
 
+TEST_CASE("intern_string::lookup")
+{
+    static constexpr int THREAD_COUNT = 8;
+    static constexpr int KEY_COUNT = 5000;
+    static constexpr int ROUNDS = 20;
+
+    std::vector<std::string> keys;
+    for (int lpc = 0; lpc < KEY_COUNT; lpc++) {
+        keys.emplace_back("intern-test-key-" + std::to_string(lpc));
+    }
+
+    std::vector<std::vector<const intern_string*>> results(THREAD_COUNT);
+    std::vector<std::thread> threads;
+
+    for (int tid = 0; tid < THREAD_COUNT; tid++) {
+        threads.emplace_back([tid, &keys, &results]() {
+            auto& res = results[tid];
+
+            res.resize(keys.size());
+            for (int round = 0; round < ROUNDS; round++) {
+                // Each thread walks the keys from a different starting
+                // point so that new strings are created concurrently.
+                for (size_t lpc = 0; lpc < keys.size(); lpc++) {
+                    auto index = (lpc + tid * keys.size() / THREAD_COUNT)
+                        % keys.size();
+
+                    res[index] = intern_string::lookup(keys[index]);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    for (size_t lpc = 0; lpc < keys.size(); lpc++) {
+        const auto* expected = intern_string::lookup(keys[lpc]);
+
+        CHECK(expected->to_string() == keys[lpc]);
+        CHECK(strcmp(expected->get(), keys[lpc].c_str()) == 0);
+        for (const auto& res : results) {
+            CHECK(res[lpc] == expected);
+        }
+    }
+}
+
 TEST_CASE("string_fragment::startswith")
 {
     std::string empty;
@@ -206,3 +254,25 @@ TEST_CASE("string_fragment::column_width")
         CHECK(1 == sf.column_width());
     }
 }
+
+TEST_CASE("string_fragment::next_word")
+{
+    const auto sf = string_fragment::from_const("hello, world foo_bar.baz");
+
+    CHECK(sf.next_word(0) == std::make_optional(7));
+    CHECK(sf.next_word(2) == std::make_optional(7));
+    CHECK(sf.next_word(7) == std::make_optional(13));
+    CHECK(sf.next_word(13) == std::make_optional(21));
+    CHECK(sf.next_word(21) == std::nullopt);
+}
+
+TEST_CASE("string_fragment::prev_word")
+{
+    const auto sf = string_fragment::from_const("hello, world foo_bar.baz");
+
+    CHECK(sf.prev_word(23) == std::make_optional(21));
+    CHECK(sf.prev_word(21) == std::make_optional(13));
+    CHECK(sf.prev_word(13) == std::make_optional(7));
+    CHECK(sf.prev_word(7) == std::make_optional(0));
+    CHECK(sf.prev_word(0) == std::nullopt);
+}
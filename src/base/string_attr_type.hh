@@ -357,7 +357,7 @@ public:
         {
             return std::make_pair(this, std::string(val));
         }
-        return std::make_pair(this, val);
+        return std::make_pair(this, std::forward<U>(val));
     }
 };
 
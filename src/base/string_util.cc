@@ -35,6 +35,10 @@
 
 #include "string_util.hh"
 
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
 #include "config.h"
 #include "is_utf8.hh"
 #include "lnav_log.hh"
@@ -484,3 +488,129 @@ quote(string_fragment str)
 }
 
 }  // namespace lnav::pcre2pp
+
+namespace {
+
+constexpr uint64_t
+broadcast_byte(unsigned char ch)
+{
+    return 0x0101010101010101ULL * ch;
+}
+
+constexpr uint64_t HIGH_BITS = broadcast_byte(0x80);
+
+/** Sets the high bit of every byte in the word that is zero. */
+constexpr uint64_t
+zero_bytes(uint64_t word)
+{
+    return (word - broadcast_byte(0x01)) & ~word & HIGH_BITS;
+}
+
+uint64_t
+load_word(const char* str)
+{
+    uint64_t retval;
+
+    memcpy(&retval, str, sizeof(retval));
+    return retval;
+}
+
+bool
+is_printable_ascii(unsigned char ch)
+{
+    return 0x20 <= ch && ch < 0x7f;
+}
+
+}  // namespace
+
+size_t
+printable_ascii_prefix(string_fragment sf)
+{
+    const auto* str = sf.data();
+    const size_t len = sf.length();
+    size_t index = 0;
+
+#if defined(__SSE2__)
+    const auto space_minus_one = _mm_set1_epi8(0x1f);
+    const auto del = _mm_set1_epi8(0x7f);
+
+    for (; index + sizeof(__m128i) <= len; index += sizeof(__m128i)) {
+        auto chunk = _mm_loadu_si128((const __m128i*) &str[index]);
+        // The comparison is signed, so bytes with the high bit set are
+        // treated as negative and fail the test along with the controls.
+        auto printable
+            = _mm_andnot_si128(_mm_cmpeq_epi8(chunk, del),
+                               _mm_cmpgt_epi8(chunk, space_minus_one));
+        auto mask = (unsigned) _mm_movemask_epi8(printable);
+
+        if (mask != 0xffff) {
+            return index + __builtin_ctz(~mask);
+        }
+    }
+#endif
+
+    for (; index + sizeof(uint64_t) <= len; index += sizeof(uint64_t)) {
+        auto word = load_word(&str[index]);
+        // Bytes with the high bit set, DEL, and anything less than a space.
+        auto special = (word & HIGH_BITS)
+            | zero_bytes(word ^ broadcast_byte(0x7f))
+            | ((word - broadcast_byte(0x20)) & ~word & HIGH_BITS);
+
+        if (special != 0) {
+            break;
+        }
+    }
+
+    while (index < len && is_printable_ascii(str[index])) {
+        index += 1;
+    }
+
+    return index;
+}
+
+bool
+has_ansi_escape_bytes(string_fragment sf)
+{
+    const auto* str = sf.data();
+    const size_t len = sf.length();
+    size_t index = 0;
+
+#if defined(__SSE2__)
+    const auto esc = _mm_set1_epi8('\x1b');
+    const auto bs = _mm_set1_epi8('\b');
+    const auto syn = _mm_set1_epi8('\x16');
+
+    for (; index + sizeof(__m128i) <= len; index += sizeof(__m128i)) {
+        auto chunk = _mm_loadu_si128((const __m128i*) &str[index]);
+        auto found = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, esc), _mm_cmpeq_epi8(chunk, bs)),
+            _mm_cmpeq_epi8(chunk, syn));
+
+        if (_mm_movemask_epi8(found) != 0) {
+            return true;
+        }
+    }
+#endif
+
+    for (; index + sizeof(uint64_t) <= len; index += sizeof(uint64_t)) {
+        auto word = load_word(&str[index]);
+
+        if (zero_bytes(word ^ broadcast_byte('\x1b'))
+            | zero_bytes(word ^ broadcast_byte('\b'))
+            | zero_bytes(word ^ broadcast_byte('\x16')))
+        {
+            return true;
+        }
+    }
+
+    for (; index < len; index++) {
+        switch (str[index]) {
+            case '\x1b':
+            case '\b':
+            case '\x16':
+                return true;
+        }
+    }
+
+    return false;
+}
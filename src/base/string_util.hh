@@ -207,6 +207,20 @@ utf8_string_length(const std::string& str)
     return utf8_string_length(str.c_str(), str.length());
 }
 
+/**
+ * @return The number of bytes at the start of the given string that are
+ *   printable ASCII characters.  Each of these characters is a single,
+ *   one-column wide codepoint, so callers can consume the run in bulk
+ *   instead of decoding it a character at a time.
+ */
+size_t printable_ascii_prefix(string_fragment sf);
+
+/**
+ * @return True if the string contains a byte that can start an ANSI escape
+ *   sequence or an overstrike, i.e. ESC, backspace, or SYN.
+ */
+bool has_ansi_escape_bytes(string_fragment sf);
+
 bool is_url(const std::string& fn);
 
 bool is_blank(const std::string& str);
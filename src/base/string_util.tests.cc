@@ -131,3 +131,30 @@ TEST_CASE("last_word_str")
         CHECK(s == "foo");
     }
 }
+
+TEST_CASE("printable_ascii_prefix")
+{
+    CHECK(printable_ascii_prefix(string_fragment::from_const("")) == 0);
+    CHECK(printable_ascii_prefix(string_fragment::from_const("abc")) == 3);
+    CHECK(printable_ascii_prefix(
+              string_fragment::from_const("0123456789abcdefghij\tklm"))
+          == 20);
+    CHECK(printable_ascii_prefix(
+              string_fragment::from_const("0123456789abcdefghijklmn\x7f"))
+          == 24);
+    CHECK(printable_ascii_prefix(string_fragment::from_const(
+              "0123456789abcdefghijklmnop\xe2\x96\xb6"))
+          == 26);
+}
+
+TEST_CASE("has_ansi_escape_bytes")
+{
+    CHECK_FALSE(has_ansi_escape_bytes(string_fragment::from_const("")));
+    CHECK_FALSE(has_ansi_escape_bytes(
+        string_fragment::from_const("0123456789abcdefghijklmnopqrstuvwxyz")));
+    CHECK(has_ansi_escape_bytes(
+        string_fragment::from_const("0123456789abcdefghijklmnopqrs\x1b[0m")));
+    CHECK(has_ansi_escape_bytes(string_fragment::from_const("a\bb")));
+    CHECK(has_ansi_escape_bytes(
+        string_fragment::from_const("0123456789abcdef\x16")));
+}
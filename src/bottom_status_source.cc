@@ -175,6 +175,58 @@ bottom_status_source::update_hits(textview_curses* tc)
 
 void
 bottom_status_source::update_loading(file_off_t off, file_ssize_t total)
+{
+    this->bss_foreground_loading = total > 0;
+    if (total == 0 && !this->bss_background_work.empty()) {
+        this->show_background_work();
+    } else {
+        this->show_loading(off, total);
+    }
+}
+
+void
+bottom_status_source::update_background_work(const std::string& source,
+                                             bool active,
+                                             size_t done,
+                                             size_t total)
+{
+    if (active) {
+        this->bss_background_work[source] = std::make_pair(done, total);
+    } else if (this->bss_background_work.erase(source) == 0) {
+        return;
+    }
+
+    if (!this->bss_foreground_loading) {
+        this->show_background_work();
+    }
+}
+
+void
+bottom_status_source::show_background_work()
+{
+    size_t done = 0;
+    size_t total = 0;
+    bool unknown = false;
+
+    for (const auto& pair : this->bss_background_work) {
+        if (pair.second.second == 0) {
+            unknown = true;
+        }
+        done += std::min(pair.second.first, pair.second.second);
+        total += pair.second.second;
+    }
+
+    if (this->bss_background_work.empty()) {
+        this->show_loading(0, 0);
+    } else if (unknown || total == 0) {
+        this->show_loading(1, 1);
+    } else {
+        this->show_loading(done, total);
+    }
+}
+
+void
+bottom_status_source::show_loading(file_off_t off, file_ssize_t total)
 {
     auto& sf = this->bss_fields[BSF_LOADING];
 
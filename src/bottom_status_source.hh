@@ -30,6 +30,7 @@
 #ifndef lnav_bottom_status_source_hh
 #define lnav_bottom_status_source_hh
 
+#include <map>
 #include <string>
 
 #include "grep_proc.hh"
@@ -81,7 +82,26 @@ public:
 
     void update_loading(file_off_t off, file_ssize_t total);
 
+    /**
+     * Report the state of the work that a source is doing in the
+     * background.  The loading indicator is only cleared once none of the
+     * sources have any work left.
+     *
+     * @param source The name of the source doing the work.
+     * @param active True if the source still has work in progress.
+     * @param done The amount of work that is done.
+     * @param total The total amount of work, or zero if it is not known.
+     */
+    void update_background_work(const std::string& source,
+                                bool active,
+                                size_t done,
+                                size_t total);
+
 private:
+    void show_loading(file_off_t off, file_ssize_t total);
+    void show_background_work();
+
+
     status_field bss_prompt{1024, role_t::VCR_STATUS};
     status_field bss_error{1024, role_t::VCR_ALERT_STATUS};
     status_field bss_line_error{1024, role_t::VCR_ALERT_STATUS};
@@ -89,6 +109,8 @@ private:
     int bss_hit_spinner{0};
     int bss_load_percent{0};
     bool bss_paused{false};
+    bool bss_foreground_loading{false};
+    std::map<std::string, std::pair<size_t, size_t>> bss_background_work;
 };
 
 #endif
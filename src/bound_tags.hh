@@ -40,6 +40,7 @@ enum {
     LNB_HEADLESS,
     LNB_MANAGEMENT,
     LNB_SECURE_MODE,
+    LNB_STREAMING,
 };
 
 /** Flags set on the lnav command-line. */
@@ -47,6 +48,7 @@ typedef enum {
     LNF_HEADLESS = (1L << LNB_HEADLESS),
     LNF_MANAGEMENT = (1L << LNB_MANAGEMENT),
     LNF_SECURE_MODE = (1L << LNB_SECURE_MODE),
+    LNF_STREAMING = (1L << LNB_STREAMING),
 } lnav_flags_t;
 
 struct lnav_flags_tag {};
@@ -66,6 +66,12 @@ const char* curl_url_strerror(CURLUcode error);
 }
 #endif
 
+/**
+ * The number of lines to collect before handing them to the anonymizer so
+ * that the work can be spread across threads.
+ */
+static constexpr size_t ANONYMIZE_BATCH_SIZE = 4096;
+
 static bool
 csv_needs_quoting(const std::string& str)
 {
@@ -593,6 +599,13 @@ com_save_to(exec_context& ec,
             std::vector<attr_line_t> rows(1);
             size_t count = 0;
             std::string line;
+            std::vector<std::string> anon_batch;
+            auto flush_anon_batch = [&anon_batch, &ta, outfile]() {
+                for (const auto& msg : ta.next_batch(anon_batch)) {
+                    fprintf(outfile, "%s\n", msg.c_str());
+                }
+                anon_batch.clear();
+            };
 
             for (auto iter = all_user_marks.begin();
                  iter != all_user_marks.end();
@@ -624,8 +637,11 @@ com_save_to(exec_context& ec,
                 }
                 auto sbr = read_res.unwrap();
                 if (anonymize) {
-                    auto msg = ta.next(sbr.to_string_fragment().to_string());
-                    fprintf(outfile, "%s\n", msg.c_str());
+                    anon_batch.emplace_back(
+                        sbr.to_string_fragment().to_string());
+                    if (anon_batch.size() >= ANONYMIZE_BATCH_SIZE) {
+                        flush_anon_batch();
+                    }
                 } else {
                     fprintf(
                         outfile, "%.*s\n", (int) sbr.length(), sbr.get_data());
@@ -633,6 +649,7 @@ com_save_to(exec_context& ec,
 
                 line_count += 1;
             }
+            flush_anon_batch();
         }
     } else if (args[0] == "write-view-to") {
         bool wrapped = tc->get_word_wrap();
@@ -640,6 +657,14 @@ com_save_to(exec_context& ec,
 
         tc->set_word_wrap(to_term);
 
+        std::vector<std::string> anon_batch;
+        auto flush_anon_batch = [&anon_batch, &ta, outfile]() {
+            for (const auto& line : ta.next_batch(anon_batch)) {
+                fprintf(outfile, "%s\n", line.c_str());
+            }
+            anon_batch.clear();
+        };
+
         for (size_t lpc = 0; lpc < tss->text_line_count(); lpc++) {
             if (ec.ec_dry_run && lpc >= 10) {
                 break;
@@ -649,12 +674,17 @@ com_save_to(exec_context& ec,
 
             tss->text_value_for_line(*tc, lpc, line, text_sub_source::RF_RAW);
             if (anonymize) {
-                line = ta.next(line);
+                anon_batch.emplace_back(std::move(line));
+                if (anon_batch.size() >= ANONYMIZE_BATCH_SIZE) {
+                    flush_anon_batch();
+                }
+            } else {
+                fprintf(outfile, "%s\n", line.c_str());
             }
-            fprintf(outfile, "%s\n", line.c_str());
 
             line_count += 1;
         }
+        flush_anon_batch();
 
         tc->set_word_wrap(wrapped);
     } else {
@@ -793,6 +823,7 @@ com_open(exec_context& ec, std::string cmdline, std::vector<std::string>& args)
     if (prov) {
         loo.with_filename(prov->fo_name);
     }
+    loo.with_remote_filter(tailer::remote_filter_from_log_view());
 
     for (auto fn : split_args) {
         file_location_t file_loc;
@@ -39,10 +39,12 @@ data_format data_parser::FORMAT_COMMA("comma", DT_INVALID, DT_COMMA);
 data_format data_parser::FORMAT_EMDASH("emdash", DT_INVALID, DT_EMDASH);
 data_format data_parser::FORMAT_PLAIN("plain", DT_INVALID, DT_INVALID);
 
-data_parser::data_parser(data_scanner* ds)
-    : dp_errors("dp_errors", __FILE__, __LINE__),
-      dp_pairs("dp_pairs", __FILE__, __LINE__), dp_msg_format(nullptr),
-      dp_msg_format_begin(ds->get_init_offset()), dp_scanner(ds)
+data_parser::data_parser(data_scanner* ds, element_arena* arena)
+    : dp_arena(arena != nullptr ? arena : &this->dp_local_arena),
+      dp_errors(this->dp_arena, "dp_errors", __FILE__, __LINE__),
+      dp_pairs(this->dp_arena, "dp_pairs", __FILE__, __LINE__),
+      dp_msg_format(nullptr), dp_msg_format_begin(ds->get_init_offset()),
+      dp_scanner(ds)
 {
     if (TRACE_FILE != nullptr) {
         fprintf(TRACE_FILE, "input %s\n", ds->get_input().to_string().c_str());
@@ -120,6 +122,7 @@ data_parser::pairup(data_parser::schema_id_t* schema,
                         if (!key_comps.empty()) {
                             key_comps.POP_FRONT();
                         }
+                        key_iter = key_comps.begin();
                         found = true;
                     } else if (key_iter->e_token
                                == in_list.el_format.df_terminator)
@@ -567,7 +570,9 @@ data_parser::discover_format()
 {
     std::stack<discover_format_state> state_stack;
     this->dp_group_token.push_back(DT_INVALID);
-    this->dp_group_stack.resize(1);
+    this->dp_group_stack.clear();
+    this->dp_group_stack.emplace_back(
+        this->dp_arena, "_root_", __FILE__, __LINE__);
 
     state_stack.push(discover_format_state());
     while (true) {
@@ -591,13 +596,15 @@ data_parser::discover_format()
             case DT_LCURLY:
             case DT_LSQUARE:
                 this->dp_group_token.push_back(elem.e_token);
-                this->dp_group_stack.emplace_back("_anon_", __FILE__, __LINE__);
+                this->dp_group_stack.emplace_back(
+                    this->dp_arena, "_anon_", __FILE__, __LINE__);
                 state_stack.push(discover_format_state());
                 break;
 
             case DT_EMPTY_CONTAINER: {
                 auto& curr_group = this->dp_group_stack.back();
-                auto empty_list = element_list_t("_anon_", __FILE__, __LINE__);
+                auto empty_list = element_list_t(
+                    this->dp_arena, "_anon_", __FILE__, __LINE__);
                 discover_format_state dfs;
 
                 dfs.finalize();
@@ -645,7 +652,8 @@ data_parser::discover_format()
                 break;
 
             case DT_UNIT: {
-                element_list_t measurement_list;
+                element_list_t measurement_list(
+                    this->dp_arena, "measurement_list", __FILE__, __LINE__);
 
                 measurement_list.SPLICE(
                     measurement_list.end(),
@@ -708,6 +716,7 @@ data_parser::end_of_value(data_parser::element_list_t& el_stack,
                 if (!key_comps.empty()) {
                     key_comps.POP_FRONT();
                 }
+                key_iter = key_comps.begin();
                 found = true;
             } else if (key_iter->e_token == in_list.el_format.df_terminator) {
                 value.SPLICE(
@@ -841,6 +850,7 @@ data_parser::end_of_value(data_parser::element_list_t& el_stack,
 
         if (el_stack.size() > 1 && in_list.el_format.df_appender != DT_INVALID
             && in_list.el_format.df_terminator != DT_INVALID
+            && iter != in_list.end()
             && iter->e_token == in_list.el_format.df_separator)
         {
             /* If we're expecting a terminator and haven't found it */
@@ -1183,41 +1193,15 @@ data_parser::element::element(data_parser::element_list_t& subs,
     }
 }
 
-data_parser::element::element(const data_parser::element& other)
-{
-    /* require(other.e_sub_elements == nullptr); */
-
-    this->e_capture = other.e_capture;
-    this->e_token = other.e_token;
-    this->e_sub_elements = nullptr;
-    if (other.e_sub_elements != nullptr) {
-        this->assign_elements(*other.e_sub_elements);
-    }
-}
-
-data_parser::element::~element()
-{
-    delete this->e_sub_elements;
-    this->e_sub_elements = nullptr;
-}
-
-data_parser::element&
-data_parser::element::operator=(const data_parser::element& other)
-{
-    this->e_capture = other.e_capture;
-    this->e_token = other.e_token;
-    this->e_sub_elements = nullptr;
-    if (other.e_sub_elements != nullptr) {
-        this->assign_elements(*other.e_sub_elements);
-    }
-    return *this;
-}
-
 void
 data_parser::element::assign_elements(data_parser::element_list_t& subs)
 {
     if (this->e_sub_elements == nullptr) {
-        this->e_sub_elements = new element_list_t("_sub_", __FILE__, __LINE__);
+        auto* arena = subs.get_arena();
+
+        require(arena != nullptr);
+
+        this->e_sub_elements = arena->create_list();
         this->e_sub_elements->el_format = subs.el_format;
     }
     this->e_sub_elements->SWAP(subs);
@@ -1425,5 +1409,89 @@ data_parser::element_list_t::push_back(const data_parser::element& elem,
     require(this->empty()
             || (elem.e_capture.c_begin == -1 && elem.e_capture.c_end == -1)
             || this->back().e_capture.c_end <= elem.e_capture.c_begin);
-    this->std::list<element>::push_back(elem);
+    this->el_storage.push_back(elem);
+}
+
+void
+data_parser::element_list_t::splice(iterator pos,
+                                    element_list_t& other,
+                                    iterator first,
+                                    iterator last,
+                                    const char* fn,
+                                    int line)
+{
+    SPLICE_TRACE;
+
+    require(&other != this);
+
+    auto count = std::distance(first, last);
+
+    if (count == 0) {
+        return;
+    }
+    if (pos == this->begin() && this->el_head >= (size_t) count) {
+        std::copy(first, last, pos - count);
+        this->el_head -= count;
+    } else {
+        this->el_storage.insert(pos, first, last);
+    }
+    other.erase(first, last);
+}
+
+void
+data_parser::element_list_t::erase(iterator first, iterator last)
+{
+    if (first == this->begin()) {
+        this->el_head += std::distance(first, last);
+    } else {
+        this->el_storage.erase(first, last);
+    }
+    if (this->empty()) {
+        this->clear();
+    }
+}
+
+void*
+data_parser::element_arena::allocate(size_t size, size_t align)
+{
+    if (size > LARGE_SIZE) {
+        this->ea_large.emplace_back(new char[size]);
+        return this->ea_large.back().get();
+    }
+
+    while (true) {
+        if (this->ea_block_index == this->ea_blocks.size()) {
+            this->ea_blocks.emplace_back(new char[BLOCK_SIZE]);
+            this->ea_offset = 0;
+        }
+
+        auto offset = (this->ea_offset + align - 1) & ~(align - 1);
+        if (offset + size <= BLOCK_SIZE) {
+            this->ea_offset = offset + size;
+            return this->ea_blocks[this->ea_block_index].get() + offset;
+        }
+        this->ea_block_index += 1;
+        this->ea_offset = 0;
+    }
+}
+
+static_assert(std::is_trivially_destructible<data_parser::element>::value,
+              "elements are not destroyed when an arena is reset");
+
+data_parser::element_list_t*
+data_parser::element_arena::create_list()
+{
+    auto* mem = this->allocate(sizeof(element_list_t), alignof(element_list_t));
+
+    // The destructor is never called since the list's storage also comes
+    // from this arena and elements are trivially destructible.
+    return new (mem) element_list_t(this, "_sub_", __FILE__, __LINE__);
+}
+
+void
+data_parser::element_arena::reset()
+{
+    this->ea_large.clear();
+    this->ea_block_index = 0;
+    this->ea_offset = 0;
 }
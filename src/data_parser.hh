@@ -30,8 +30,11 @@
 #ifndef data_parser_hh
 #define data_parser_hh
 
+#include <algorithm>
 #include <iterator>
 #include <list>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 #include <stdio.h>
@@ -40,7 +43,8 @@
 #include "byte_array.hh"
 #include "data_scanner.hh"
 
-#define ELEMENT_LIST_T(var) var("" #var, __FILE__, __LINE__, group_depth)
+#define ELEMENT_LIST_T(var) \
+    var(this->dp_arena, "" #var, __FILE__, __LINE__, group_depth)
 #define PUSH_FRONT(elem)    push_front(elem, __FILE__, __LINE__)
 #define PUSH_BACK(elem)     push_back(elem, __FILE__, __LINE__)
 #define POP_FRONT(elem)     pop_front(__FILE__, __LINE__)
@@ -216,14 +220,105 @@ public:
     typedef byte_array<2, uint64_t> schema_id_t;
 
     struct element;
-    /* typedef std::list<element> element_list_t; */
+    class element_list_t;
+
+    /**
+     * Bump allocator for the elements produced while parsing a line.  The
+     * sub-element lists and the storage for all the lists are carved out of
+     * blocks that are only released when the arena is reset or destroyed.
+     */
+    class element_arena {
+    public:
+        element_arena() = default;
+        element_arena(const element_arena&) = delete;
+        element_arena& operator=(const element_arena&) = delete;
+
+        void* allocate(size_t size, size_t align);
+
+        element_list_t* create_list();
+
+        /**
+         * Make all of the memory available for reuse.  Any elements that
+         * were allocated from this arena must no longer be in use.
+         */
+        void reset();
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 16 * 1024;
+        static constexpr size_t LARGE_SIZE = BLOCK_SIZE / 4;
+
+        std::vector<std::unique_ptr<char[]>> ea_blocks;
+        std::vector<std::unique_ptr<char[]>> ea_large;
+        size_t ea_block_index{0};
+        size_t ea_offset{0};
+    };
 
-    class element_list_t : public std::list<element> {
+    template<typename T>
+    struct arena_allocator {
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        arena_allocator(element_arena* arena = nullptr) noexcept
+            : aa_arena(arena)
+        {
+        }
+
+        template<typename U>
+        arena_allocator(const arena_allocator<U>& other) noexcept
+            : aa_arena(other.aa_arena)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            if (this->aa_arena == nullptr) {
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+            return static_cast<T*>(
+                this->aa_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, size_t n) noexcept
+        {
+            if (this->aa_arena == nullptr) {
+                ::operator delete(p);
+            }
+        }
+
+        template<typename U>
+        bool operator==(const arena_allocator<U>& other) const
+        {
+            return this->aa_arena == other.aa_arena;
+        }
+
+        template<typename U>
+        bool operator!=(const arena_allocator<U>& other) const
+        {
+            return this->aa_arena != other.aa_arena;
+        }
+
+        element_arena* aa_arena;
+    };
+
+    /**
+     * A list of elements stored contiguously.  Elements removed from the
+     * front are skipped over instead of shifting the rest of the storage.
+     */
+    class element_list_t {
     public:
-        element_list_t(const char* varname,
+        using storage_t = std::vector<element, arena_allocator<element>>;
+        using value_type = element;
+        using iterator = storage_t::iterator;
+        using const_iterator = storage_t::const_iterator;
+
+        element_list_t(element_arena* arena,
+                       const char* varname,
                        const char* fn,
                        int line,
                        int group_depth = -1)
+            : el_storage(arena)
         {
             LIST_INIT_TRACE;
         }
@@ -238,11 +333,15 @@ public:
             LIST_INIT_TRACE;
         }
 
-        element_list_t(const element_list_t& other) : std::list<element>(other)
+        element_list_t(const element_list_t& other)
+            : el_storage(
+                  other.begin(), other.end(), other.el_storage.get_allocator()),
+              el_format(other.el_format)
         {
-            this->el_format = other.el_format;
         }
 
+        element_list_t& operator=(const element_list_t& other) = default;
+
         ~element_list_t()
         {
             const char* fn = __FILE__;
@@ -251,12 +350,48 @@ public:
             LIST_DEINIT_TRACE;
         }
 
+        element_arena* get_arena() const
+        {
+            return this->el_storage.get_allocator().aa_arena;
+        }
+
+        iterator begin() { return this->el_storage.begin() + this->el_head; }
+
+        iterator end() { return this->el_storage.end(); }
+
+        const_iterator begin() const
+        {
+            return this->el_storage.begin() + this->el_head;
+        }
+
+        const_iterator end() const { return this->el_storage.end(); }
+
+        bool empty() const { return this->el_storage.size() == this->el_head; }
+
+        size_t size() const { return this->el_storage.size() - this->el_head; }
+
+        element& front() { return this->el_storage[this->el_head]; }
+
+        const element& front() const
+        {
+            return this->el_storage[this->el_head];
+        }
+
+        element& back() { return this->el_storage.back(); }
+
+        const element& back() const { return this->el_storage.back(); }
+
         void push_front(const element& elem, const char* fn, int line)
         {
             ELEMENT_TRACE;
 
             require(elem.e_capture.c_end >= -1);
-            this->std::list<element>::push_front(elem);
+            if (this->el_head > 0) {
+                this->el_head -= 1;
+                this->el_storage[this->el_head] = elem;
+            } else {
+                this->el_storage.insert(this->el_storage.begin(), elem);
+            }
         }
 
         void push_back(const element& elem, const char* fn, int line);
@@ -265,28 +400,41 @@ public:
         {
             LIST_TRACE;
 
-            this->std::list<element>::pop_front();
+            this->el_head += 1;
+            if (this->empty()) {
+                this->clear();
+            }
         }
 
         void pop_back(const char* fn, int line)
         {
             LIST_TRACE;
 
-            this->std::list<element>::pop_back();
+            this->el_storage.pop_back();
+            if (this->empty()) {
+                this->clear();
+            }
+        }
+
+        void clear()
+        {
+            this->el_storage.clear();
+            this->el_head = 0;
         }
 
         void clear2(const char* fn, int line)
         {
             LIST_TRACE;
 
-            this->std::list<element>::clear();
+            this->clear();
         }
 
         void swap(element_list_t& other, const char* fn, int line)
         {
             SWAP_TRACE(other);
 
-            this->std::list<element>::swap(other);
+            this->el_storage.swap(other.el_storage);
+            std::swap(this->el_head, other.el_head);
         }
 
         void splice(iterator pos,
@@ -294,13 +442,33 @@ public:
                     iterator first,
                     iterator last,
                     const char* fn,
-                    int line)
+                    int line);
+
+        template<typename UnaryPredicate>
+        void remove_if(UnaryPredicate p)
         {
-            SPLICE_TRACE;
+            this->el_storage.erase(
+                std::remove_if(this->begin(), this->end(), p), this->end());
+            if (this->empty()) {
+                this->clear();
+            }
+        }
 
-            this->std::list<element>::splice(pos, other, first, last);
+        void resize(size_t count)
+        {
+            this->el_storage.resize(this->el_head + count);
+            if (this->empty()) {
+                this->clear();
+            }
         }
 
+    private:
+        void erase(iterator first, iterator last);
+
+        storage_t el_storage;
+        size_t el_head{0};
+
+    public:
         data_format el_format;
     };
 
@@ -311,12 +479,6 @@ public:
                 data_token_t token,
                 bool assign_subs_elements = true);
 
-        element(const element& other);
-
-        ~element();
-
-        element& operator=(const element& other);
-
         void assign_elements(element_list_t& subs);
 
         void update_capture();
@@ -336,6 +498,10 @@ public:
         data_scanner::capture_t e_capture;
         data_token_t e_token;
 
+        /**
+         * The child elements, owned by the element_arena of the parse.
+         * Copies of an element share the same list.
+         */
         element_list_t* e_sub_elements;
     };
 
@@ -385,7 +551,7 @@ public:
         data_format dfs_format;
     };
 
-    data_parser(data_scanner* ds);
+    explicit data_parser(data_scanner* ds, element_arena* arena = nullptr);
 
     void pairup(schema_id_t* schema,
                 element_list_t& pairs_out,
@@ -411,6 +577,9 @@ public:
 
     void print(FILE* out, element_list_t& el);
 
+    element_arena dp_local_arena;
+    element_arena* dp_arena;
+
     std::vector<data_token_t> dp_group_token;
     std::list<element_list_t> dp_group_stack;
 
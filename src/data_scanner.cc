@@ -28,6 +28,9 @@
  */
 
 #include <algorithm>
+#include <limits>
+
+#include <string.h>
 
 #include "data_scanner.hh"
 
@@ -343,6 +346,82 @@ data_scanner::tokenize2(text_format_t tf)
     return retval;
 }
 
+void
+data_scanner::reset_input(string_fragment sf)
+{
+    this->ds_input = sf;
+    this->ds_init_offset = 0;
+    this->ds_next_offset = 0;
+    this->ds_bol = true;
+    this->ds_units = false;
+    this->ds_matching_brackets.clear();
+    this->ds_last_bracket_matched = false;
+    this->cleanup_end();
+}
+
+void
+data_scanner::shift_input(string_fragment sf, int dropped)
+{
+    this->ds_input = sf;
+    this->ds_init_offset = 0;
+    this->ds_next_offset -= dropped;
+    for (auto& tr : this->ds_matching_brackets) {
+        tr.tr_capture.c_begin -= dropped;
+        tr.tr_capture.c_end -= dropped;
+        tr.tr_inner_capture.c_begin -= dropped;
+        tr.tr_inner_capture.c_end -= dropped;
+        tr.tr_data = sf.data();
+    }
+    this->cleanup_end();
+}
+
+uint32_t
+data_scanner::tokenize_lines(std::string_view buffer,
+                             std::vector<batch_token>& tokens_out,
+                             uint32_t first_line,
+                             text_format_t tf)
+{
+    data_scanner ds(string_fragment{});
+    auto line_number = first_line;
+    size_t line_offset = 0;
+
+    while (line_offset < buffer.length()) {
+        auto eol = buffer.find('\n', line_offset);
+        auto line_end = eol == std::string_view::npos ? buffer.length() : eol;
+        auto line_len = line_end - line_offset;
+
+        // The scanner works on a string_fragment, which has 32-bit offsets.
+        if (line_len <= (size_t) std::numeric_limits<int>::max()) {
+            ds.reset_input(string_fragment::from_bytes(
+                buffer.data() + line_offset, line_len));
+            while (true) {
+                auto tok_res = ds.tokenize_int(tf);
+                if (!tok_res) {
+                    break;
+                }
+
+                const int64_t off = line_offset;
+                auto& tok = tokens_out.emplace_back();
+                tok.bt_token = tok_res->tr_token;
+                tok.bt_line = line_number;
+                tok.bt_capture.c_begin = off + tok_res->tr_capture.c_begin;
+                tok.bt_capture.c_end = off + tok_res->tr_capture.c_end;
+                tok.bt_inner_capture.c_begin
+                    = off + tok_res->tr_inner_capture.c_begin;
+                tok.bt_inner_capture.c_end
+                    = off + tok_res->tr_inner_capture.c_end;
+            }
+        }
+        line_number += 1;
+        if (eol == std::string_view::npos) {
+            break;
+        }
+        line_offset = eol + 1;
+    }
+
+    return line_number - first_line;
+}
+
 std::optional<data_scanner::tokenize_result>
 data_scanner::find_matching_bracket(text_format_t tf, tokenize_result tr)
 {
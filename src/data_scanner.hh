@@ -31,6 +31,8 @@
 #define data_scanner_hh
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "pcrepp/pcre2pp.hh"
 #include "shared_buffer.hh"
@@ -208,11 +210,50 @@ public:
     std::optional<tokenize_result> tokenize2(text_format_t tf
                                                 = text_format_t::TF_UNKNOWN);
 
+    struct batch_capture {
+        int64_t c_begin;
+        int64_t c_end;
+
+        int64_t length() const { return this->c_end - this->c_begin; }
+    };
+
+    struct batch_token {
+        data_token_t bt_token;
+        uint32_t bt_line;
+        batch_capture bt_capture;
+        batch_capture bt_inner_capture;
+    };
+
+    /**
+     * Tokenize every newline-separated line in the buffer, as if a separate
+     * scanner was created for each one, and append the tokens to the given
+     * vector.  The captures are 64-bit offsets into the buffer, so it can be
+     * larger than a string_fragment can hold.  A line that is 2GB or longer
+     * produces no tokens.  Line numbers start at first_line so that a large
+     * buffer can be split into ranges of lines that are tokenized
+     * independently.
+     *
+     * @return The number of lines that were tokenized.
+     */
+    static uint32_t tokenize_lines(std::string_view buffer,
+                                   std::vector<batch_token>& tokens_out,
+                                   uint32_t first_line = 0,
+                                   text_format_t tf
+                                   = text_format_t::TF_UNKNOWN);
+
     std::optional<tokenize_result> find_matching_bracket(text_format_t tf,
                                                             tokenize_result tr);
 
     void reset() { this->ds_next_offset = this->ds_init_offset; }
 
+    /**
+     * Continue scanning in a new buffer, for input that is read in windows.
+     * The new buffer must hold the old input, minus the first "dropped"
+     * bytes, followed by any newly read data.  The state left by the last
+     * token is kept so that scanning picks up where it left off.
+     */
+    void shift_input(string_fragment sf, int dropped);
+
     int get_init_offset() const { return this->ds_init_offset; }
 
     string_fragment get_input() const { return this->ds_input; }
@@ -225,6 +266,8 @@ public:
 private:
     void cleanup_end();
 
+    void reset_input(string_fragment sf);
+
     bool is_credit_card(string_fragment frag) const;
 
     std::optional<tokenize_result> tokenize_int(text_format_t tf
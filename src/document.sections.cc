@@ -430,8 +430,20 @@ public:
     {
         metadata_builder mb;
 
+        static constexpr size_t CANCEL_CHECK_INTERVAL = 4096;
+
+        const auto& is_cancelled = this->sw_discover_builder.db_is_cancelled;
+        size_t token_count = 0;
+
         mb.mb_text_format = this->sw_discover_builder.db_text_format;
         while (true) {
+            token_count += 1;
+            if (is_cancelled && token_count % CANCEL_CHECK_INTERVAL == 0
+                && is_cancelled())
+            {
+                break;
+            }
+
             auto tokenize_res = this->sw_scanner.tokenize2(
                 this->sw_discover_builder.db_text_format);
             if (!tokenize_res) {
@@ -30,6 +30,7 @@
 #ifndef lnav_attr_line_breadcrumbs_hh
 #define lnav_attr_line_breadcrumbs_hh
 
+#include <functional>
 #include <map>
 #include <set>
 #include <string>
@@ -156,12 +157,23 @@ struct discover_builder {
         return *this;
     }
 
+    /**
+     * @param func Called periodically during the walk, a true result stops
+     *   it early with the sections found so far.
+     */
+    discover_builder& with_cancel_check(std::function<bool()> func)
+    {
+        this->db_is_cancelled = std::move(func);
+        return *this;
+    }
+
     metadata perform();
 
     attr_line_t& db_line;
     line_range db_range{0, -1};
     text_format_t db_text_format{text_format_t::TF_UNKNOWN};
     bool db_save_words{false};
+    std::function<bool()> db_is_cancelled;
 };
 
 inline discover_builder
@@ -29,6 +29,7 @@
 
 #include "field_overlay_source.hh"
 
+#include "base/humanize.hh"
 #include "base/humanize.time.hh"
 #include "base/snippet_highlighters.hh"
 #include "command_executor.hh"
@@ -569,6 +570,27 @@ field_overlay_source::build_meta_line(const listview_curses& lv,
         }
     }
 
+    {
+        auto gap_file_and_line = this->fos_lss.find_line_with_file(row);
+
+        if (gap_file_and_line && !gap_file_and_line->second->is_continued()) {
+            auto elided = gap_file_and_line->first->remote_elided_before(
+                gap_file_and_line->second->get_offset());
+
+            if (elided > 0) {
+                dst.emplace_back(
+                    attr_line_t(" ")
+                        .append(lnav::roles::number(humanize::file_size(
+                            elided, humanize::alignment::none)))
+                        .append(" of the remote file was left out above "
+                                "this line by the tailer's filter")
+                        .with_attr_for_all(
+                            VC_ROLE.value(role_t::VCR_COMMENT))
+                        .move());
+            }
+        }
+    }
+
     if (!line_meta_opt) {
         return;
     }
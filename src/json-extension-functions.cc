@@ -51,6 +51,21 @@ class sql_json_op : public json_op {
 public:
     explicit sql_json_op(json_ptr& ptr) : json_op(ptr){};
 
+    void set_number(std::string_view num_sv)
+    {
+        auto scan_int_res = scn::scan_value<int64_t>(num_sv);
+
+        if (scan_int_res && scan_int_res->range().empty()) {
+            this->sjo_int = scan_int_res->value();
+            this->sjo_type = SQLITE_INTEGER;
+        } else {
+            auto scan_float_res = scn::scan_value<double>(num_sv);
+
+            this->sjo_float = scan_float_res->value();
+            this->sjo_type = SQLITE_FLOAT;
+        }
+    }
+
     int sjo_type{-1};
     std::string sjo_str;
     int64_t sjo_int{0};
@@ -109,6 +124,414 @@ contains_null(void* ctx)
     return 1;
 }
 
+namespace {
+
+/**
+ * A structural index of a parsed JSON document.  Scalars are stored in
+ * their decoded form and containers record their byte range in the
+ * source text, so a JSON-Pointer can be resolved by walking the nodes
+ * instead of re-parsing the document.
+ */
+struct json_tape {
+    enum class node_type : uint8_t {
+        null_value,
+        boolean,
+        number,
+        string,
+        map,
+        array,
+    };
+
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    struct node {
+        node_type n_type;
+        bool n_bool{false};
+        uint32_t n_next_sibling{NO_NODE};
+        uint32_t n_first_child{NO_NODE};
+        uint32_t n_child_count{0};
+        /** The map key and scalar value, as offsets into jt_strings. */
+        uint32_t n_key_offset{0};
+        uint32_t n_key_length{0};
+        uint32_t n_value_offset{0};
+        uint32_t n_value_length{0};
+        /** The byte range of a container in jt_text. */
+        uint32_t n_start{0};
+        uint32_t n_end{0};
+    };
+
+    string_fragment key_of(const node& n) const
+    {
+        return string_fragment::from_bytes(
+            this->jt_strings.data() + n.n_key_offset, n.n_key_length);
+    }
+
+    string_fragment value_of(const node& n) const
+    {
+        return string_fragment::from_bytes(
+            this->jt_strings.data() + n.n_value_offset, n.n_value_length);
+    }
+
+    bool build(string_fragment text);
+
+    enum class lookup_status {
+        found,
+        missing,
+        /** The pointer or document needs the full json_op semantics. */
+        unsupported,
+    };
+
+    lookup_status lookup(const char* ptr, uint32_t& node_out) const;
+
+    unsigned long jt_hash{0};
+    std::string jt_text;
+    std::string jt_strings;
+    std::vector<node> jt_nodes;
+};
+
+struct json_tape_builder {
+    json_tape& jtb_tape;
+    yajl_handle jtb_handle{nullptr};
+    std::vector<uint32_t> jtb_parents;
+    std::vector<uint32_t> jtb_last_child;
+    uint32_t jtb_key_offset{0};
+    uint32_t jtb_key_length{0};
+
+    uint32_t store(const void* str, size_t len)
+    {
+        auto retval = this->jtb_tape.jt_strings.size();
+
+        this->jtb_tape.jt_strings.append((const char*) str, len);
+        return retval;
+    }
+
+    json_tape::node& add(json_tape::node_type type)
+    {
+        auto& nodes = this->jtb_tape.jt_nodes;
+        uint32_t index = nodes.size();
+
+        nodes.emplace_back();
+        nodes.back().n_type = type;
+        if (!this->jtb_parents.empty()) {
+            auto& parent = nodes[this->jtb_parents.back()];
+
+            if (parent.n_type == json_tape::node_type::map) {
+                nodes.back().n_key_offset = this->jtb_key_offset;
+                nodes.back().n_key_length = this->jtb_key_length;
+            }
+            if (this->jtb_last_child.back() == json_tape::NO_NODE) {
+                parent.n_first_child = index;
+            } else {
+                nodes[this->jtb_last_child.back()].n_next_sibling = index;
+            }
+            parent.n_child_count += 1;
+            this->jtb_last_child.back() = index;
+        }
+
+        return nodes.back();
+    }
+
+    int start_container(json_tape::node_type type)
+    {
+        auto& n = this->add(type);
+
+        n.n_start = yajl_get_bytes_consumed(this->jtb_handle) - 1;
+        this->jtb_parents.push_back(this->jtb_tape.jt_nodes.size() - 1);
+        this->jtb_last_child.push_back(json_tape::NO_NODE);
+        return 1;
+    }
+
+    int end_container()
+    {
+        this->jtb_tape.jt_nodes[this->jtb_parents.back()].n_end
+            = yajl_get_bytes_consumed(this->jtb_handle);
+        this->jtb_parents.pop_back();
+        this->jtb_last_child.pop_back();
+        return 1;
+    }
+
+    static const yajl_callbacks callbacks;
+};
+
+const yajl_callbacks json_tape_builder::callbacks = {
+    +[](void* ctx) {
+        auto& jtb = *((json_tape_builder*) ctx);
+
+        jtb.add(json_tape::node_type::null_value);
+        return 1;
+    },
+    +[](void* ctx, int val) {
+        auto& jtb = *((json_tape_builder*) ctx);
+
+        jtb.add(json_tape::node_type::boolean).n_bool = val;
+        return 1;
+    },
+    nullptr,
+    nullptr,
+    +[](void* ctx, const char* val, size_t len) {
+        auto& jtb = *((json_tape_builder*) ctx);
+        auto offset = jtb.store(val, len);
+        auto& n = jtb.add(json_tape::node_type::number);
+
+        n.n_value_offset = offset;
+        n.n_value_length = len;
+        return 1;
+    },
+    +[](void* ctx,
+        const unsigned char* val,
+        size_t len,
+        yajl_string_props_t*) {
+        auto& jtb = *((json_tape_builder*) ctx);
+        auto offset = jtb.store(val, len);
+        auto& n = jtb.add(json_tape::node_type::string);
+
+        n.n_value_offset = offset;
+        n.n_value_length = len;
+        return 1;
+    },
+    +[](void* ctx) {
+        auto& jtb = *((json_tape_builder*) ctx);
+
+        return jtb.start_container(json_tape::node_type::map);
+    },
+    +[](void* ctx, const unsigned char* key, size_t len) {
+        auto& jtb = *((json_tape_builder*) ctx);
+
+        jtb.jtb_key_offset = jtb.store(key, len);
+        jtb.jtb_key_length = len;
+        return 1;
+    },
+    +[](void* ctx) {
+        auto& jtb = *((json_tape_builder*) ctx);
+
+        return jtb.end_container();
+    },
+    +[](void* ctx) {
+        auto& jtb = *((json_tape_builder*) ctx);
+
+        return jtb.start_container(json_tape::node_type::array);
+    },
+    +[](void* ctx) {
+        auto& jtb = *((json_tape_builder*) ctx);
+
+        return jtb.end_container();
+    },
+};
+
+bool
+json_tape::build(string_fragment text)
+{
+    json_tape_builder jtb{*this};
+
+    this->jt_text.assign(text.data(), text.length());
+    this->jt_strings.clear();
+    this->jt_nodes.clear();
+    if (text.length() >= UINT32_MAX) {
+        return false;
+    }
+
+    auto handle = yajlpp::alloc_handle(&json_tape_builder::callbacks, &jtb);
+    jtb.jtb_handle = handle.in();
+    if (yajl_parse(handle.in(), text.udata(), text.length()) != yajl_status_ok
+        || yajl_complete_parse(handle.in()) != yajl_status_ok)
+    {
+        return false;
+    }
+
+    return !this->jt_nodes.empty();
+}
+
+json_tape::lookup_status
+json_tape::lookup(const char* ptr, uint32_t& node_out) const
+{
+    // Only pointers made of plain, well-formed components are handled
+    // here, anything else is left to json_op so the odd cases behave
+    // exactly as they always have.
+    if (ptr[0] != '/') {
+        return lookup_status::unsupported;
+    }
+
+    std::string component;
+    uint32_t curr = 0;
+
+    while (ptr[0] == '/') {
+        ptr += 1;
+        component.clear();
+        while (ptr[0] != '\0' && ptr[0] != '/') {
+            if (ptr[0] == '~') {
+                switch (ptr[1]) {
+                    case '0':
+                        component.push_back('~');
+                        break;
+                    case '1':
+                        component.push_back('/');
+                        break;
+                    default:
+                        return lookup_status::unsupported;
+                }
+                ptr += 2;
+            } else {
+                component.push_back(ptr[0]);
+                ptr += 1;
+            }
+        }
+
+        const auto& n = this->jt_nodes[curr];
+        switch (n.n_type) {
+            case node_type::map: {
+                auto found = NO_NODE;
+
+                for (auto child = n.n_first_child; child != NO_NODE;
+                     child = this->jt_nodes[child].n_next_sibling)
+                {
+                    auto key = this->key_of(this->jt_nodes[child]);
+
+                    if (key.length() < (int) component.size()
+                        && memcmp(key.data(), component.data(), key.length())
+                            == 0)
+                    {
+                        // json_op matches keys by prefix, so a shorter
+                        // key can shadow the one being looked for.
+                        return lookup_status::unsupported;
+                    }
+                    if (key == component) {
+                        if (found != NO_NODE) {
+                            return lookup_status::unsupported;
+                        }
+                        found = child;
+                    }
+                }
+                if (found == NO_NODE) {
+                    return lookup_status::missing;
+                }
+                curr = found;
+                break;
+            }
+            case node_type::array: {
+                if (component.empty() || component.size() > 9
+                    || (component.size() > 1 && component[0] == '0'))
+                {
+                    return lookup_status::unsupported;
+                }
+
+                uint32_t index = 0;
+                for (auto ch : component) {
+                    if (!isdigit(ch)) {
+                        return lookup_status::unsupported;
+                    }
+                    index = index * 10 + (ch - '0');
+                }
+                if (index >= n.n_child_count) {
+                    return lookup_status::missing;
+                }
+
+                auto child = n.n_first_child;
+                for (; index > 0; index--) {
+                    child = this->jt_nodes[child].n_next_sibling;
+                }
+                curr = child;
+                break;
+            }
+            default:
+                return lookup_status::missing;
+        }
+    }
+
+    node_out = curr;
+    return lookup_status::found;
+}
+
+/**
+ * A cheap fingerprint of a document that only hashes its ends, since a
+ * full hash costs a noticeable fraction of a plain parse.  Matches are
+ * either confirmed by comparing the text or only decide when a tape is
+ * built, so collisions do not affect results.
+ */
+unsigned long
+json_fingerprint(string_fragment text)
+{
+    static constexpr int SAMPLE_SIZE = 32;
+
+    if (text.length() <= SAMPLE_SIZE * 2) {
+        return hash_str(text.data(), text.length());
+    }
+
+    char sample[SAMPLE_SIZE * 2];
+
+    memcpy(sample, text.data(), SAMPLE_SIZE);
+    memcpy(&sample[SAMPLE_SIZE],
+           text.data() + text.length() - SAMPLE_SIZE,
+           SAMPLE_SIZE);
+    return hash_str(sample, sizeof(sample));
+}
+
+/**
+ * A small per-thread cache of recently parsed documents.  Queries that
+ * call jget() several times on the same column value will find the
+ * document here.  Building a tape costs more than a single parse, so a
+ * tape is only built the second time a document is looked up.  Until
+ * then, nullptr is returned and the caller does a plain parse.
+ */
+const json_tape*
+lookup_json_tape(string_fragment text)
+{
+    static constexpr size_t CACHE_SIZE = 4;
+    static constexpr size_t MAX_CACHED_LENGTH = 1024 * 1024;
+
+    struct seen_doc {
+        unsigned long sd_hash{0};
+        size_t sd_length{0};
+    };
+
+    thread_local json_tape TAPES[CACHE_SIZE];
+    thread_local size_t next_slot = 0;
+    thread_local seen_doc SEEN[CACHE_SIZE];
+    thread_local size_t next_seen_slot = 0;
+
+    if (text.length() > MAX_CACHED_LENGTH) {
+        return nullptr;
+    }
+
+    auto h = json_fingerprint(text);
+    for (const auto& tape : TAPES) {
+        if (tape.jt_hash == h && !tape.jt_nodes.empty()
+            && tape.jt_text.size() == (size_t) text.length()
+            && memcmp(tape.jt_text.data(), text.data(), text.length()) == 0)
+        {
+            return &tape;
+        }
+    }
+
+    // Only the fingerprint and length are kept for a document that was
+    // seen once, a collision just means a tape is built a call early.
+    auto seen = false;
+    for (auto& sd : SEEN) {
+        if (sd.sd_hash == h && sd.sd_length == (size_t) text.length()) {
+            sd = seen_doc{};
+            seen = true;
+            break;
+        }
+    }
+    if (!seen) {
+        SEEN[next_seen_slot] = seen_doc{h, (size_t) text.length()};
+        next_seen_slot = (next_seen_slot + 1) % CACHE_SIZE;
+        return nullptr;
+    }
+
+    auto& tape = TAPES[next_slot];
+    next_slot = (next_slot + 1) % CACHE_SIZE;
+    tape.jt_hash = 0;
+    if (!tape.build(text)) {
+        tape.jt_nodes.clear();
+        return nullptr;
+    }
+    tape.jt_hash = h;
+
+    return &tape;
+}
+
+}  // namespace
+
 bool
 json_contains(vtab_types::nullable<const char> nullable_json_in,
               sqlite3_value* value)
@@ -120,6 +543,88 @@ json_contains(vtab_types::nullable<const char> nullable_json_in,
     }
 
     const auto* json_in = nullable_json_in.n_value;
+    const auto* tape = lookup_json_tape(string_fragment::from_c_str(json_in));
+
+    if (tape != nullptr) {
+        auto value_type = sqlite3_value_type(value);
+        auto retval = false;
+        auto needs_parse = false;
+
+        if (value_type == SQLITE_NULL) {
+            for (const auto& n : tape->jt_nodes) {
+                if (n.n_type == json_tape::node_type::null_value) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (value_type == SQLITE_INTEGER) {
+            // Out-of-range integers anywhere in the document are a parse
+            // error for yajl, so let the full parse below report them.
+            for (const auto& n : tape->jt_nodes) {
+                if (n.n_type != json_tape::node_type::number) {
+                    continue;
+                }
+
+                auto num = tape->value_of(n);
+                if (num.find('.') || num.find('e') || num.find('E')) {
+                    continue;
+                }
+                auto scan_res = scn::scan_value<int64_t>(num.to_string_view());
+                if (!scan_res || !scan_res->range().empty()) {
+                    needs_parse = true;
+                    break;
+                }
+            }
+        }
+
+        auto check = [&](const json_tape::node& n) {
+            switch (value_type) {
+                case SQLITE3_TEXT:
+                    if (n.n_type == json_tape::node_type::string
+                        && tape->value_of(n)
+                            == string_fragment::from_bytes(
+                                sqlite3_value_text(value),
+                                sqlite3_value_bytes(value)))
+                    {
+                        retval = true;
+                    }
+                    break;
+                case SQLITE_INTEGER: {
+                    if (n.n_type != json_tape::node_type::number) {
+                        break;
+                    }
+                    auto num = tape->value_of(n);
+                    if (num.find('.') || num.find('e') || num.find('E')) {
+                        break;
+                    }
+                    auto scan_res
+                        = scn::scan_value<int64_t>(num.to_string_view());
+                    if (scan_res->value() == sqlite3_value_int64(value)) {
+                        retval = true;
+                    }
+                    break;
+                }
+            }
+        };
+
+        if (!needs_parse) {
+            const auto& root = tape->jt_nodes[0];
+
+            if (root.n_type == json_tape::node_type::array) {
+                for (auto child = root.n_first_child;
+                     child != json_tape::NO_NODE && !retval;
+                     child = tape->jt_nodes[child].n_next_sibling)
+                {
+                    check(tape->jt_nodes[child]);
+                }
+            } else {
+                check(root);
+            }
+            return retval;
+        }
+    }
 
     yajl_callbacks cb{};
     contains_userdata cu;
@@ -233,18 +738,7 @@ gen_handle_number(void* ctx, const char* numval, size_t numlen)
     yajl_gen gen = (yajl_gen) sjo->jo_ptr_data;
 
     if (sjo->jo_ptr.jp_state == json_ptr::match_state_t::DONE) {
-        auto num_sv = std::string_view{numval, numlen};
-        auto scan_int_res = scn::scan_value<int64_t>(num_sv);
-
-        if (scan_int_res && scan_int_res->range().empty()) {
-            sjo->sjo_int = scan_int_res->value();
-            sjo->sjo_type = SQLITE_INTEGER;
-        } else {
-            auto scan_float_res = scn::scan_value<double>(num_sv);
-
-            sjo->sjo_float = scan_float_res->value();
-            sjo->sjo_type = SQLITE_FLOAT;
-        }
+        sjo->set_number(std::string_view{numval, numlen});
     } else {
         sjo->jo_ptr_error_code = yajl_gen_number(gen, numval, numlen);
     }
@@ -252,27 +746,34 @@ gen_handle_number(void* ctx, const char* numval, size_t numlen)
     return sjo->jo_ptr_error_code == yajl_gen_status_ok;
 }
 
-static void
-sql_jget(sqlite3_context* context, int argc, sqlite3_value** argv)
+static bool
+sql_jget_scalar_result(sqlite3_context* context, const sql_json_op& jo)
 {
-    if (argc < 2) {
-        sqlite3_result_error(context, "expecting JSON value and pointer", -1);
-        return;
-    }
-
-    if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
-        null_or_default(context, argc, argv);
-        return;
+    switch (jo.sjo_type) {
+        case SQLITE3_TEXT:
+            to_sqlite(context, jo.sjo_str);
+            return true;
+        case SQLITE_NULL:
+            sqlite3_result_null(context);
+            return true;
+        case SQLITE_INTEGER:
+            sqlite3_result_int(context, jo.sjo_int);
+            return true;
+        case SQLITE_FLOAT:
+            sqlite3_result_double(context, jo.sjo_float);
+            return true;
     }
 
-    const auto json_in = from_sqlite<string_fragment>()(argc, argv, 0);
-
-    if (sqlite3_value_type(argv[1]) == SQLITE_NULL) {
-        sqlite3_result_text(context, json_in.data(), -1, SQLITE_TRANSIENT);
-        return;
-    }
+    return false;
+}
 
-    const char* ptr_in = (const char*) sqlite3_value_text(argv[1]);
+static void
+sql_jget_parse(sqlite3_context* context,
+               int argc,
+               sqlite3_value** argv,
+               string_fragment json_in,
+               const char* ptr_in)
+{
     json_ptr jp(ptr_in);
     sql_json_op jo(jp);
     unsigned char* err;
@@ -340,19 +841,8 @@ sql_jget(sqlite3_context* context, int argc, sqlite3_value** argv)
             break;
     }
 
-    switch (jo.sjo_type) {
-        case SQLITE3_TEXT:
-            to_sqlite(context, jo.sjo_str);
-            return;
-        case SQLITE_NULL:
-            sqlite3_result_null(context);
-            return;
-        case SQLITE_INTEGER:
-            sqlite3_result_int(context, jo.sjo_int);
-            return;
-        case SQLITE_FLOAT:
-            sqlite3_result_double(context, jo.sjo_float);
-            return;
+    if (sql_jget_scalar_result(context, jo)) {
+        return;
     }
 
     const auto result = gen.to_string_fragment();
@@ -369,6 +859,80 @@ sql_jget(sqlite3_context* context, int argc, sqlite3_value** argv)
 #endif
 }
 
+static void
+sql_jget(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+    if (argc < 2) {
+        sqlite3_result_error(context, "expecting JSON value and pointer", -1);
+        return;
+    }
+
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+        null_or_default(context, argc, argv);
+        return;
+    }
+
+    const auto json_in = from_sqlite<string_fragment>()(argc, argv, 0);
+
+    if (sqlite3_value_type(argv[1]) == SQLITE_NULL) {
+        sqlite3_result_text(context, json_in.data(), -1, SQLITE_TRANSIENT);
+        return;
+    }
+
+    const char* ptr_in = (const char*) sqlite3_value_text(argv[1]);
+    const auto* tape = ptr_in[0] == '/' ? lookup_json_tape(json_in) : nullptr;
+    uint32_t node_index;
+
+    if (tape == nullptr) {
+        sql_jget_parse(context, argc, argv, json_in, ptr_in);
+        return;
+    }
+
+    switch (tape->lookup(ptr_in, node_index)) {
+        case json_tape::lookup_status::missing:
+            null_or_default(context, argc, argv);
+            return;
+        case json_tape::lookup_status::unsupported:
+            sql_jget_parse(context, argc, argv, json_in, ptr_in);
+            return;
+        case json_tape::lookup_status::found:
+            break;
+    }
+
+    const auto& n = tape->jt_nodes[node_index];
+    json_ptr jp("");
+    sql_json_op jo(jp);
+
+    switch (n.n_type) {
+        case json_tape::node_type::null_value:
+            jo.sjo_type = SQLITE_NULL;
+            break;
+        case json_tape::node_type::boolean:
+            jo.sjo_type = SQLITE_INTEGER;
+            jo.sjo_int = n.n_bool;
+            break;
+        case json_tape::node_type::number:
+            jo.set_number(tape->value_of(n).to_string_view());
+            break;
+        case json_tape::node_type::string:
+            jo.sjo_type = SQLITE3_TEXT;
+            jo.sjo_str = tape->value_of(n).to_string();
+            break;
+        case json_tape::node_type::map:
+        case json_tape::node_type::array: {
+            // Re-generate the container from its slice of the document
+            // so the output is formatted exactly as json_op would.
+            auto slice = string_fragment::from_bytes(
+                tape->jt_text.data() + n.n_start, n.n_end - n.n_start);
+
+            sql_jget_parse(context, argc, argv, slice, "");
+            return;
+        }
+    }
+
+    sql_jget_scalar_result(context, jo);
+}
+
 struct concat_context {
     concat_context(yajl_gen gen_handle) : cc_gen_handle(gen_handle) {}
 
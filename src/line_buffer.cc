@@ -41,8 +41,16 @@
 #    include <bzlib.h>
 #endif
 
+#ifdef HAVE_ZSTD_H
+#    include <zstd.h>
+#endif
+
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <set>
+#include <thread>
 
 #include "base/auto_mem.hh"
 #include "base/auto_pid.hh"
@@ -85,53 +93,271 @@ force_linking(io_looper_tag anno)
 }
 }  // namespace injector
 
-/*
- * XXX REMOVE ME
- *
- * The stock bzipped file code does not use pread, so we need to use a lock to
- * get exclusive access to the file.  In the future, we should just rewrite
- * the bzipped file code to use pread.
- */
-class lock_hack {
-public:
-    class guard {
-    public:
-        guard() : g_lock(singleton()) { this->g_lock.lock(); }
+#define Z_BUFSIZE       65536U
+#define SYNCPOINT_SIZE  (1024 * 1024)
+#define GZ_TRAILER_SIZE 8U
+#define GZ_CHUNK_SIZE   (4 * 1024 * 1024)
+#define GZ_SLICE_SIZE   (1024 * 1024)
+#define GZ_MAX_BUFFERED (8 * 1024 * 1024)
 
-        ~guard() { this->g_lock.unlock(); }
+/**
+ * Check if the given offset looks like the start of a gzip member.  This
+ * can give false positives, so the member boundary needs to be confirmed
+ * by decoding the previous member.
+ */
+static bool
+is_gzip_member_start(const unsigned char* hdr)
+{
+    return hdr[0] == 0x1f && hdr[1] == 0x8b && hdr[2] == Z_DEFLATED
+        && (hdr[3] & 0xe0) == 0 && (hdr[8] == 0 || hdr[8] == 2 || hdr[8] == 4)
+        && (hdr[9] <= 13 || hdr[9] == 255);
+}
 
-    private:
-        lock_hack& g_lock;
+/**
+ * Decodes the members of a multi-member gzip file (e.g. BGZF or
+ * concatenated rotations) on background threads.  The pipeline is only
+ * started once the serial reader has reached the end of the first member
+ * and found another one after it.  Each worker starts at a member header,
+ * decodes whole members until it has consumed at least GZ_CHUNK_SIZE
+ * bytes, and records syncpoints along the way.  The output is handed to
+ * the reader in order with a bounded amount buffered.
+ */
+struct line_buffer::gz_indexed::member_pipeline {
+    struct chunk {
+        explicit chunk(off_t start) : c_in_start(start) {}
+
+        const off_t c_in_start;
+        std::mutex c_mutex;
+        std::condition_variable c_cond;
+        std::deque<std::vector<char>> c_slices;
+        size_t c_slice_offset{0};
+        size_t c_buffered{0};
+        off_t c_consumed{0};
+        off_t c_in_end{-1};
+        off_t c_out_size{0};
+        bool c_done{false};
+        bool c_error{false};
+        bool c_cancel{false};
+        std::vector<indexDict> c_syncpoints;
     };
 
-    static lock_hack& singleton()
+    member_pipeline(int fd, off_t file_size, off_t in_start, off_t out_start)
+        : mp_fd(fd), mp_file_size(file_size),
+          mp_max_workers(std::clamp(std::thread::hardware_concurrency(),
+                                    2U,
+                                    4U)),
+          mp_out_offset(out_start), mp_in_offset(in_start),
+          mp_next_start(in_start)
     {
-        static lock_hack retval;
+    }
 
-        return retval;
+    ~member_pipeline() { this->cancel_all(); }
+
+    void cancel_all()
+    {
+        for (auto& ch : this->mp_chunks) {
+            std::lock_guard<std::mutex> lg(ch->c_mutex);
+
+            ch->c_cancel = true;
+            ch->c_cond.notify_all();
+        }
+        for (auto& fut : this->mp_futures) {
+            fut.wait();
+        }
+        this->mp_chunks.clear();
+        this->mp_futures.clear();
     }
 
-    void lock() { lockf(this->lh_fd, F_LOCK, 0); }
+    bool is_member_start(off_t off) const
+    {
+        unsigned char hdr[10];
+
+        return pread(this->mp_fd, hdr, sizeof(hdr), off) == sizeof(hdr)
+            && is_gzip_member_start(hdr);
+    }
 
-    void unlock() { lockf(this->lh_fd, F_ULOCK, 0); }
+    std::optional<off_t> find_member(off_t start) const
+    {
+        unsigned char buf[64 * 1024];
+        auto off = start;
 
-private:
-    lock_hack()
+        while (off < start + GZ_CHUNK_SIZE && off < this->mp_file_size) {
+            auto rc = pread(this->mp_fd, buf, sizeof(buf), off);
+            if (rc < 10) {
+                break;
+            }
+
+            const auto* curr = buf;
+            const auto* end = buf + rc - 9;
+            while ((curr = static_cast<const unsigned char*>(
+                        memchr(curr, 0x1f, end - curr)))
+                   != nullptr)
+            {
+                if (is_gzip_member_start(curr)) {
+                    return off + (curr - buf);
+                }
+                curr += 1;
+            }
+            off += rc - 9;
+        }
+
+        return std::nullopt;
+    }
+
+    void launch(off_t start)
     {
-        char lockname[64];
+        auto ch = std::make_shared<chunk>(start);
 
-        snprintf(lockname, sizeof(lockname), "/tmp/lnav.%d.lck", getpid());
-        this->lh_fd = open(lockname, O_CREAT | O_RDWR, 0600);
-        log_perror(fcntl(this->lh_fd, F_SETFD, FD_CLOEXEC));
-        unlink(lockname);
+        this->mp_futures.emplace_back(std::async(
+            std::launch::async, decode, this->mp_fd, this->mp_file_size, ch));
+        this->mp_chunks.emplace_back(ch);
+        this->mp_next_start = this->find_member(start + GZ_CHUNK_SIZE);
     }
 
-    auto_fd lh_fd;
+    static void decode(int fd, off_t file_size, std::shared_ptr<chunk> ch);
+
+    int mp_fd;
+    off_t mp_file_size;
+    size_t mp_max_workers;
+    off_t mp_out_offset;
+    off_t mp_in_offset;
+    std::optional<off_t> mp_next_start;
+    std::deque<std::shared_ptr<chunk>> mp_chunks;
+    std::deque<std::future<void>> mp_futures;
+    bool mp_failed{false};
 };
-/* XXX END */
 
-#define Z_BUFSIZE      65536U
-#define SYNCPOINT_SIZE (1024 * 1024)
+void
+line_buffer::gz_indexed::member_pipeline::decode(int fd,
+                                                 off_t file_size,
+                                                 std::shared_ptr<chunk> ch)
+{
+    auto inbuf = auto_mem<Bytef>::malloc(Z_BUFSIZE);
+    z_stream strm{};
+    std::vector<char> slice(GZ_SLICE_SIZE);
+    auto last_sync = ch->c_in_start;
+    auto error = inbuf == nullptr
+        || inflateInit2(&strm, GZ_HEADER_MODE) != Z_OK;
+
+    auto publish = [&strm, &slice, &ch](bool wait) {
+        auto produced = slice.size() - strm.avail_out;
+        std::unique_lock<std::mutex> lock(ch->c_mutex);
+
+        if (produced > 0) {
+            slice.resize(produced);
+            ch->c_buffered += produced;
+            ch->c_out_size += produced;
+            ch->c_slices.emplace_back(std::move(slice));
+            ch->c_cond.notify_all();
+        }
+        if (wait) {
+            ch->c_cond.wait(lock, [&ch]() {
+                return ch->c_buffered < GZ_MAX_BUFFERED || ch->c_cancel;
+            });
+        }
+        slice = std::vector<char>(GZ_SLICE_SIZE);
+        strm.next_out = (Bytef*) slice.data();
+        strm.avail_out = slice.size();
+    };
+
+    strm.total_in = ch->c_in_start;
+    strm.next_out = (Bytef*) slice.data();
+    strm.avail_out = slice.size();
+    while (!error) {
+        if (strm.avail_in == 0) {
+            auto rc = pread(fd, inbuf.in(), Z_BUFSIZE, strm.total_in);
+            if (rc <= 0) {
+                error = true;
+                break;
+            }
+            strm.next_in = inbuf;
+            strm.avail_in = rc;
+        }
+
+        auto err = inflate(&strm, Z_BLOCK);
+        if (err == Z_STREAM_END) {
+            off_t in_end = strm.total_in;
+            unsigned char hdr[10];
+
+            if (in_end - ch->c_in_start >= GZ_CHUNK_SIZE
+                || in_end >= file_size
+                || pread(fd, hdr, sizeof(hdr), in_end) != sizeof(hdr)
+                || !is_gzip_member_start(hdr))
+            {
+                break;
+            }
+
+            // Move on to the next member in this chunk.
+            auto total_out = strm.total_out;
+            auto avail_in = strm.avail_in;
+            auto* next_in = strm.next_in;
+            inflateReset(&strm);
+            strm.total_in = in_end;
+            strm.total_out = total_out;
+            strm.avail_in = avail_in;
+            strm.next_in = next_in;
+            continue;
+        }
+        if (err != Z_OK) {
+            log_error("%d: inflate-error in member at %lld: %d  %s",
+                      fd,
+                      (long long) ch->c_in_start,
+                      (int) err,
+                      strm.msg ? strm.msg : "");
+            error = true;
+            break;
+        }
+
+        auto produced = slice.size() - strm.avail_out;
+        if ((off_t) strm.total_in >= last_sync + SYNCPOINT_SIZE
+            && produced >= GZ_WINSIZE
+            && (strm.data_type & GZ_END_OF_BLOCK_MASK)
+            && !(strm.data_type & GZ_END_OF_FILE_MASK))
+        {
+            std::lock_guard<std::mutex> lg(ch->c_mutex);
+
+            ch->c_syncpoints.emplace_back(strm, slice.size());
+            last_sync = strm.total_in;
+        }
+        if (strm.avail_out == 0) {
+            publish(true);
+            std::lock_guard<std::mutex> lg(ch->c_mutex);
+            if (ch->c_cancel) {
+                break;
+            }
+        }
+    }
+    publish(false);
+    inflateEnd(&strm);
+
+    std::lock_guard<std::mutex> lg(ch->c_mutex);
+    ch->c_in_end = strm.total_in;
+    ch->c_error = error;
+    ch->c_done = true;
+    ch->c_cond.notify_all();
+}
+
+static std::filesystem::path
+gz_index_cache_path()
+{
+    return lnav::paths::workdir() / "gz-index";
+}
+
+/*
+ * The saved index is the magic number followed by one entry for each
+ * syncpoint.  The windows are compressed since they are mostly text.
+ */
+static constexpr char GZ_INDEX_MAGIC[8]
+    = {'l', 'n', 'g', 'z', 'i', 'd', 'x', '1'};
+
+struct gz_index_entry {
+    uint64_t ie_in;
+    uint64_t ie_out;
+    uint8_t ie_bits;
+    uint8_t ie_in_bits;
+    uint32_t ie_window_size;
+} __attribute__((__packed__));
+
 line_buffer::gz_indexed::gz_indexed()
 {
     if ((this->inbuf = auto_mem<Bytef>::malloc(Z_BUFSIZE)) == nullptr) {
@@ -144,11 +370,197 @@ line_buffer::gz_indexed::close()
 {
     // Release old stream, if we were open
     if (*this) {
+        this->gz_pipeline.reset();
+        this->save_index();
         inflateEnd(&this->strm);
         ::close(this->gz_fd);
         this->syncpoints.clear();
         this->gz_fd = -1;
+        this->gz_index_path = std::nullopt;
+        this->gz_saved_syncpoints = 0;
+        this->gz_index_size = 0;
+        this->gz_file_size = 0;
+    }
+}
+
+void
+line_buffer::gz_indexed::load_index()
+{
+    unsigned char head[64 * 1024];
+    struct stat st;
+
+    if (fstat(this->gz_fd, &st) == -1) {
+        return;
+    }
+    auto head_size = pread(this->gz_fd, head, sizeof(head), 0);
+    if (head_size <= 0) {
+        return;
+    }
+
+    auto index_id = hasher()
+                        .update(st.st_dev)
+                        .update(st.st_ino)
+                        .update(st.st_size)
+                        .update(st.st_mtime)
+                        .update((const char*) head, head_size)
+                        .to_string();
+    this->gz_index_path = gz_index_cache_path() / index_id.substr(0, 2)
+        / fmt::format(FMT_STRING("{}.idx"), index_id);
+
+    auto open_res
+        = lnav::filesystem::open_file(this->gz_index_path.value(), O_RDONLY);
+    if (open_res.isErr()) {
+        return;
+    }
+
+    auto index_fd = open_res.unwrap();
+    char magic[sizeof(GZ_INDEX_MAGIC)];
+
+    if (::read(index_fd, magic, sizeof(magic)) != sizeof(magic)
+        || memcmp(magic, GZ_INDEX_MAGIC, sizeof(magic)) != 0)
+    {
+        return;
+    }
+
+    auto zbuf = auto_mem<Bytef>::malloc(compressBound(GZ_WINSIZE));
+    off_t valid_size = sizeof(magic);
+    gz_index_entry entry;
+
+    if (zbuf == nullptr) {
+        throw std::bad_alloc();
+    }
+    while (::read(index_fd, &entry, sizeof(entry)) == sizeof(entry)) {
+        if (entry.ie_window_size > compressBound(GZ_WINSIZE)
+            || entry.ie_bits > GZ_BORROW_BITS_MASK
+            || (off_t) entry.ie_in >= st.st_size
+            || (!this->syncpoints.empty()
+                && (off_t) entry.ie_in <= this->syncpoints.back().in))
+        {
+            break;
+        }
+        if (::read(index_fd, zbuf.in(), entry.ie_window_size)
+            != entry.ie_window_size)
+        {
+            break;
+        }
+
+        indexDict dict;
+        uLongf window_size = GZ_WINSIZE;
+
+        if (uncompress(
+                dict.index, &window_size, zbuf.in(), entry.ie_window_size)
+                != Z_OK
+            || window_size != GZ_WINSIZE)
+        {
+            break;
+        }
+        dict.in = entry.ie_in;
+        dict.out = entry.ie_out;
+        dict.bits = entry.ie_bits;
+        dict.in_bits = entry.ie_in_bits;
+        this->syncpoints.emplace_back(dict);
+        valid_size += sizeof(entry) + entry.ie_window_size;
+    }
+    this->gz_index_size = valid_size;
+    this->gz_saved_syncpoints = this->syncpoints.size();
+
+    std::error_code ec;
+    std::filesystem::last_write_time(
+        this->gz_index_path.value(),
+        std::filesystem::file_time_type::clock::now(),
+        ec);
+    log_info("%d: loaded %zu gzip syncpoints from %s",
+             this->gz_fd,
+             this->syncpoints.size(),
+             this->gz_index_path->c_str());
+}
+
+void
+line_buffer::gz_indexed::save_index()
+{
+    if (!this->gz_index_path
+        || this->syncpoints.size() <= this->gz_saved_syncpoints)
+    {
+        return;
+    }
+
+    try {
+        std::filesystem::create_directories(
+            this->gz_index_path->parent_path());
+
+        auto fl = lnav::filesystem::file_lock(this->gz_index_path.value());
+        auto guard = lnav::filesystem::file_lock::guard(&fl);
+        auto create_res = lnav::filesystem::create_file(
+            this->gz_index_path.value(), O_WRONLY | O_CLOEXEC, 0600);
+        if (create_res.isErr()) {
+            log_error("unable to save gzip index: %s",
+                      create_res.unwrapErr().c_str());
+            return;
+        }
+
+        auto index_fd = create_res.unwrap();
+        auto zbuf_size = compressBound(GZ_WINSIZE);
+        auto zbuf = auto_mem<Bytef>::malloc(zbuf_size);
+        std::string out;
+
+        if (zbuf == nullptr) {
+            throw std::bad_alloc();
+        }
+        if (this->gz_index_size == 0) {
+            out.append(GZ_INDEX_MAGIC, sizeof(GZ_INDEX_MAGIC));
+        }
+        for (auto lpc = this->gz_saved_syncpoints;
+             lpc < this->syncpoints.size();
+             lpc++)
+        {
+            const auto& dict = this->syncpoints[lpc];
+            uLongf zlen = zbuf_size;
+
+            if (compress2(zbuf.in(), &zlen, dict.index, GZ_WINSIZE, 1)
+                != Z_OK)
+            {
+                break;
+            }
+
+            gz_index_entry entry;
+            entry.ie_in = dict.in;
+            entry.ie_out = dict.out;
+            entry.ie_bits = dict.bits;
+            entry.ie_in_bits = dict.in_bits;
+            entry.ie_window_size = zlen;
+            out.append((const char*) &entry, sizeof(entry));
+            out.append((const char*) zbuf.in(), zlen);
+        }
+
+        if (ftruncate(index_fd, this->gz_index_size) == -1
+            || pwrite(index_fd, out.data(), out.size(), this->gz_index_size)
+                != (ssize_t) out.size())
+        {
+            log_error("unable to write gzip index: %s -- %s",
+                      this->gz_index_path->c_str(),
+                      strerror(errno));
+            return;
+        }
+        this->gz_index_size += out.size();
+        this->gz_saved_syncpoints = this->syncpoints.size();
+    } catch (const std::exception& e) {
+        log_error("unable to save gzip index: %s", e.what());
+    }
+}
+
+uLong
+line_buffer::gz_indexed::get_source_offset() const
+{
+    if (!*this) {
+        return 0;
     }
+
+    uLong retval = this->strm.total_in + this->strm.avail_in;
+    if (this->gz_pipeline) {
+        retval = std::max(retval, (uLong) this->gz_pipeline->mp_in_offset);
+    }
+
+    return retval;
 }
 
 void
@@ -161,6 +573,7 @@ line_buffer::gz_indexed::init_stream()
     // initialize inflate struct
     int rc = inflateInit2(&this->strm, GZ_HEADER_MODE);
     this->strm.avail_in = 0;
+    this->gz_raw_stream = false;
     if (rc != Z_OK) {
         throw(rc);  // FIXME: exception wrapper
     }
@@ -247,122 +660,1321 @@ line_buffer::gz_indexed::open(int fd, lnav::gzip::header& hd)
                     log_error("%d: failed to read gzip header data", fd);
                     break;
             }
-        } else {
-            log_error("%d: failed to read gzip header from file: %s",
-                      fd,
-                      strerror(errno));
+        } else {
+            log_error("%d: failed to read gzip header from file: %s",
+                      fd,
+                      strerror(errno));
+        }
+    } else {
+        log_error("%d: unable to get gzip header", fd);
+    }
+
+    this->load_index();
+
+    struct stat st;
+    if (std::thread::hardware_concurrency() > 1 && fstat(fd, &st) == 0
+        && st.st_size >= 2 * GZ_CHUNK_SIZE)
+    {
+        this->gz_file_size = st.st_size;
+    }
+}
+
+bool
+line_buffer::gz_indexed::start_pipeline()
+{
+    auto in_start = (off_t) this->strm.total_in;
+    unsigned char hdr[10];
+
+    if (this->gz_pipeline || this->gz_file_size == 0
+        || this->gz_file_size - in_start < GZ_CHUNK_SIZE
+        || pread(this->gz_fd, hdr, sizeof(hdr), in_start) != sizeof(hdr)
+        || !is_gzip_member_start(hdr))
+    {
+        return false;
+    }
+
+    log_info("%d: found gzip member at %lld, decoding in parallel",
+             this->gz_fd,
+             (long long) in_start);
+    this->gz_pipeline = std::make_shared<member_pipeline>(
+        this->gz_fd, this->gz_file_size, in_start, this->strm.total_out);
+    return true;
+}
+
+int
+line_buffer::gz_indexed::stream_data(void* buf, size_t size)
+{
+    this->strm.avail_out = size;
+    this->strm.next_out = (unsigned char*) buf;
+
+    size_t last = this->syncpoints.empty() ? 0 : this->syncpoints.back().in;
+    while (this->strm.avail_out) {
+        if (!this->strm.avail_in) {
+            int rc = ::pread(
+                this->gz_fd, &this->inbuf[0], Z_BUFSIZE, this->strm.total_in);
+            if (rc < 0) {
+                return rc;
+            }
+            this->strm.next_in = this->inbuf;
+            this->strm.avail_in = rc;
+        }
+        if (this->strm.avail_in) {
+            int flush = last > this->strm.total_in ? Z_SYNC_FLUSH : Z_BLOCK;
+            auto err = inflate(&this->strm, flush);
+            if (err == Z_STREAM_END) {
+                if (this->gz_raw_stream) {
+                    // A raw stream that was resumed from a syncpoint stops
+                    // before the member's trailer, so skip over it.
+                    auto skip = std::min(this->strm.avail_in, GZ_TRAILER_SIZE);
+
+                    this->strm.next_in += skip;
+                    this->strm.avail_in -= skip;
+                    this->strm.total_in += GZ_TRAILER_SIZE;
+                }
+                // Reached end of stream; re-init for a possible subsequent
+                // stream
+                continue_stream();
+                if (this->start_pipeline()) {
+                    // The rest of the file is read through the pipeline.
+                    break;
+                }
+            } else if (err != Z_OK) {
+                log_error(" inflate-error at %d: %d  %s",
+                          this->strm.total_in,
+                          (int) err,
+                          this->strm.msg ? this->strm.msg : "");
+                break;
+            }
+
+            if (this->strm.total_in >= last + SYNCPOINT_SIZE
+                && size > this->strm.avail_out + GZ_WINSIZE
+                && (this->strm.data_type & GZ_END_OF_BLOCK_MASK)
+                && !(this->strm.data_type & GZ_END_OF_FILE_MASK))
+            {
+                this->syncpoints.emplace_back(this->strm, size);
+                last = this->strm.total_out;
+            }
+        } else if (this->strm.avail_out) {
+            // Processed all the gz file data but didn't fill
+            // the output buffer.  We're done, even though we
+            // produced fewer bytes than requested.
+            break;
+        }
+    }
+    return size - this->strm.avail_out;
+}
+
+void
+line_buffer::gz_indexed::seek(off_t offset)
+{
+    if ((size_t) offset == this->strm.total_out) {
+        return;
+    }
+
+    indexDict* dict = nullptr;
+    // Find highest syncpoint not past offset
+    auto sync_iter = std::upper_bound(
+        this->syncpoints.begin(),
+        this->syncpoints.end(),
+        offset,
+        [](off_t off, const indexDict& d) { return off < d.out; });
+    if (sync_iter != this->syncpoints.begin()) {
+        dict = &*std::prev(sync_iter);
+    }
+
+    // Choose highest available syncpoint, or keep current offset if it's ok
+    if ((size_t) offset < this->strm.total_out
+        || (dict && this->strm.total_out < (size_t) dict->out))
+    {
+        // Release the old z_stream
+        inflateEnd(&this->strm);
+        if (dict) {
+            dict->apply(&this->strm);
+            this->gz_raw_stream = true;
+        } else {
+            init_stream();
+        }
+    }
+
+    // Stream from compressed file until we reach our offset
+    unsigned char dummy[Z_BUFSIZE];
+    while ((size_t) offset > this->strm.total_out) {
+        size_t to_copy
+            = std::min(static_cast<size_t>(Z_BUFSIZE),
+                       static_cast<size_t>(offset - this->strm.total_out));
+        auto total_in = this->strm.total_in;
+        auto bytes = stream_data(dummy, to_copy);
+        if (bytes < 0 || (bytes == 0 && this->strm.total_in == total_in)) {
+            break;
+        }
+    }
+}
+
+void
+line_buffer::gz_indexed::add_syncpoints(std::vector<indexDict>& syncpoints,
+                                        off_t base)
+{
+    for (auto& sp : syncpoints) {
+        sp.out += base;
+        if (this->syncpoints.empty() || sp.in > this->syncpoints.back().in) {
+            this->syncpoints.emplace_back(std::move(sp));
+        }
+    }
+}
+
+int
+line_buffer::gz_indexed::read_ahead(void* buf, size_t offset, size_t size)
+{
+    auto& mp = *this->gz_pipeline;
+    auto* dst = static_cast<char*>(buf);
+    size_t retval = 0;
+
+    require(offset == (size_t) mp.mp_out_offset);
+
+    while (retval < size) {
+        while (mp.mp_next_start && mp.mp_chunks.size() < mp.mp_max_workers) {
+            mp.launch(mp.mp_next_start.value());
+        }
+        if (mp.mp_chunks.empty()) {
+            break;
+        }
+
+        auto ch = mp.mp_chunks.front();
+        std::unique_lock<std::mutex> lock(ch->c_mutex);
+
+        ch->c_cond.wait(
+            lock, [&ch]() { return !ch->c_slices.empty() || ch->c_done; });
+        // Publish the syncpoints as they are found so that seeks back
+        // into a large member do not have to wait for it to finish.
+        this->add_syncpoints(ch->c_syncpoints,
+                             mp.mp_out_offset - ch->c_consumed);
+        ch->c_syncpoints.clear();
+        if (!ch->c_slices.empty()) {
+            auto& slice = ch->c_slices.front();
+            auto count
+                = std::min(size - retval, slice.size() - ch->c_slice_offset);
+
+            memcpy(&dst[retval], &slice[ch->c_slice_offset], count);
+            retval += count;
+            mp.mp_out_offset += count;
+            ch->c_consumed += count;
+            ch->c_slice_offset += count;
+            if (ch->c_slice_offset == slice.size()) {
+                ch->c_buffered -= slice.size();
+                ch->c_slices.pop_front();
+                ch->c_slice_offset = 0;
+                ch->c_cond.notify_all();
+            }
+            continue;
+        }
+        lock.unlock();
+
+        mp.mp_futures.front().wait();
+        mp.mp_futures.pop_front();
+        mp.mp_chunks.pop_front();
+        if (ch->c_error) {
+            log_error("%d: falling back to serial inflate at %lld",
+                      this->gz_fd,
+                      (long long) mp.mp_out_offset);
+            mp.cancel_all();
+            mp.mp_next_start = std::nullopt;
+            mp.mp_failed = true;
+            break;
+        }
+
+        mp.mp_in_offset = ch->c_in_end;
+        if (!mp.mp_chunks.empty()
+            && mp.mp_chunks.front()->c_in_start != ch->c_in_end)
+        {
+            // The next chunk started at a false member header.
+            mp.cancel_all();
+        }
+        if (mp.mp_chunks.empty()) {
+            if (ch->c_in_end < mp.mp_file_size
+                && mp.is_member_start(ch->c_in_end))
+            {
+                mp.mp_next_start = ch->c_in_end;
+            } else {
+                mp.mp_next_start = std::nullopt;
+            }
+        }
+    }
+
+    return retval;
+}
+
+int
+line_buffer::gz_indexed::read(void* buf, size_t offset, size_t size)
+{
+    int retval = 0;
+
+    while (true) {
+        if (this->gz_pipeline
+            && offset == (size_t) this->gz_pipeline->mp_out_offset)
+        {
+            auto bytes = this->read_ahead(buf, offset, size);
+            if (!this->gz_pipeline->mp_failed) {
+                if ((size_t) bytes < size) {
+                    this->save_index();
+                }
+                return retval + bytes;
+            }
+            // Stay on the serial path for the rest of the file.
+            this->gz_pipeline.reset();
+            this->gz_file_size = 0;
+            buf = static_cast<char*>(buf) + bytes;
+            offset += bytes;
+            size -= bytes;
+            retval += bytes;
+        }
+
+        if (offset != this->strm.total_out) {
+            // log_debug("doing seek!  %d %d", offset, this->strm.total_out);
+            this->seek(offset);
+        }
+
+        int bytes = stream_data(buf, size);
+        if (bytes < 0) {
+            return retval > 0 ? retval : bytes;
+        }
+        buf = static_cast<char*>(buf) + bytes;
+        offset += bytes;
+        size -= bytes;
+        retval += bytes;
+        if (size == 0) {
+            break;
+        }
+        if (!this->gz_pipeline
+            || offset != (size_t) this->gz_pipeline->mp_out_offset)
+        {
+            // Reached the end of the file, so the index is as complete as
+            // it is going to get.
+            this->save_index();
+            break;
+        }
+    }
+
+    return retval;
+}
+
+#define BZ_SCAN_SIZE (1024 * 1024)
+#define BZ_MAX_CACHED_BLOCKS 16
+
+/*
+ * Every bzip2 block starts with this 48-bit magic number and the stream
+ * ends with the second one.  Neither is byte-aligned.
+ */
+static constexpr uint64_t BZ_BLOCK_MAGIC = 0x314159265359ULL;
+static constexpr uint64_t BZ_EOS_MAGIC = 0x177245385090ULL;
+static constexpr uint64_t BZ_MAGIC_MASK = 0xffffffffffffULL;
+
+/*
+ * The largest block is 900k before compression, so a segment that is much
+ * larger than that after trying to merge it with its neighbor is garbage.
+ */
+static constexpr uint64_t BZ_MAX_SEGMENT_BITS = 8ULL * 1024 * 1024 * 8;
+
+void
+line_buffer::bz_indexed::close()
+{
+    if (*this) {
+        ::close(this->bz_fd);
+        this->bz_fd = -1;
+    }
+    this->bz_blocks.clear();
+    this->bz_scan_offset = 0;
+    this->bz_scan_bits = 0;
+    this->bz_scan_valid = 0;
+    this->bz_open_block = std::nullopt;
+    this->bz_scan_failed = false;
+    this->bz_source_offset = 0;
+    this->bz_cache.clear();
+}
+
+void
+line_buffer::bz_indexed::open(int fd)
+{
+    this->close();
+    this->bz_fd = fd;
+}
+
+#ifdef HAVE_BZLIB_H
+namespace {
+
+class bit_writer {
+public:
+    explicit bit_writer(std::vector<char>& out) : bw_out(out) {}
+
+    void put(uint32_t value, int count)
+    {
+        this->bw_bits = (this->bw_bits << count)
+            | (value & ((uint64_t{1} << count) - 1));
+        this->bw_count += count;
+        while (this->bw_count >= 8) {
+            this->bw_count -= 8;
+            this->bw_out.push_back((char) (this->bw_bits >> this->bw_count));
+        }
+    }
+
+    void flush()
+    {
+        if (this->bw_count > 0) {
+            this->bw_out.push_back(
+                (char) (this->bw_bits << (8 - this->bw_count)));
+            this->bw_count = 0;
+        }
+    }
+
+private:
+    std::vector<char>& bw_out;
+    uint64_t bw_bits{0};
+    int bw_count{0};
+};
+
+uint32_t
+get_bits(const unsigned char* src, uint64_t bit_offset, int count)
+{
+    uint32_t retval = 0;
+
+    for (int lpc = 0; lpc < count; lpc++) {
+        auto bit = bit_offset + lpc;
+
+        retval = (retval << 1) | ((src[bit / 8] >> (7 - bit % 8)) & 1);
+    }
+
+    return retval;
+}
+
+}  // namespace
+
+bool
+line_buffer::bz_indexed::scan_segments(std::vector<segment>& segments_out,
+                                       size_t max_segments)
+{
+    auto_mem<unsigned char> inbuf;
+
+    if ((inbuf = auto_mem<unsigned char>::malloc(BZ_SCAN_SIZE)) == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    while (segments_out.size() < max_segments) {
+        auto rc = pread(
+            this->bz_fd, inbuf.in(), BZ_SCAN_SIZE, this->bz_scan_offset);
+        if (rc <= 0) {
+            return !segments_out.empty();
+        }
+
+        for (ssize_t lpc = 0; lpc < rc; lpc++) {
+            this->bz_scan_bits = (this->bz_scan_bits << 8) | inbuf[lpc];
+            this->bz_scan_valid += 8;
+            if (this->bz_scan_valid < 48) {
+                continue;
+            }
+
+            uint64_t end_bit = (this->bz_scan_offset + lpc + 1) * 8;
+            for (int shift = 7; shift >= 0; shift--) {
+                if (this->bz_scan_valid < 48 + (uint64_t) shift) {
+                    continue;
+                }
+
+                auto word = (this->bz_scan_bits >> shift) & BZ_MAGIC_MASK;
+                if (word != BZ_BLOCK_MAGIC && word != BZ_EOS_MAGIC) {
+                    continue;
+                }
+
+                auto magic_bit = end_bit - shift - 48;
+                if (this->bz_open_block) {
+                    segments_out.emplace_back(
+                        segment{this->bz_open_block.value(), magic_bit});
+                }
+                if (word == BZ_BLOCK_MAGIC) {
+                    this->bz_open_block = magic_bit;
+                } else {
+                    this->bz_open_block = std::nullopt;
+                }
+            }
+        }
+        this->bz_scan_offset += rc;
+    }
+
+    return true;
+}
+
+bool
+line_buffer::bz_indexed::decompress(const segment& seg,
+                                    std::vector<char>& out) const
+{
+    auto byte_start = seg.s_bit_start / 8;
+    auto byte_end = (seg.s_bit_end + 7) / 8;
+    auto_mem<unsigned char> inbuf;
+
+    if ((inbuf = auto_mem<unsigned char>::malloc(byte_end - byte_start))
+        == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    auto rc = pread(this->bz_fd, inbuf.in(), byte_end - byte_start, byte_start);
+    if (rc != (ssize_t) (byte_end - byte_start)) {
+        return false;
+    }
+
+    /*
+     * Turn the block into a stream of its own by prepending a stream header
+     * and appending the end-of-stream marker.  The stream CRC for a single
+     * block is the CRC of that block, which follows the block magic.
+     */
+    std::vector<char> stream;
+    auto bit = seg.s_bit_start % 8;
+    auto remaining = seg.s_bit_end - seg.s_bit_start;
+    size_t in_index = 0;
+
+    stream.reserve(byte_end - byte_start + 16);
+    stream.insert(stream.end(), {'B', 'Z', 'h', '9'});
+
+    bit_writer bw(stream);
+    if (bit > 0) {
+        auto count = std::min(8 - bit, remaining);
+
+        bw.put(inbuf[0] >> (8 - bit - count), count);
+        remaining -= count;
+        in_index = 1;
+    }
+    while (remaining >= 8) {
+        bw.put(inbuf[in_index++], 8);
+        remaining -= 8;
+    }
+    if (remaining > 0) {
+        bw.put(inbuf[in_index] >> (8 - remaining), remaining);
+    }
+    bw.put(BZ_EOS_MAGIC >> 32, 16);
+    bw.put((uint32_t) BZ_EOS_MAGIC, 32);
+    bw.put(get_bits(inbuf.in(), bit + 48, 32), 32);
+    bw.flush();
+
+    bz_stream strm{};
+    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+        return false;
+    }
+
+    int err;
+    size_t out_size = 0;
+
+    out.resize(1024 * 1024);
+    strm.next_in = stream.data();
+    strm.avail_in = stream.size();
+    do {
+        if (out_size == out.size()) {
+            out.resize(out.size() * 2);
+        }
+        strm.next_out = out.data() + out_size;
+        strm.avail_out = out.size() - out_size;
+        err = BZ2_bzDecompress(&strm);
+        out_size = out.size() - strm.avail_out;
+    } while (err == BZ_OK && (strm.avail_in > 0 || strm.avail_out == 0));
+    BZ2_bzDecompressEnd(&strm);
+    out.resize(out_size);
+
+    return err == BZ_STREAM_END;
+}
+
+bool
+line_buffer::bz_indexed::index_more()
+{
+    if (this->bz_scan_failed) {
+        return false;
+    }
+
+    static const size_t BATCH_SIZE = std::clamp(
+        (size_t) std::thread::hardware_concurrency(), size_t{2}, size_t{8});
+
+    std::vector<segment> segments;
+    if (!this->scan_segments(segments, BATCH_SIZE)) {
+        return false;
+    }
+
+    /* The blocks are independent, so decompress them in parallel. */
+    std::vector<std::future<std::optional<std::vector<char>>>> futures;
+    for (const auto& seg : segments) {
+        futures.emplace_back(std::async(
+            std::launch::async,
+            [this, seg]() -> std::optional<std::vector<char>> {
+                std::vector<char> data;
+
+                if (!this->decompress(seg, data)) {
+                    return std::nullopt;
+                }
+                return std::move(data);
+            }));
+    }
+
+    for (size_t lpc = 0; lpc < segments.size(); lpc++) {
+        auto data = futures[lpc].get();
+
+        if (!data) {
+            /*
+             * The magic number can show up by chance in the compressed
+             * data.  So, ignore this boundary and retry with the block
+             * extended to the next one.
+             */
+            auto seg = segments[lpc];
+
+            for (lpc += 1; lpc < futures.size(); lpc++) {
+                futures[lpc].wait();
+            }
+            if (seg.s_bit_end - seg.s_bit_start > BZ_MAX_SEGMENT_BITS) {
+                log_error("%d: unable to decompress bzip2 block at bit %llu",
+                          this->bz_fd,
+                          (unsigned long long) seg.s_bit_start);
+                this->bz_scan_failed = true;
+                return !this->bz_blocks.empty();
+            }
+            this->bz_open_block = seg.s_bit_start;
+            this->bz_scan_offset = seg.s_bit_end / 8 + 1;
+            this->bz_scan_bits = 0;
+            this->bz_scan_valid = 0;
+            return true;
+        }
+
+        file_off_t out_offset = 0;
+        if (!this->bz_blocks.empty()) {
+            const auto& last = this->bz_blocks.back();
+
+            out_offset = last.b_out_offset + last.b_out_size;
+        }
+        this->bz_blocks.emplace_back(block{
+            segments[lpc].s_bit_start,
+            segments[lpc].s_bit_end,
+            out_offset,
+            data->size(),
+        });
+        this->cache_block(this->bz_blocks.size() - 1, std::move(*data));
+    }
+
+    return true;
+}
+
+const std::vector<char>*
+line_buffer::bz_indexed::block_data(size_t index)
+{
+    for (const auto& entry : this->bz_cache) {
+        if (entry.first == index) {
+            return &entry.second;
+        }
+    }
+
+    const auto& blk = this->bz_blocks[index];
+    std::vector<char> data;
+
+    if (!this->decompress(segment{blk.b_bit_start, blk.b_bit_end}, data)) {
+        return nullptr;
+    }
+    this->cache_block(index, std::move(data));
+
+    return &this->bz_cache.back().second;
+}
+
+void
+line_buffer::bz_indexed::cache_block(size_t index, std::vector<char>&& data)
+{
+    if (this->bz_cache.size() >= BZ_MAX_CACHED_BLOCKS) {
+        this->bz_cache.erase(this->bz_cache.begin());
+    }
+    this->bz_cache.emplace_back(index, std::move(data));
+}
+
+ssize_t
+line_buffer::bz_indexed::read(void* buf, size_t offset, size_t size)
+{
+    auto* dst = static_cast<char*>(buf);
+    size_t retval = 0;
+
+    while (retval < size) {
+        auto want = (file_off_t) (offset + retval);
+
+        while (this->bz_blocks.empty()
+               || want >= this->bz_blocks.back().b_out_offset
+                       + (file_off_t) this->bz_blocks.back().b_out_size)
+        {
+            if (!this->index_more()) {
+                return retval;
+            }
+        }
+
+        auto iter = std::upper_bound(
+            this->bz_blocks.begin(),
+            this->bz_blocks.end(),
+            want,
+            [](file_off_t off, const block& blk) {
+                return off < blk.b_out_offset;
+            });
+        auto index = std::distance(this->bz_blocks.begin(), iter) - 1;
+        const auto& blk = this->bz_blocks[index];
+        const auto* data = this->block_data(index);
+
+        if (data == nullptr) {
+            errno = EIO;
+            return -1;
+        }
+
+        auto block_off = want - blk.b_out_offset;
+        auto count = std::min(size - retval, data->size() - block_off);
+
+        memcpy(&dst[retval], data->data() + block_off, count);
+        retval += count;
+        this->bz_source_offset = blk.b_bit_end / 8;
+    }
+
+    return retval;
+}
+#endif
+
+void
+line_buffer::zstd_indexed::close()
+{
+    this->zs_stream.reset();
+    if (*this) {
+        ::close(this->zs_fd);
+        this->zs_fd = -1;
+    }
+    this->zs_file_size = 0;
+    this->zs_frames.clear();
+    this->zs_scan_offset = 0;
+    this->zs_scan_done = false;
+    this->zs_source_offset = 0;
+    this->zs_cache.clear();
+    this->zs_cache_size = 0;
+}
+
+void
+line_buffer::zstd_indexed::open(int fd)
+{
+    struct stat st;
+
+    this->close();
+    this->zs_fd = fd;
+    if (fstat(fd, &st) == 0) {
+        this->zs_file_size = st.st_size;
+    }
+#ifdef HAVE_ZSTD_H
+    if (this->load_seek_table()) {
+        log_info("%d: loaded zstd seek table with %zu frames",
+                 this->zs_fd,
+                 this->zs_frames.size());
+    }
+#endif
+}
+
+#ifdef HAVE_ZSTD_H
+#define ZSTD_MAX_CACHED_FRAME_SIZE (4 * 1024 * 1024)
+#define ZSTD_MAX_CACHE_SIZE (32 * 1024 * 1024)
+#define ZSTD_MAX_FRAME_HEADER_SIZE 18
+
+static constexpr uint32_t ZSTD_FRAME_MAGIC = 0xFD2FB528U;
+static constexpr uint32_t ZSTD_SKIPPABLE_MAGIC = 0x184D2A50U;
+static constexpr uint32_t ZSTD_SKIPPABLE_MASK = 0xFFFFFFF0U;
+
+/*
+ * The seek table of the seekable format is a skippable frame at the end
+ * of the file that ends with this footer.
+ */
+static constexpr uint32_t ZSTD_SEEK_TABLE_MAGIC = 0x184D2A5EU;
+static constexpr uint32_t ZSTD_SEEKABLE_MAGIC = 0x8F92EAB1U;
+static constexpr size_t ZSTD_SEEK_TABLE_FOOTER_SIZE = 9;
+
+static uint32_t
+read_le32(const unsigned char* src)
+{
+    return (uint32_t) src[0] | ((uint32_t) src[1] << 8)
+        | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+}
+
+struct line_buffer::zstd_indexed::stream_state {
+    stream_state() : ss_dctx(ZSTD_createDCtx())
+    {
+        if (this->ss_dctx == nullptr) {
+            throw std::bad_alloc();
+        }
+        this->ss_inbuf.resize(ZSTD_DStreamInSize());
+    }
+
+    ~stream_state() { ZSTD_freeDCtx(this->ss_dctx); }
+
+    ZSTD_DCtx* ss_dctx;
+    std::vector<char> ss_inbuf;
+    ZSTD_inBuffer ss_in{nullptr, 0, 0};
+    size_t ss_frame{0};
+    file_off_t ss_in_offset{0}; /*< Next byte of the file to decompress. */
+    file_off_t ss_out_offset{0}; /*< Offset of the next byte produced. */
+};
+
+bool
+line_buffer::zstd_indexed::frame::is_cacheable() const
+{
+    return this->f_out_size
+        && this->f_out_size.value() <= ZSTD_MAX_CACHED_FRAME_SIZE;
+}
+
+bool
+line_buffer::zstd_indexed::load_seek_table()
+{
+    unsigned char footer[ZSTD_SEEK_TABLE_FOOTER_SIZE];
+
+    if (this->zs_file_size < (file_off_t) (8 + sizeof(footer))) {
+        return false;
+    }
+    if (pread(this->zs_fd,
+              footer,
+              sizeof(footer),
+              this->zs_file_size - sizeof(footer))
+        != sizeof(footer))
+    {
+        return false;
+    }
+    if (read_le32(&footer[5]) != ZSTD_SEEKABLE_MAGIC
+        || (footer[4] & 0x7c) != 0)
+    {
+        return false;
+    }
+
+    auto frame_count = read_le32(&footer[0]);
+    auto has_checksum = (footer[4] & 0x80) != 0;
+    size_t entry_size = has_checksum ? 12 : 8;
+    auto table_size
+        = (file_off_t) (frame_count * entry_size + sizeof(footer));
+    auto table_start = this->zs_file_size - table_size - 8;
+
+    if (table_start < 0) {
+        return false;
+    }
+
+    std::vector<unsigned char> table(table_size + 8);
+    if (pread(this->zs_fd, table.data(), table.size(), table_start)
+        != (ssize_t) table.size())
+    {
+        return false;
+    }
+    if (read_le32(&table[0]) != ZSTD_SEEK_TABLE_MAGIC
+        || read_le32(&table[4]) != (uint32_t) table_size)
+    {
+        return false;
+    }
+
+    std::vector<frame> frames;
+    file_off_t in_offset = 0;
+    file_off_t out_offset = 0;
+
+    frames.reserve(frame_count);
+    for (uint32_t lpc = 0; lpc < frame_count; lpc++) {
+        const auto* entry = &table[8 + lpc * entry_size];
+        auto in_size = read_le32(&entry[0]);
+        auto out_size = read_le32(&entry[4]);
+
+        frames.emplace_back(frame{in_offset, in_size, out_offset, out_size});
+        in_offset += in_size;
+        out_offset += out_size;
+    }
+    if (in_offset != table_start) {
+        log_warning("%d: zstd seek table does not match the file",
+                    this->zs_fd);
+        return false;
+    }
+
+    this->zs_frames = std::move(frames);
+    this->zs_scan_offset = table_start;
+    this->zs_scan_done = true;
+
+    return true;
+}
+
+std::optional<line_buffer::zstd_indexed::frame>
+line_buffer::zstd_indexed::scan_frame()
+{
+    static const size_t DICT_ID_SIZES[] = {0, 1, 2, 4};
+    static const size_t CONTENT_SIZE_SIZES[] = {0, 2, 4, 8};
+
+    unsigned char header[ZSTD_MAX_FRAME_HEADER_SIZE];
+
+    while (true) {
+        auto rc = pread(
+            this->zs_fd, header, sizeof(header), this->zs_scan_offset);
+        if (rc < 8) {
+            break;
+        }
+
+        auto magic = read_le32(header);
+        if ((magic & ZSTD_SKIPPABLE_MASK) == ZSTD_SKIPPABLE_MAGIC) {
+            this->zs_scan_offset += 8 + read_le32(&header[4]);
+            continue;
+        }
+        if (magic != ZSTD_FRAME_MAGIC) {
+            log_error("%d: unknown zstd frame at offset %lld",
+                      this->zs_fd,
+                      (long long) this->zs_scan_offset);
+            break;
+        }
+
+        /*
+         * Only the headers are needed to find the end of the frame, the
+         * blocks themselves are skipped over.
+         */
+        auto descriptor = header[4];
+        auto single_segment = (descriptor >> 5) & 1;
+        auto content_size_flag = descriptor >> 6;
+        auto content_size_size = CONTENT_SIZE_SIZES[content_size_flag];
+        if (content_size_flag == 0 && single_segment) {
+            content_size_size = 1;
+        }
+        auto header_size = 5 + (single_segment ? 0 : 1)
+            + DICT_ID_SIZES[descriptor & 3] + content_size_size;
+        auto has_checksum = (descriptor >> 2) & 1;
+
+        std::optional<size_t> out_size;
+        auto content_size = ZSTD_getFrameContentSize(header, rc);
+        if (content_size != ZSTD_CONTENTSIZE_UNKNOWN
+            && content_size != ZSTD_CONTENTSIZE_ERROR)
+        {
+            out_size = content_size;
+        }
+
+        auto pos = this->zs_scan_offset + (file_off_t) header_size;
+        auto last_block = false;
+        while (!last_block) {
+            unsigned char block_header[3];
+
+            if (pread(this->zs_fd, block_header, sizeof(block_header), pos)
+                != sizeof(block_header))
+            {
+                return std::nullopt;
+            }
+
+            uint32_t bh = block_header[0] | (block_header[1] << 8)
+                | (block_header[2] << 16);
+            auto block_type = (bh >> 1) & 3;
+            auto block_size = bh >> 3;
+
+            if (block_type == 3) {
+                log_error("%d: invalid zstd block at offset %lld",
+                          this->zs_fd,
+                          (long long) pos);
+                return std::nullopt;
+            }
+            last_block = bh & 1;
+            pos += sizeof(block_header) + (block_type == 1 ? 1 : block_size);
+        }
+        if (has_checksum) {
+            pos += 4;
+        }
+        if (pos > this->zs_file_size) {
+            log_debug("%d: truncated zstd frame at offset %lld",
+                      this->zs_fd,
+                      (long long) this->zs_scan_offset);
+            return std::nullopt;
+        }
+
+        // The output offset is filled in by the caller once the sizes of
+        // the previous frames are known.
+        auto retval = frame{
+            this->zs_scan_offset,
+            (size_t) (pos - this->zs_scan_offset),
+            0,
+            out_size,
+        };
+        this->zs_scan_offset = pos;
+        return retval;
+    }
+
+    this->zs_scan_done = true;
+    return std::nullopt;
+}
+
+bool
+line_buffer::zstd_indexed::decompress(const frame& fr,
+                                      std::vector<char>& out) const
+{
+    auto_mem<char> inbuf;
+
+    if ((inbuf = auto_mem<char>::malloc(fr.f_in_size)) == nullptr) {
+        throw std::bad_alloc();
+    }
+    if (pread(this->zs_fd, inbuf.in(), fr.f_in_size, fr.f_in_offset)
+        != (ssize_t) fr.f_in_size)
+    {
+        return false;
+    }
+
+    auto* dctx = ZSTD_createDCtx();
+    if (dctx == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    ZSTD_inBuffer in{inbuf.in(), fr.f_in_size, 0};
+    size_t out_size = 0;
+    size_t rc;
+
+    out.resize(fr.f_out_size.value_or(ZSTD_DStreamOutSize()));
+    do {
+        if (out_size == out.size()) {
+            if (out.size() > ZSTD_MAX_CACHED_FRAME_SIZE) {
+                rc = 1;
+                break;
+            }
+            out.resize(std::max(out.size() * 2, ZSTD_DStreamOutSize()));
         }
-    } else {
-        log_error("%d: unable to get gzip header", fd);
-    }
+
+        ZSTD_outBuffer zout{out.data(), out.size(), out_size};
+
+        rc = ZSTD_decompressStream(dctx, &zout, &in);
+        out_size = zout.pos;
+    } while (!ZSTD_isError(rc) && rc != 0
+             && (in.pos < in.size || out_size == out.size()));
+    ZSTD_freeDCtx(dctx);
+    out.resize(out_size);
+
+    return rc == 0;
 }
 
-int
-line_buffer::gz_indexed::stream_data(void* buf, size_t size)
+bool
+line_buffer::zstd_indexed::index_more()
 {
-    this->strm.avail_out = size;
-    this->strm.next_out = (unsigned char*) buf;
+    if (this->zs_scan_done
+        || (!this->zs_frames.empty() && !this->zs_frames.back().f_out_size))
+    {
+        return false;
+    }
 
-    size_t last = this->syncpoints.empty() ? 0 : this->syncpoints.back().in;
-    while (this->strm.avail_out) {
-        if (!this->strm.avail_in) {
-            int rc = ::pread(
-                this->gz_fd, &this->inbuf[0], Z_BUFSIZE, this->strm.total_in);
-            if (rc < 0) {
-                return rc;
-            }
-            this->strm.next_in = this->inbuf;
-            this->strm.avail_in = rc;
+    static const size_t BATCH_SIZE = std::clamp(
+        (size_t) std::thread::hardware_concurrency(), size_t{2}, size_t{8});
+
+    /*
+     * The size of the decompressed data is not always in the frame header,
+     * so small frames without it are decompressed to find out.  The frames
+     * are independent, so that is done in parallel.
+     */
+    auto first_new = this->zs_frames.size();
+    std::vector<std::pair<size_t, std::future<std::optional<std::vector<char>>>>>
+        futures;
+    while (this->zs_frames.size() - first_new < BATCH_SIZE) {
+        auto fr_opt = this->scan_frame();
+        if (!fr_opt) {
+            break;
         }
-        if (this->strm.avail_in) {
-            int flush = last > this->strm.total_in ? Z_SYNC_FLUSH : Z_BLOCK;
-            auto err = inflate(&this->strm, flush);
-            if (err == Z_STREAM_END) {
-                // Reached end of stream; re-init for a possible subsequent
-                // stream
-                continue_stream();
-            } else if (err != Z_OK) {
-                log_error(" inflate-error at %d: %d  %s",
-                          this->strm.total_in,
-                          (int) err,
-                          this->strm.msg ? this->strm.msg : "");
-                break;
-            }
 
-            if (this->strm.total_in >= last + SYNCPOINT_SIZE
-                && size > this->strm.avail_out + GZ_WINSIZE
-                && (this->strm.data_type & GZ_END_OF_BLOCK_MASK)
-                && !(this->strm.data_type & GZ_END_OF_FILE_MASK))
-            {
-                this->syncpoints.emplace_back(this->strm, size);
-                last = this->strm.total_out;
+        auto fr = fr_opt.value();
+        this->zs_frames.emplace_back(fr);
+        if (fr.f_out_size) {
+            continue;
+        }
+        if (fr.f_in_size > ZSTD_MAX_CACHED_FRAME_SIZE) {
+            break;
+        }
+        futures.emplace_back(
+            this->zs_frames.size() - 1,
+            std::async(std::launch::async,
+                       [this, fr]() -> std::optional<std::vector<char>> {
+                           std::vector<char> data;
+
+                           if (!this->decompress(fr, data)) {
+                               return std::nullopt;
+                           }
+                           return std::move(data);
+                       }));
+        if (futures.size() == BATCH_SIZE) {
+            break;
+        }
+    }
+
+    for (auto& fut : futures) {
+        auto data = fut.second.get();
+        if (!data) {
+            /*
+             * Stop here and leave the size unknown, the frame will be
+             * streamed instead.
+             */
+            for (auto& rest : futures) {
+                if (rest.second.valid()) {
+                    rest.second.wait();
+                }
             }
-        } else if (this->strm.avail_out) {
-            // Processed all the gz file data but didn't fill
-            // the output buffer.  We're done, even though we
-            // produced fewer bytes than requested.
+            this->zs_frames.resize(fut.first + 1);
+            this->zs_scan_offset = this->zs_frames.back().f_in_offset
+                + this->zs_frames.back().f_in_size;
+            this->zs_scan_done = false;
             break;
         }
+
+        this->zs_frames[fut.first].f_out_size = data->size();
+        this->cache_frame(fut.first, std::move(*data));
     }
-    return size - this->strm.avail_out;
+
+    // The output offsets could not be known until the sizes were.
+    for (auto lpc = std::max(first_new, size_t{1});
+         lpc < this->zs_frames.size();
+         lpc++)
+    {
+        const auto& prev = this->zs_frames[lpc - 1];
+
+        if (!prev.f_out_size) {
+            break;
+        }
+        this->zs_frames[lpc].f_out_offset
+            = prev.f_out_offset + prev.f_out_size.value();
+    }
+
+    return this->zs_frames.size() > first_new;
 }
 
-void
-line_buffer::gz_indexed::seek(off_t offset)
+const std::vector<char>*
+line_buffer::zstd_indexed::frame_data(size_t index)
 {
-    if ((size_t) offset == this->strm.total_out) {
-        return;
+    for (const auto& entry : this->zs_cache) {
+        if (entry.first == index) {
+            return &entry.second;
+        }
     }
 
-    indexDict* dict = nullptr;
-    // Find highest syncpoint not past offset
-    // FIXME: Make this a binary-tree search
-    for (auto& d : this->syncpoints) {
-        if (d.out <= offset) {
-            dict = &d;
-        } else {
+    if (!this->zs_frames[index].is_cacheable()) {
+        return nullptr;
+    }
+
+    static const size_t BATCH_SIZE = std::clamp(
+        (size_t) std::thread::hardware_concurrency(), size_t{2}, size_t{8});
+
+    /*
+     * Reads are mostly sequential, so decompress the following frames in
+     * parallel with the one that is needed now.
+     */
+    std::vector<std::pair<size_t, std::future<std::optional<std::vector<char>>>>>
+        futures;
+    for (auto lpc = index;
+         lpc < this->zs_frames.size() && futures.size() < BATCH_SIZE;
+         lpc++)
+    {
+        const auto& fr = this->zs_frames[lpc];
+
+        if (!fr.is_cacheable()) {
             break;
         }
+        if (lpc > index
+            && std::any_of(this->zs_cache.begin(),
+                           this->zs_cache.end(),
+                           [lpc](const auto& entry) {
+                               return entry.first == lpc;
+                           }))
+        {
+            continue;
+        }
+        futures.emplace_back(
+            lpc,
+            std::async(std::launch::async,
+                       [this, fr]() -> std::optional<std::vector<char>> {
+                           std::vector<char> data;
+
+                           if (!this->decompress(fr, data)) {
+                               return std::nullopt;
+                           }
+                           return std::move(data);
+                       }));
     }
 
-    // Choose highest available syncpoint, or keep current offset if it's ok
-    if ((size_t) offset < this->strm.total_out
-        || (dict && this->strm.total_out < (size_t) dict->out))
+    std::optional<std::vector<char>> retval;
+    for (auto& fut : futures) {
+        auto data = fut.second.get();
+
+        if (fut.first == index) {
+            retval = std::move(data);
+        } else if (data
+                   && data->size() == this->zs_frames[fut.first].f_out_size)
+        {
+            this->cache_frame(fut.first, std::move(*data));
+        }
+    }
+
+    if (!retval || retval->size() != this->zs_frames[index].f_out_size) {
+        log_error("%d: unable to decompress zstd frame at offset %lld",
+                  this->zs_fd,
+                  (long long) this->zs_frames[index].f_in_offset);
+        errno = EIO;
+        return nullptr;
+    }
+    // Add the requested frame last so that it is not evicted right away.
+    this->cache_frame(index, std::move(*retval));
+
+    return &this->zs_cache.back().second;
+}
+
+void
+line_buffer::zstd_indexed::cache_frame(size_t index, std::vector<char>&& data)
+{
+    this->zs_cache_size += data.size();
+    this->zs_cache.emplace_back(index, std::move(data));
+    while (this->zs_cache.size() > 1
+           && this->zs_cache_size > ZSTD_MAX_CACHE_SIZE)
     {
-        // Release the old z_stream
-        inflateEnd(&this->strm);
-        if (dict) {
-            dict->apply(&this->strm);
+        this->zs_cache_size -= this->zs_cache.front().second.size();
+        this->zs_cache.erase(this->zs_cache.begin());
+    }
+}
+
+ssize_t
+line_buffer::zstd_indexed::stream_read(size_t index,
+                                       char* dst,
+                                       file_off_t offset,
+                                       size_t size)
+{
+    auto& fr = this->zs_frames[index];
+
+    if (!this->zs_stream) {
+        this->zs_stream = std::make_shared<stream_state>();
+    }
+
+    auto& ss = *this->zs_stream;
+    if (ss.ss_frame != index || ss.ss_in_offset < fr.f_in_offset
+        || ss.ss_out_offset > offset)
+    {
+        // The frame cannot be entered in the middle, so start over.
+        ZSTD_DCtx_reset(ss.ss_dctx, ZSTD_reset_session_only);
+        ss.ss_in = ZSTD_inBuffer{ss.ss_inbuf.data(), 0, 0};
+        ss.ss_frame = index;
+        ss.ss_in_offset = fr.f_in_offset;
+        ss.ss_out_offset = fr.f_out_offset;
+    }
+
+    auto frame_end = fr.f_in_offset + (file_off_t) fr.f_in_size;
+    std::vector<char> discard;
+    size_t retval = 0;
+
+    while (retval < size) {
+        if (ss.ss_in.pos == ss.ss_in.size) {
+            if (ss.ss_in_offset >= frame_end) {
+                break;
+            }
+
+            auto want = std::min((file_off_t) ss.ss_inbuf.size(),
+                                 frame_end - ss.ss_in_offset);
+            auto rc = pread(
+                this->zs_fd, ss.ss_inbuf.data(), want, ss.ss_in_offset);
+            if (rc <= 0) {
+                if (rc == 0) {
+                    errno = EIO;
+                }
+                return -1;
+            }
+            ss.ss_in = ZSTD_inBuffer{ss.ss_inbuf.data(), (size_t) rc, 0};
+            ss.ss_in_offset += rc;
+        }
+
+        ZSTD_outBuffer out;
+        if (ss.ss_out_offset < offset) {
+            /* Skip over the data before the requested offset. */
+            discard.resize(std::min((file_off_t) ZSTD_DStreamOutSize(),
+                                    offset - ss.ss_out_offset));
+            out = ZSTD_outBuffer{discard.data(), discard.size(), 0};
         } else {
-            init_stream();
+            out = ZSTD_outBuffer{&dst[retval], size - retval, 0};
         }
-    }
 
-    // Stream from compressed file until we reach our offset
-    unsigned char dummy[Z_BUFSIZE];
-    while ((size_t) offset > this->strm.total_out) {
-        size_t to_copy
-            = std::min(static_cast<size_t>(Z_BUFSIZE),
-                       static_cast<size_t>(offset - this->strm.total_out));
-        auto bytes = stream_data(dummy, to_copy);
-        if (bytes <= 0) {
+        auto rc = ZSTD_decompressStream(ss.ss_dctx, &out, &ss.ss_in);
+        if (ZSTD_isError(rc)) {
+            log_error("%d: zstd decompression failed at offset %lld -- %s",
+                      this->zs_fd,
+                      (long long) ss.ss_in_offset,
+                      ZSTD_getErrorName(rc));
+            this->zs_stream.reset();
+            errno = EIO;
+            return -1;
+        }
+        if (out.dst != discard.data()) {
+            retval += out.pos;
+        }
+        ss.ss_out_offset += out.pos;
+        if (rc == 0) {
+            if (!fr.f_out_size) {
+                fr.f_out_size = ss.ss_out_offset - fr.f_out_offset;
+            }
+            ss.ss_in_offset = frame_end;
+            ss.ss_in.pos = ss.ss_in.size;
             break;
         }
     }
+    this->zs_source_offset = ss.ss_in_offset;
+
+    return retval;
 }
 
-int
-line_buffer::gz_indexed::read(void* buf, size_t offset, size_t size)
+ssize_t
+line_buffer::zstd_indexed::read(void* buf, size_t offset, size_t size)
 {
-    if (offset != this->strm.total_out) {
-        // log_debug("doing seek!  %d %d", offset, this->strm.total_out);
-        this->seek(offset);
-    }
+    auto* dst = static_cast<char*>(buf);
+    size_t retval = 0;
+
+    while (retval < size) {
+        auto want = (file_off_t) (offset + retval);
+
+        while (this->zs_frames.empty()
+               || (this->zs_frames.back().f_out_size
+                   && want >= this->zs_frames.back().f_out_offset
+                           + (file_off_t) this->zs_frames.back()
+                                 .f_out_size.value()))
+        {
+            if (!this->index_more()) {
+                break;
+            }
+        }
+        if (this->zs_frames.empty()) {
+            break;
+        }
+
+        auto iter = std::upper_bound(
+            this->zs_frames.begin(),
+            this->zs_frames.end(),
+            want,
+            [](file_off_t off, const frame& fr) {
+                return off < fr.f_out_offset;
+            });
+        auto index = std::distance(this->zs_frames.begin(), iter) - 1;
+        const auto& fr = this->zs_frames[index];
+
+        if (fr.f_out_size
+            && want >= fr.f_out_offset + (file_off_t) fr.f_out_size.value())
+        {
+            break;
+        }
+
+        if (fr.is_cacheable()) {
+            const auto* data = this->frame_data(index);
 
-    int bytes = stream_data(buf, size);
+            if (data == nullptr) {
+                return retval > 0 ? (ssize_t) retval : -1;
+            }
+
+            auto frame_off = want - fr.f_out_offset;
+            auto count = std::min(size - retval, data->size() - frame_off);
+
+            memcpy(&dst[retval], data->data() + frame_off, count);
+            retval += count;
+            this->zs_source_offset = fr.f_in_offset + fr.f_in_size;
+            continue;
+        }
+
+        auto had_size = fr.f_out_size.has_value();
+        auto rc = this->stream_read(index, &dst[retval], want, size - retval);
+        if (rc < 0) {
+            return retval > 0 ? (ssize_t) retval : -1;
+        }
+        if (rc == 0) {
+            if (had_size || !this->zs_frames[index].f_out_size) {
+                // The frame ended before it was supposed to.
+                break;
+            }
+            // The size of the frame is now known, so move on to the next.
+            continue;
+        }
+        retval += rc;
+    }
 
-    return bytes;
+    return retval;
 }
+#endif
 
 line_buffer::line_buffer()
 {
@@ -395,8 +2007,20 @@ line_buffer::set_fd(auto_fd& fd)
         }
     }
 
-    if (this->lb_bz_file) {
-        this->lb_bz_file = false;
+    {
+        safe::WriteAccess<safe_bz_indexed> bi(this->lb_bz_file);
+
+        if (*bi) {
+            bi->close();
+        }
+    }
+
+    {
+        safe::WriteAccess<safe_zstd_indexed> zi(this->lb_zstd_file);
+
+        if (*zi) {
+            zi->close();
+        }
     }
 
     if (fd != -1) {
@@ -466,10 +2090,14 @@ line_buffer::set_fd(auto_fd& fd)
 #ifdef HAVE_BZLIB_H
                 else if (gz_id[0] == 'B' && gz_id[1] == 'Z')
                 {
+                    int bzfd = dup(fd);
+
+                    log_perror(fcntl(bzfd, F_SETFD, FD_CLOEXEC));
                     if (lseek(fd, 0, SEEK_SET) < 0) {
+                        close(bzfd);
                         throw error(errno);
                     }
-                    this->lb_bz_file = true;
+                    this->lb_bz_file.writeAccess()->open(bzfd);
                     this->lb_compressed = true;
 
                     /*
@@ -481,6 +2109,19 @@ line_buffer::set_fd(auto_fd& fd)
                     this->lb_compressed_offset = 0;
                 }
 #endif
+#ifdef HAVE_ZSTD_H
+                else if (gz_id[0] == '\x28' && gz_id[1] == '\xb5'
+                         && gz_id[2] == '\x2f' && gz_id[3] == '\xfd')
+                {
+                    int zstdfd = dup(fd);
+
+                    log_perror(fcntl(zstdfd, F_SETFD, FD_CLOEXEC));
+                    this->lb_zstd_file.writeAccess()->open(zstdfd);
+                    this->lb_compressed = true;
+                    this->resize_buffer(INITIAL_COMPRESSED_BUFFER_SIZE);
+                    this->lb_compressed_offset = 0;
+                }
+#endif
             }
             this->lb_seekable = true;
         }
@@ -613,6 +2254,8 @@ line_buffer::load_next_buffer()
     auto start = this->lb_loader_file_offset.value();
     ssize_t rc = 0;
     safe::WriteAccess<safe_gz_indexed> gi(this->lb_gz_file);
+    safe::WriteAccess<safe_bz_indexed> bi(this->lb_bz_file);
+    safe::WriteAccess<safe_zstd_indexed> zi(this->lb_zstd_file);
 
     // log_debug("BEGIN preload read");
     /* ... read in the new data. */
@@ -643,7 +2286,7 @@ line_buffer::load_next_buffer()
         }
     }
 #ifdef HAVE_BZLIB_H
-    else if (!this->lb_cached_fd && this->lb_bz_file)
+    else if (!this->lb_cached_fd && *bi)
     {
         if (this->lb_file_size != (ssize_t) -1
             && (((ssize_t) start >= this->lb_file_size)
@@ -652,44 +2295,35 @@ line_buffer::load_next_buffer()
         {
             rc = 0;
         } else {
-            lock_hack::guard guard;
-            char scratch[32 * 1024];
-            BZFILE* bz_file;
-            file_off_t seek_to;
-            int bzfd;
-
-            /*
-             * Unfortunately, there is no bzseek, so we need to reopen the
-             * file every time we want to do a read.
-             */
-            bzfd = dup(this->lb_fd);
-            if (lseek(this->lb_fd, 0, SEEK_SET) < 0) {
-                close(bzfd);
-                throw error(errno);
-            }
-            if ((bz_file = BZ2_bzdopen(bzfd, "r")) == nullptr) {
-                close(bzfd);
-                if (errno == 0) {
-                    throw std::bad_alloc();
-                } else {
-                    throw error(errno);
-                }
-            }
-
-            seek_to = start + this->lb_alt_buffer.value().size();
-            while (seek_to > 0) {
-                int count;
+            rc = bi->read(this->lb_alt_buffer->end(),
+                          start + this->lb_alt_buffer.value().size(),
+                          this->lb_alt_buffer->available());
+            this->lb_compressed_offset = bi->get_source_offset();
 
-                count = BZ2_bzread(bz_file,
-                                   scratch,
-                                   std::min((size_t) seek_to, sizeof(scratch)));
-                seek_to -= count;
+            if (rc != -1 && (rc < (this->lb_alt_buffer.value().available()))
+                && (start + this->lb_alt_buffer.value().size() + rc
+                    > this->lb_file_size))
+            {
+                this->lb_file_size
+                    = (start + this->lb_alt_buffer.value().size() + rc);
             }
-            rc = BZ2_bzread(bz_file,
-                            this->lb_alt_buffer->end(),
-                            this->lb_alt_buffer->available());
-            this->lb_compressed_offset = lseek(bzfd, 0, SEEK_SET);
-            BZ2_bzclose(bz_file);
+        }
+    }
+#endif
+#ifdef HAVE_ZSTD_H
+    else if (!this->lb_cached_fd && *zi)
+    {
+        if (this->lb_file_size != (ssize_t) -1
+            && (((ssize_t) start >= this->lb_file_size)
+                || (this->in_range(start)
+                    && this->in_range(this->lb_file_size - 1))))
+        {
+            rc = 0;
+        } else {
+            rc = zi->read(this->lb_alt_buffer->end(),
+                          start + this->lb_alt_buffer.value().size(),
+                          this->lb_alt_buffer->available());
+            this->lb_compressed_offset = zi->get_source_offset();
 
             if (rc != -1 && (rc < (this->lb_alt_buffer.value().available()))
                 && (start + this->lb_alt_buffer.value().size() + rc
@@ -873,6 +2507,8 @@ line_buffer::fill_range(file_off_t start,
         this->ensure_available(start, max_length, dir);
 
         safe::WriteAccess<safe_gz_indexed> gi(this->lb_gz_file);
+        safe::WriteAccess<safe_bz_indexed> bi(this->lb_bz_file);
+        safe::WriteAccess<safe_zstd_indexed> zi(this->lb_zstd_file);
 
         /* ... read in the new data. */
         if (!this->lb_cached_fd && *gi) {
@@ -905,7 +2541,7 @@ line_buffer::fill_range(file_off_t start,
 #endif
         }
 #ifdef HAVE_BZLIB_H
-        else if (!this->lb_cached_fd && this->lb_bz_file)
+        else if (!this->lb_cached_fd && *bi)
         {
             if (this->lb_file_size != (ssize_t) -1
                 && (((ssize_t) start >= this->lb_file_size)
@@ -914,45 +2550,34 @@ line_buffer::fill_range(file_off_t start,
             {
                 rc = 0;
             } else {
-                lock_hack::guard guard;
-                char scratch[32 * 1024];
-                BZFILE* bz_file;
-                file_off_t seek_to;
-                int bzfd;
-
-                /*
-                 * Unfortunately, there is no bzseek, so we need to reopen the
-                 * file every time we want to do a read.
-                 */
-                bzfd = dup(this->lb_fd);
-                if (lseek(this->lb_fd, 0, SEEK_SET) < 0) {
-                    close(bzfd);
-                    throw error(errno);
-                }
-                if ((bz_file = BZ2_bzdopen(bzfd, "r")) == NULL) {
-                    close(bzfd);
-                    if (errno == 0) {
-                        throw std::bad_alloc();
-                    } else {
-                        throw error(errno);
-                    }
-                }
-
-                seek_to = this->lb_file_offset + this->lb_buffer.size();
-                while (seek_to > 0) {
-                    int count;
+                this->lb_stats.s_decompressions += 1;
+                rc = bi->read(this->lb_buffer.end(),
+                              this->lb_file_offset + this->lb_buffer.size(),
+                              this->lb_buffer.available());
+                this->lb_compressed_offset = bi->get_source_offset();
 
-                    count = BZ2_bzread(
-                        bz_file,
-                        scratch,
-                        std::min((size_t) seek_to, sizeof(scratch)));
-                    seek_to -= count;
+                if (rc != -1 && (rc < (this->lb_buffer.available()))) {
+                    this->lb_file_size
+                        = (this->lb_file_offset + this->lb_buffer.size() + rc);
                 }
-                rc = BZ2_bzread(bz_file,
-                                this->lb_buffer.end(),
-                                this->lb_buffer.available());
-                this->lb_compressed_offset = lseek(bzfd, 0, SEEK_SET);
-                BZ2_bzclose(bz_file);
+            }
+        }
+#endif
+#ifdef HAVE_ZSTD_H
+        else if (!this->lb_cached_fd && *zi)
+        {
+            if (this->lb_file_size != (ssize_t) -1
+                && (((ssize_t) start >= this->lb_file_size)
+                    || (this->in_range(start)
+                        && this->in_range(this->lb_file_size - 1))))
+            {
+                rc = 0;
+            } else {
+                this->lb_stats.s_decompressions += 1;
+                rc = zi->read(this->lb_buffer.end(),
+                              this->lb_file_offset + this->lb_buffer.size(),
+                              this->lb_buffer.available());
+                this->lb_compressed_offset = zi->get_source_offset();
 
                 if (rc != -1 && (rc < (this->lb_buffer.available()))) {
                     this->lb_file_size
@@ -1557,6 +3182,22 @@ line_buffer::cleanup_cache()
             }
         }
 
+        for (const auto& index_subdir :
+             std::filesystem::directory_iterator(gz_index_cache_path(), ec))
+        {
+            for (const auto& entry :
+                 std::filesystem::directory_iterator(index_subdir, ec))
+            {
+                auto mtime = std::filesystem::last_write_time(entry.path());
+                auto exp_time = mtime + 7 * 24h;
+                if (now < exp_time) {
+                    continue;
+                }
+
+                to_remove.emplace_back(entry.path());
+            }
+        }
+
         for (auto& entry : to_remove) {
             log_debug("removing compressed file cache: %s", entry.c_str());
             std::filesystem::remove_all(entry, ec);
@@ -34,7 +34,10 @@
 
 #include <array>
 #include <exception>
+#include <filesystem>
 #include <future>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #include <errno.h>
@@ -101,10 +104,7 @@ public:
 
         inline operator bool() const { return this->gz_fd != -1; }
 
-        uLong get_source_offset() const
-        {
-            return !!*this ? this->strm.total_in + this->strm.avail_in : 0;
-        }
+        uLong get_source_offset() const;
 
         void close();
         void init_stream();
@@ -120,6 +120,8 @@ public:
         int read(void* buf, size_t offset, size_t size);
 
         struct indexDict {
+            indexDict() = default;
+
             off_t in = 0;
             off_t out = 0;
             unsigned char bits = 0;
@@ -130,12 +132,151 @@ public:
             int apply(z_streamp s);
         };
 
+        struct member_pipeline;
+
     private:
+        bool start_pipeline();
+        int read_ahead(void* buf, size_t offset, size_t size);
+        void add_syncpoints(std::vector<indexDict>& syncpoints, off_t base);
+        void load_index();
+        void save_index();
+
         z_stream strm{}; /*< gzip streams structure */
         std::vector<indexDict>
             syncpoints; /*< indexed dictionaries as discovered */
         auto_mem<Bytef> inbuf; /*< Compressed data buffer */
         int gz_fd = -1; /*< The file to read data from. */
+        bool gz_raw_stream{false}; /*< Resumed from a syncpoint. */
+        off_t gz_file_size{0}; /*< Non-zero if the pipeline can be used. */
+        std::shared_ptr<member_pipeline>
+            gz_pipeline; /*< Decodes members ahead of sequential reads. */
+        std::optional<std::filesystem::path>
+            gz_index_path; /*< Where the syncpoints are saved. */
+        size_t gz_saved_syncpoints{0}; /*< Syncpoints already saved. */
+        off_t gz_index_size{0}; /*< Valid bytes in the saved index. */
+    };
+
+    /**
+     * A bzip2 file reader that can do random file access.  The file is
+     * scanned for the bit-aligned magic numbers that start each block so
+     * that the blocks can be decompressed independently of each other.
+     */
+    class bz_indexed {
+    public:
+        bz_indexed() = default;
+        bz_indexed(bz_indexed&& other) = default;
+        ~bz_indexed() { this->close(); }
+
+        inline operator bool() const { return this->bz_fd != -1; }
+
+        file_off_t get_source_offset() const
+        {
+            return this->bz_source_offset;
+        }
+
+        void close();
+        void open(int fd);
+
+        /**
+         * Decompress bytes from the bz2 file returning at most `size` bytes.
+         * offset is the byte-offset in the decompressed data stream.
+         */
+        ssize_t read(void* buf, size_t offset, size_t size);
+
+    private:
+        struct block {
+            uint64_t b_bit_start; /*< Bit offset of the block magic. */
+            uint64_t b_bit_end; /*< Bit offset of the following magic. */
+            file_off_t b_out_offset; /*< Offset of the decompressed data. */
+            size_t b_out_size; /*< Size of the decompressed data. */
+        };
+
+        struct segment {
+            uint64_t s_bit_start;
+            uint64_t s_bit_end;
+        };
+
+        bool scan_segments(std::vector<segment>& segments_out,
+                           size_t max_segments);
+        bool index_more();
+        bool decompress(const segment& seg, std::vector<char>& out) const;
+        const std::vector<char>* block_data(size_t index);
+        void cache_block(size_t index, std::vector<char>&& data);
+
+        int bz_fd = -1; /*< The file to read data from. */
+        std::vector<block> bz_blocks; /*< Blocks found so far, in order. */
+        file_off_t bz_scan_offset{0}; /*< Bytes of the file scanned. */
+        uint64_t bz_scan_bits{0}; /*< Shift register for the scanner. */
+        uint64_t bz_scan_valid{0}; /*< Number of valid bits scanned. */
+        std::optional<uint64_t> bz_open_block; /*< Start of the last block. */
+        bool bz_scan_failed{false};
+        file_off_t bz_source_offset{0};
+        std::vector<std::pair<size_t, std::vector<char>>> bz_cache;
+    };
+
+    /**
+     * A zstd file reader that can do random file access.  The frames in
+     * a zstd file are independent of each other, so they are located up
+     * front, either from the seek table of a file in the seekable format
+     * or by walking the frame and block headers.  Frames that are too
+     * large to hold in memory are streamed instead.
+     */
+    class zstd_indexed {
+    public:
+        zstd_indexed() = default;
+        zstd_indexed(zstd_indexed&& other) = default;
+        ~zstd_indexed() { this->close(); }
+
+        inline operator bool() const { return this->zs_fd != -1; }
+
+        file_off_t get_source_offset() const
+        {
+            return this->zs_source_offset;
+        }
+
+        void close();
+        void open(int fd);
+
+        /**
+         * Decompress bytes from the zstd file returning at most `size`
+         * bytes.  offset is the byte-offset in the decompressed data stream.
+         */
+        ssize_t read(void* buf, size_t offset, size_t size);
+
+    private:
+        struct frame {
+            file_off_t f_in_offset; /*< Offset of the frame in the file. */
+            size_t f_in_size; /*< Size of the compressed frame. */
+            file_off_t f_out_offset; /*< Offset of the decompressed data. */
+            std::optional<size_t>
+                f_out_size; /*< Size of the decompressed data, if known. */
+
+            bool is_cacheable() const;
+        };
+
+        struct stream_state;
+
+        bool load_seek_table();
+        std::optional<frame> scan_frame();
+        bool index_more();
+        bool decompress(const frame& fr, std::vector<char>& out) const;
+        const std::vector<char>* frame_data(size_t index);
+        void cache_frame(size_t index, std::vector<char>&& data);
+        ssize_t stream_read(size_t index,
+                            char* dst,
+                            file_off_t offset,
+                            size_t size);
+
+        int zs_fd = -1; /*< The file to read data from. */
+        file_off_t zs_file_size{0};
+        std::vector<frame> zs_frames; /*< Frames found so far, in order. */
+        file_off_t zs_scan_offset{0}; /*< Offset of the next frame. */
+        bool zs_scan_done{false};
+        file_off_t zs_source_offset{0};
+        std::vector<std::pair<size_t, std::vector<char>>> zs_cache;
+        size_t zs_cache_size{0}; /*< Total bytes in zs_cache. */
+        std::shared_ptr<stream_state>
+            zs_stream; /*< Decoder for frames that are not cached. */
     };
 
     /** Construct an empty line_buffer. */
@@ -343,12 +484,15 @@ private:
     bool load_next_buffer();
 
     using safe_gz_indexed = safe::Safe<gz_indexed>;
+    using safe_bz_indexed = safe::Safe<bz_indexed>;
+    using safe_zstd_indexed = safe::Safe<zstd_indexed>;
 
     shared_buffer lb_share_manager;
 
     auto_fd lb_fd; /*< The file to read data from. */
     safe_gz_indexed lb_gz_file; /*< File reader for gzipped files. */
-    bool lb_bz_file{false}; /*< Flag set for bzip2 compressed files. */
+    safe_bz_indexed lb_bz_file; /*< File reader for bzip2 files. */
+    safe_zstd_indexed lb_zstd_file; /*< File reader for zstd files. */
     bool lb_line_metadata{false};
     file_ssize_t lb_piper_header_size{0};
 
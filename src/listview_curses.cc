@@ -29,6 +29,7 @@
  * @file listview_curses.cc
  */
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 
@@ -480,8 +481,11 @@ listview_curses::do_update()
         size_t row_count = this->get_inner_height();
         row = this->lv_top;
         bottom = y + height;
-        std::vector<attr_line_t> rows(
-            std::min((size_t) height, row_count - (int) this->lv_top));
+        // The row buffers are kept between updates so the strings and
+        // attribute vectors can reuse their storage from the last frame.
+        // They are cleared once drawn, see below.
+        auto& rows = this->lv_row_buffers;
+        rows.resize(std::min((size_t) height, row_count - (int) this->lv_top));
         this->lv_source->listview_value_for_rows(*this, row, rows);
         this->lv_display_lines.clear();
         this->lv_display_lines_row = row;
@@ -553,19 +557,34 @@ listview_curses::do_update()
                 }
 
                 mvwattrline_result write_res;
-                do {
-                    this->lv_display_lines.push_back(main_content{row});
-                    if (this->lv_word_wrap) {
+                if (this->lv_word_wrap) {
+                    do {
+                        this->lv_display_lines.push_back(main_content{row});
                         // XXX mvwhline(this->lv_window, y, this->vc_x, ' ',
                         // width);
+                        write_res = mvwattrline(this->lv_window,
+                                                y,
+                                                x,
+                                                al,
+                                                lr,
+                                                this->vc_default_role);
+                        lr.lr_start = write_res.mr_chars_out;
+                        lr.lr_end = write_res.mr_chars_out + width - 1;
+                        ++y;
+                    } while (y < bottom && write_res.mr_bytes_remaining > 0);
+                } else {
+                    this->lv_display_lines.push_back(main_content{row});
+                    if (!this->is_row_unchanged(y, x, al, lr)) {
+                        mvwattrline(this->lv_window,
+                                    y,
+                                    x,
+                                    al,
+                                    lr,
+                                    this->vc_default_role);
+                        this->save_drawn_row(y, x, al, lr);
                     }
-                    write_res = mvwattrline(
-                        this->lv_window, y, x, al, lr, this->vc_default_role);
-                    lr.lr_start = write_res.mr_chars_out;
-                    lr.lr_end = write_res.mr_chars_out + width - 1;
                     ++y;
-                } while (this->lv_word_wrap && y < bottom
-                         && write_res.mr_bytes_remaining > 0);
+                }
 
                 if (this->lv_overlay_source != nullptr) {
                     row_overlay_content.clear();
@@ -713,12 +732,20 @@ listview_curses::do_update()
                 ncplane_cursor_move_yx(this->lv_window, y, x);
                 ncplane_hline(this->lv_window, &clear_cell, width);
                 nccell_release(this->lv_window, &clear_cell);
+                damage_rows(this->lv_window, y);
 
                 this->lv_display_lines.push_back(empty_space{});
                 ++y;
             }
         }
 
+        // Empty the row buffers now, instead of at the start of the next
+        // update, so attributes like L_FILE do not keep a closed file
+        // alive.  clear() keeps the capacity for the next frame.
+        for (auto& al : rows) {
+            al.clear();
+        }
+
         if (this->lv_selectable && !this->lv_sync_selection_and_top
             && this->lv_selection >= 0 && row < this->lv_selection)
         {
@@ -780,6 +807,7 @@ listview_curses::do_update()
                 ncplane_on_styles_yx(
                     this->lv_window, bottom_y, x + lpc, NCSTYLE_UNDERLINE);
             }
+            damage_rows(this->lv_window, bottom_y);
         }
 
         this->vc_needs_update = false;
@@ -788,6 +816,90 @@ listview_curses::do_update()
     return view_curses::do_update() || retval;
 }
 
+static bool
+holds_file(const string_attr& sa)
+{
+    return sa.sa_value.is<std::shared_ptr<logfile>>();
+}
+
+bool
+listview_curses::is_row_unchanged(int y,
+                                  int x,
+                                  attr_line_t& al,
+                                  const line_range& lr)
+{
+    auto index = y - this->vc_y;
+
+    if (index < 0 || index >= (int) this->lv_drawn_rows.size()) {
+        return false;
+    }
+
+    const auto& dr = this->lv_drawn_rows[index];
+    if (dr.dr_stamp == 0 || dr.dr_stamp != row_stamp(this->lv_window, y)
+        || dr.dr_x != x || !(dr.dr_range == lr)
+        || dr.dr_role != this->vc_default_role)
+    {
+        return false;
+    }
+
+    // mvwattrline() sorts the attributes before drawing, so do the same
+    // here to compare against what was actually drawn.
+    auto& sa = al.get_attrs();
+    if (!std::is_sorted(sa.begin(), sa.end())) {
+        std::stable_sort(sa.begin(), sa.end());
+    }
+
+    if (dr.dr_line.get_string() != al.get_string()) {
+        return false;
+    }
+
+    // The saved line does not have the file attributes, see
+    // save_drawn_row(), so skip them while comparing.
+    const auto& dr_sa = dr.dr_line.get_attrs();
+    auto dr_iter = dr_sa.begin();
+    for (const auto& attr : sa) {
+        if (holds_file(attr)) {
+            continue;
+        }
+        if (dr_iter == dr_sa.end() || !(*dr_iter == attr)) {
+            return false;
+        }
+        ++dr_iter;
+    }
+
+    return dr_iter == dr_sa.end();
+}
+
+void
+listview_curses::save_drawn_row(int y,
+                                int x,
+                                attr_line_t& al,
+                                const line_range& lr)
+{
+    auto index = y - this->vc_y;
+
+    if (index < 0) {
+        return;
+    }
+    if (index >= (int) this->lv_drawn_rows.size()) {
+        this->lv_drawn_rows.resize(index + 1);
+    }
+
+    auto& dr = this->lv_drawn_rows[index];
+    dr.dr_stamp = row_stamp(this->lv_window, y);
+    dr.dr_x = x;
+    dr.dr_range = lr;
+    dr.dr_role = this->vc_default_role;
+    // The row buffer is refilled on the next update, so the drawn line can
+    // be swapped out of it instead of copied.
+    std::swap(dr.dr_line, al);
+    // Attributes like L_FILE are not drawn and would keep the file alive
+    // for as long as the row is on screen, so they are not cached.
+    auto& dr_sa = dr.dr_line.get_attrs();
+    dr_sa.erase(std::remove_if(dr_sa.begin(), dr_sa.end(), holds_file),
+                dr_sa.end());
+}
+
 void
 listview_curses::set_show_details_in_overlay(bool val)
 {
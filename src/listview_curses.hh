@@ -339,7 +339,11 @@ public:
     }
 
     /** @param win The curses window this view is attached to. */
-    void set_window(ncplane* win) { this->lv_window = win; }
+    void set_window(ncplane* win)
+    {
+        this->lv_window = win;
+        this->lv_drawn_rows.clear();
+    }
 
     /** @return The curses window this view is attached to. */
     ncplane* get_window() const { return this->lv_window; }
@@ -552,6 +556,9 @@ protected:
     vis_line_t get_overlay_top(vis_line_t row, size_t count, size_t total);
     size_t get_overlay_height(size_t total, vis_line_t view_height) const;
 
+    bool is_row_unchanged(int y, int x, attr_line_t& al, const line_range& lr);
+    void save_drawn_row(int y, int x, attr_line_t& al, const line_range& lr);
+
     enum class lv_mode_t {
         NONE,
         DOWN,
@@ -592,6 +599,22 @@ protected:
 
     vis_line_t lv_display_lines_row{0_vl};
     std::vector<display_line_content_t> lv_display_lines;
+    std::vector<attr_line_t> lv_row_buffers;
+
+    /**
+     * The content of a row as it was last drawn, so the row can be skipped
+     * if it has not changed and nothing else has drawn over it.
+     */
+    struct drawn_row {
+        uint64_t dr_stamp{0};
+        int dr_x{0};
+        line_range dr_range;
+        role_t dr_role{role_t::VCR_NONE};
+        attr_line_t dr_line;
+    };
+
+    /** The rows last drawn, indexed by their offset from the top. */
+    std::vector<drawn_row> lv_drawn_rows;
     unsigned int lv_scroll_top{0};
     unsigned int lv_scroll_bottom{0};
 };
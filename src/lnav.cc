@@ -70,6 +70,7 @@
 #include "base/ansi_vars.hh"
 #include "base/fs_util.hh"
 #include "base/func_util.hh"
+#include "base/future_util.hh"
 #include "base/humanize.hh"
 #include "base/humanize.time.hh"
 #include "base/injector.bind.hh"
@@ -98,6 +99,7 @@
 #include "lnav.indexing.hh"
 #include "lnav.management_cli.hh"
 #include "lnav.prompt.hh"
+#include "lnav.stream.hh"
 #include "lnav_commands.hh"
 #include "lnav_config.hh"
 #include "lnav_util.hh"
@@ -573,6 +575,12 @@ make it easier to navigate through files quickly.
         .append("-n"_symbol)
         .append("         ")
         .append("Run without the curses UI. (headless mode)\n")
+        .append("  ")
+        .append("-s"_symbol)
+        .append("         ")
+        .append(R"(Run in headless mode, but write the messages in a single,
+             time-ordered pass with bounded memory. (streaming mode)
+)")
         .append("  ")
         .append("-N"_symbol)
         .append("         ")
@@ -1813,6 +1821,8 @@ VALUES ('org.lnav.mouse-support', -1, DATETIME('now', '+1 minute'),
         if (initial_rescan_completed) {
             if (ui_now >= next_rebuild_time) {
                 auto text_file_count = lnav_data.ld_text_source.size();
+
+                tailer::check_remote_filters();
                 // log_debug("BEGIN rebuild");
                 auto rebuild_res = rebuild_indexes(loop_deadline);
                 // log_debug("END rebuild");
@@ -2717,6 +2727,12 @@ SELECT tbl_name FROM sqlite_master WHERE sql LIKE 'CREATE VIRTUAL TABLE%'
             "-n",
             [](size_t count) { lnav_data.ld_flags |= LNF_HEADLESS; },
             "headless");
+        auto* streaming_flag = app.add_flag(
+            "-s",
+            [](size_t count) {
+                lnav_data.ld_flags |= LNF_HEADLESS | LNF_STREAMING;
+            },
+            "streaming");
         auto* file_opt = app.add_option("file", file_args, "files");
 
         auto wait_cb = [](size_t count) {
@@ -2797,6 +2813,7 @@ SELECT tbl_name FROM sqlite_master WHERE sql LIKE 'CREATE VIRTUAL TABLE%'
                                rotated_flag,
                                recurse_flag,
                                headless_flag,
+                               streaming_flag,
                                cmd_opt,
                                exec_file_opt,
                                cmdline_opt);
@@ -3713,6 +3730,12 @@ SELECT tbl_name FROM sqlite_master WHERE sql LIKE 'CREATE VIRTUAL TABLE%'
                 }
             }
 
+            if (lnav_data.ld_flags & LNF_STREAMING) {
+                view_colors::init(nullptr);
+                lnav_data.ld_exec_context.set_output("stdout", stdout, nullptr);
+                return print_user_msgs(lnav::stream::perform(), mode_flags);
+            }
+
             if (lnav_data.ld_flags & LNF_HEADLESS) {
                 std::vector<
                     std::pair<Result<std::string, lnav::console::user_message>,
@@ -3922,6 +3945,13 @@ SELECT tbl_name FROM sqlite_master WHERE sql LIKE 'CREATE VIRTUAL TABLE%'
             lnav::console::print(stderr, um);
         }
 
+        // Stop any background rendering before the views and files it
+        // was started for are torn down.
+        auto joined = lnav::futures::join_detached_tasks();
+        if (joined > 0) {
+            log_info("joined %zu background task(s)", joined);
+        }
+
         // When reading from stdin, tell the user where the capture
         // file is stored so they can look at it later.
         if (stdin_url && !(lnav_data.ld_flags & LNF_HEADLESS)
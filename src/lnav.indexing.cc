@@ -35,6 +35,7 @@
 #include "service_tags.hh"
 #include "session_data.hh"
 #include "sql_util.hh"
+#include "timeline_source.hh"
 
 using namespace std::chrono_literals;
 using namespace lnav::roles::literals;
@@ -244,6 +245,12 @@ rebuild_indexes(std::optional<ui_clock::time_point> deadline)
             retval.rir_completed = false;
         }
 
+        lnav_data.ld_bottom_source.update_background_work(
+            "text",
+            rescan_res.rr_background_work > 0,
+            rescan_res.rr_background_done,
+            rescan_res.rr_background_total);
+
         if (cb.front_file != nullptr) {
             ensure_view(&text_view);
 
@@ -387,6 +394,16 @@ rebuild_indexes(std::optional<ui_clock::time_point> deadline)
             if (timeline_source != nullptr) {
                 timeline_source->text_filters_changed();
             }
+        } else if (retval.rir_changes > 0
+                   && tc == &lnav_data.ld_views[LNV_TIMELINE])
+        {
+            // Only the operations that changed are merged into the
+            // timeline, so it can keep up with files that are being tailed.
+            auto* tl_source = dynamic_cast<timeline_source*>(
+                lnav_data.ld_views[LNV_TIMELINE].get_sub_source());
+            if (tl_source != nullptr && tl_source->rebuild_indexes()) {
+                tc->reload_data();
+            }
         }
 
         auto* tss = tc->get_sub_source();
@@ -0,0 +1,469 @@
+/**
+ * Copyright (c) 2025, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <glob.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "lnav.stream.hh"
+
+#include "base/auto_mem.hh"
+#include "base/fs_util.hh"
+#include "base/itertools.hh"
+#include "bound_tags.hh"
+#include "command_executor.hh"
+#include "fmt/format.h"
+#include "lnav.hh"
+#include "logfile.hh"
+#include "shlex.hh"
+#include "text_anonymizer.hh"
+
+namespace lnav::stream {
+
+/** The number of lines to index from a file before checking the merge. */
+static constexpr size_t BATCH_SIZE = 4 * 1024;
+
+/**
+ * The number of lines that have been written out before they are dropped
+ * from the front of a file's index.
+ */
+static constexpr size_t WINDOW_SIZE = 16 * 1024;
+
+static const std::set<std::string> SUPPORTED_COMMANDS = {
+    "filter-in",
+    "filter-out",
+    "hide-lines-after",
+    "hide-lines-before",
+    "set-min-log-level",
+};
+
+/** The commands that send the streamed messages to a file. */
+static const std::set<std::string> WRITE_COMMANDS = {
+    "append-to",
+    "write-raw-to",
+    "write-to",
+};
+
+struct stream_output {
+    FILE* so_file{stdout};
+    auto_mem<FILE> so_owned{fclose};
+    bool so_anonymize{false};
+    lnav::text_anonymizer so_anonymizer;
+};
+
+static bool
+is_message_start(const logline& ll)
+{
+    return !ll.is_continued() && ll.get_sub_offset() == 0;
+}
+
+class stream_input : public logfile_observer {
+public:
+    explicit stream_input(std::shared_ptr<logfile> lf) : si_file(std::move(lf))
+    {
+        this->si_file->set_logfile_observer(this);
+    }
+
+    ~stream_input() override { this->si_file->set_logfile_observer(nullptr); }
+
+    indexing_result logfile_indexing(const logfile* lf,
+                                     file_off_t off,
+                                     file_size_t total) override
+    {
+        if (lf->size() >= this->si_limit) {
+            return indexing_result::BREAK;
+        }
+        return indexing_result::CONTINUE;
+    }
+
+    /**
+     * @return The index of the line after the end of the message at the
+     * front of the window or nullopt if all the messages have been written.
+     */
+    std::optional<size_t> message_end()
+    {
+        if (this->si_message_end) {
+            return this->si_message_end;
+        }
+
+        while (true) {
+            auto size = this->si_file->size();
+
+            for (; this->si_scan < size; this->si_scan++) {
+                if (this->si_scan > this->si_next
+                    && is_message_start(
+                        *std::next(this->si_file->begin(), this->si_scan)))
+                {
+                    this->si_message_end = this->si_scan;
+                    return this->si_message_end;
+                }
+            }
+            if (this->si_eof) {
+                if (this->si_next < size) {
+                    this->si_message_end = size;
+                }
+                return this->si_message_end;
+            }
+
+            this->si_limit = size + BATCH_SIZE;
+            switch (this->si_file->rebuild_index()) {
+                case logfile::rebuild_result_t::INVALID:
+                case logfile::rebuild_result_t::NO_NEW_LINES:
+                    this->si_eof = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    logfile::iterator message_begin()
+    {
+        return std::next(this->si_file->begin(), this->si_next);
+    }
+
+    /** Move past the current message and slide the window, if needed. */
+    void next_message()
+    {
+        this->si_next = this->si_message_end.value();
+        this->si_message_end = std::nullopt;
+
+        if (this->si_next >= WINDOW_SIZE) {
+            auto count = std::min(this->si_next, this->si_file->size() - 1);
+
+            this->si_file->discard_lines(count);
+            this->si_next -= count;
+            this->si_scan -= count;
+        }
+    }
+
+    std::shared_ptr<logfile> si_file;
+    size_t si_next{0};
+    size_t si_scan{0};
+    size_t si_limit{0};
+    std::optional<size_t> si_message_end;
+    bool si_eof{false};
+};
+
+static std::optional<lnav::console::user_message>
+open_output(const std::string& cmd, const std::string& name, stream_output& out)
+{
+    auto& ec = lnav_data.ld_exec_context;
+    auto error = [&cmd](const std::string& reason) {
+        return lnav::console::user_message::error(
+                   attr_line_t("unable to write streamed messages: ")
+                       .append(lnav::roles::quoted_code(cmd)))
+            .with_reason(reason)
+            .move();
+    };
+
+    if (out.so_file != stdout || out.so_anonymize) {
+        return error("only one output can be given");
+    }
+
+    auto args_start = cmd.find_first_of(" \t");
+    shlex lexer(args_start == std::string::npos ? std::string()
+                                                : cmd.substr(args_start));
+    auto split_res = lexer.split(ec.create_resolver());
+    if (split_res.isErr()) {
+        return error(split_res.unwrapErr().se_error.te_msg);
+    }
+
+    auto split_args = split_res.unwrap()
+        | lnav::itertools::map([](const auto& elem) { return elem.se_value; });
+    auto anon_iter
+        = std::find(split_args.begin(), split_args.end(), "--anonymize");
+    if (anon_iter != split_args.end()) {
+        if (name == "write-raw-to") {
+            return error("raw output cannot be anonymized");
+        }
+        split_args.erase(anon_iter);
+        out.so_anonymize = true;
+    }
+    if (split_args.size() != 1) {
+        return error("expecting a single file name or '-' for stdout");
+    }
+
+    const auto& path = split_args[0];
+    if (path == "-" || path == "/dev/stdout") {
+        return std::nullopt;
+    }
+    if (lnav_data.ld_flags & LNF_SECURE_MODE) {
+        return error("writing to files is unavailable in secure mode");
+    }
+
+    out.so_owned = fopen(path.c_str(), name == "append-to" ? "ae" : "we");
+    if (out.so_owned.in() == nullptr) {
+        return error(fmt::format(FMT_STRING("unable to open file {} -- {}"),
+                                 path,
+                                 strerror(errno)));
+    }
+    out.so_file = out.so_owned.in();
+
+    return std::nullopt;
+}
+
+static perform_result_t
+execute_commands(stream_output& out)
+{
+    auto& ec = lnav_data.ld_exec_context;
+    perform_result_t retval;
+
+    for (const auto& cmd : lnav_data.ld_commands) {
+        auto name = cmd.empty()
+            ? std::string()
+            : cmd.substr(1, cmd.find_first_of(" \t") - 1);
+
+        if (!cmd.empty() && cmd[0] == ':' && WRITE_COMMANDS.count(name) > 0) {
+            auto open_res = open_output(cmd, name, out);
+            if (open_res) {
+                retval.emplace_back(open_res.value());
+            }
+            continue;
+        }
+
+        if (cmd.empty() || cmd[0] != ':' || SUPPORTED_COMMANDS.count(name) == 0)
+        {
+            auto um = lnav::console::user_message::error(
+                          attr_line_t("command is not supported in "
+                                      "streaming mode: ")
+                              .append(lnav::roles::quoted_code(cmd)))
+                          .with_reason(
+                              !cmd.empty() && cmd[0] == ';'
+                                  ? "SQL queries run against the whole log "
+                                    "index, which is not kept when streaming"
+                                  : "only commands that can be applied to one "
+                                    "message at a time can be streamed")
+                          .with_help(attr_line_t("the supported commands are: ")
+                                         .join(SUPPORTED_COMMANDS, ", ")
+                                         .append(", ")
+                                         .join(WRITE_COMMANDS, ", "))
+                          .move();
+            retval.emplace_back(um);
+            continue;
+        }
+
+        auto exec_res = execute_command(ec, cmd.substr(1));
+        if (exec_res.isErr()) {
+            retval.emplace_back(exec_res.unwrapErr());
+        }
+    }
+
+    return retval;
+}
+
+static perform_result_t
+open_inputs(std::vector<std::unique_ptr<stream_input>>& inputs)
+{
+    perform_result_t retval;
+
+    for (const auto& [path, loo] : lnav_data.ld_active_files.fc_file_names) {
+        if (loo.loo_piper) {
+            auto um = lnav::console::user_message::error(
+                          attr_line_t("cannot stream: ")
+                              .append(lnav::roles::file(path)))
+                          .with_reason(
+                              "only regular files can be read in streaming "
+                              "mode")
+                          .move();
+            retval.emplace_back(um);
+            continue;
+        }
+
+        static_root_mem<glob_t, globfree> gl;
+
+        if (glob(path.c_str(), 0, nullptr, gl.inout()) != 0) {
+            auto um = lnav::console::user_message::error(
+                          attr_line_t("unable to open file: ")
+                              .append(lnav::roles::file(path)))
+                          .with_reason("no files matched the given path")
+                          .move();
+            retval.emplace_back(um);
+            continue;
+        }
+
+        for (size_t lpc = 0; lpc < gl->gl_pathc; lpc++) {
+            auto file_path = std::filesystem::path(gl->gl_pathv[lpc]);
+            struct stat st;
+
+            if (lnav::filesystem::statp(file_path, &st) == -1
+                || !S_ISREG(st.st_mode))
+            {
+                continue;
+            }
+
+            auto open_res = logfile::open(
+                file_path,
+                logfile_open_options().with_tail(false).with_streaming(true));
+            if (open_res.isErr()) {
+                auto um = lnav::console::user_message::error(
+                              attr_line_t("unable to open file: ")
+                                  .append(lnav::roles::file(file_path)))
+                              .with_reason(open_res.unwrapErr())
+                              .move();
+                retval.emplace_back(um);
+                continue;
+            }
+
+            inputs.emplace_back(
+                std::make_unique<stream_input>(open_res.unwrap()));
+        }
+    }
+
+    if (retval.empty() && inputs.empty()) {
+        retval.emplace_back(lnav::console::user_message::error(
+            "no files were given to stream"));
+    }
+
+    return retval;
+}
+
+perform_result_t
+perform()
+{
+    auto& lss = lnav_data.ld_log_source;
+    std::vector<std::unique_ptr<stream_input>> inputs;
+    stream_output out;
+    perform_result_t retval;
+
+    lnav_data.ld_view_stack.push_back(&lnav_data.ld_views[LNV_LOG]);
+    retval = execute_commands(out);
+    if (!retval.empty()) {
+        return retval;
+    }
+
+    retval = open_inputs(inputs);
+    if (!retval.empty()) {
+        return retval;
+    }
+
+    auto min_level = lss.get_min_log_level();
+    auto min_time = lss.get_min_row_time();
+    auto max_time = lss.get_max_row_time();
+    auto has_include = false;
+    for (const auto& filt : lss.get_filters()) {
+        if (filt->is_enabled() && filt->get_type() == text_filter::INCLUDE) {
+            has_include = true;
+        }
+    }
+
+    size_t message_count = 0;
+    size_t written_count = 0;
+    std::string msg_buffer;
+
+    while (true) {
+        stream_input* next_input = nullptr;
+
+        for (auto& si : inputs) {
+            if (!si->message_end()) {
+                continue;
+            }
+            if (next_input == nullptr
+                || si->message_begin()->get_timeval()
+                    < next_input->message_begin()->get_timeval())
+            {
+                next_input = si.get();
+            }
+        }
+        if (next_input == nullptr) {
+            break;
+        }
+
+        auto& lf = *next_input->si_file;
+        auto msg_begin = next_input->message_begin();
+        auto msg_end
+            = std::next(lf.begin(), next_input->si_message_end.value());
+        auto included = !has_include;
+        auto excluded = false;
+
+        message_count += 1;
+        if (msg_begin->get_msg_level() < min_level
+            || (min_time && msg_begin->get_timeval() < min_time.value())
+            || (max_time && max_time.value() < msg_begin->get_timeval()))
+        {
+            excluded = true;
+        }
+
+        msg_buffer.clear();
+        for (auto iter = msg_begin; iter != msg_end && !excluded; ++iter) {
+            if (iter->get_sub_offset() != 0) {
+                continue;
+            }
+
+            auto read_res = lf.read_line(iter);
+            if (read_res.isErr()) {
+                log_error("%s: unable to read line -- %s",
+                          lf.get_filename().c_str(),
+                          read_res.unwrapErr().c_str());
+                continue;
+            }
+
+            auto sbr = read_res.unwrap();
+            for (const auto& filt : lss.get_filters()) {
+                if (!filt->is_enabled()) {
+                    continue;
+                }
+                if (filt->matches(text_filter::line_source{lf, iter}, sbr)) {
+                    if (filt->get_type() == text_filter::INCLUDE) {
+                        included = true;
+                    } else {
+                        excluded = true;
+                    }
+                }
+            }
+            if (out.so_anonymize) {
+                msg_buffer.append(
+                    out.so_anonymizer.next(sbr.to_string_fragment()));
+            } else {
+                msg_buffer.append(sbr.get_data(), sbr.length());
+            }
+            msg_buffer.push_back('\n');
+        }
+
+        if (included && !excluded) {
+            fwrite(msg_buffer.data(), 1, msg_buffer.size(), out.so_file);
+            written_count += 1;
+        }
+        next_input->next_message();
+    }
+    fflush(out.so_file);
+
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    log_info("streamed %zu of %zu messages from %zu files; max_rss=%ld",
+             written_count,
+             message_count,
+             inputs.size(),
+             ru.ru_maxrss);
+
+    return retval;
+}
+
+}  // namespace lnav::stream
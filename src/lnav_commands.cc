@@ -86,6 +86,7 @@
 #include "spectro_impls.hh"
 #include "sql_util.hh"
 #include "sqlite-extension-func.hh"
+#include "sqlitepp.client.hh"
 #include "sysclip.hh"
 #include "tailer/tailer.looper.hh"
 #include "url_handler.cfg.hh"
@@ -1667,6 +1668,75 @@ com_delete_search_table(exec_context& ec,
     return Ok(retval);
 }
 
+static Result<std::string, lnav::console::user_message>
+com_create_log_index(exec_context& ec,
+                     std::string cmdline,
+                     std::vector<std::string>& args)
+{
+    std::string retval;
+
+    if (args.size() < 3) {
+        return ec.make_error("expecting a table name and one or more columns");
+    }
+
+    auto tab = lnav_data.ld_vtab_manager->lookup_impl(args[1]);
+    if (tab == nullptr || !tab->vi_supports_indexes) {
+        return ec.make_error("unknown log table -- {}", args[1]);
+    }
+
+    std::vector<log_vtab_impl::vtab_column> cols;
+    std::vector<std::pair<std::string, int32_t>> index_cols;
+    std::vector<int32_t> col_nums;
+    tab->get_columns(cols);
+    for (size_t lpc = 2; lpc < args.size(); lpc++) {
+        const auto& col_name = args[lpc];
+        auto col_iter = std::find_if(
+            cols.begin(), cols.end(), [&col_name](const auto& vc) {
+                return vc.vc_name == col_name;
+            });
+        if (col_iter == cols.end()) {
+            return ec.make_error(FMT_STRING("unknown column in table {} -- {}"),
+                                 args[1],
+                                 col_name);
+        }
+
+        auto col_num = VT_COL_MAX + std::distance(cols.begin(), col_iter);
+        index_cols.emplace_back(col_name, col_num);
+        col_nums.emplace_back(col_num);
+    }
+
+    if (ec.ec_dry_run) {
+        return Ok(retval);
+    }
+
+    // All of the indexes are built in one pass over the table before they
+    // are needed by an interactive query.
+    const auto& top_source = ec.ec_source.back();
+    sql_progress_guard progress_guard(sql_progress,
+                                      sql_progress_finished,
+                                      top_source.s_location,
+                                      top_source.s_content);
+    if (!tab->build_column_indexes(*lnav_data.ld_vtab_manager->get_source(),
+                                   col_nums))
+    {
+        return ec.make_error("indexing of {} was interrupted", args[1]);
+    }
+
+    std::vector<std::string> counts;
+    for (const auto& index_col : index_cols) {
+        const auto& coli = tab->vi_column_indexes.at(index_col.second);
+
+        counts.emplace_back(fmt::format(
+            FMT_STRING("{} distinct value(s) of column {}"),
+            coli.ci_value_to_lines.size(),
+            index_col.first));
+    }
+    retval = fmt::format(FMT_STRING("info: indexed {}"),
+                         fmt::join(counts, ", "));
+
+    return Ok(retval);
+}
+
 static Result<std::string, lnav::console::user_message>
 com_session(exec_context& ec,
             std::string cmdline,
@@ -4096,6 +4166,20 @@ readline_context::command_t STD_COMMANDS[] = {
                         "messages with the pattern "
                         "'duration=(?<duration>\\d+)'",
                         R"(task_durations duration=(?<duration>\d+))"})},
+    {"create-log-index",
+     com_create_log_index,
+
+     help_text(":create-log-index")
+         .with_summary(
+             "Index the messages in a log table by the value of a column")
+         .with_parameter(
+             help_text("table-name", "The name of the log table to index"))
+         .with_parameter(
+             help_text("column-name", "The columns to index").one_or_more())
+         .with_tags({"indexes"})
+         .with_example({"To index the access_log table by the client IP "
+                        "address",
+                        "access_log c_ip"})},
     {"delete-search-table",
      com_delete_search_table,
 
@@ -1298,6 +1298,29 @@ static const struct json_path_container textfile_handlers = {
                    &lnav::textfile::config::c_max_unformatted_line_length),
 };
 
+static const struct json_path_container logfile_retention_handlers = {
+    yajlpp::property_handler("max-age")
+        .with_synopsis("<duration>")
+        .with_description(
+            "Discard log messages that are older than this duration relative "
+            "to the newest message in the file, expressed as a duration "
+            "(e.g. '12h' for twelve hours).  A value of zero keeps all "
+            "messages.")
+        .with_example("12h")
+        .with_example("3d")
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_retention_max_age),
+    yajlpp::property_handler("max-size")
+        .with_synopsis("<bytes>")
+        .with_description(
+            "Discard the oldest log messages in a file once the indexed "
+            "content exceeds this many bytes.  A value of zero keeps all "
+            "messages.")
+        .with_min_value(0)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_retention_max_size),
+};
+
 static const struct json_path_container logfile_handlers = {
     yajlpp::property_handler("max-unrecognized-lines")
         .with_synopsis("<lines>")
@@ -1306,6 +1329,10 @@ static const struct json_path_container logfile_handlers = {
         .with_min_value(1)
         .for_field(&_lnav_config::lc_logfile,
                    &lnav::logfile::config::lc_max_unrecognized_lines),
+    yajlpp::property_handler("retention")
+        .with_description("Settings for bounding the memory used by "
+                          "long-running tails of log files")
+        .with_children(logfile_retention_handlers),
 };
 
 static const struct json_path_container ssh_config_handlers = {
@@ -1364,6 +1391,13 @@ static const struct json_path_container remote_handlers = {
         .with_example("3d")
         .with_example("12h")
         .for_field(&_lnav_config::lc_tailer, &tailer::config::c_cache_ttl),
+    yajlpp::property_handler("filter-pushdown")
+        .with_description(
+            "Push the enabled filter-in patterns and the hide-lines-before "
+            "time down to the remote tailer so that only matching lines "
+            "are transferred")
+        .for_field(&_lnav_config::lc_tailer,
+                   &tailer::config::c_filter_pushdown),
     yajlpp::property_handler("ssh")
         .with_description(
             "Settings related to the ssh command used to contact remote "
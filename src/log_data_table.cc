@@ -149,7 +149,13 @@ log_data_table::next(log_cursor& lc, logfile_sub_source& lss)
     }
 
     data_scanner ds(line_values.lvv_sbr, body.lr_start, body.lr_end);
-    data_parser dp(&ds);
+
+    /* The pairs for the previous row live in the arena, drop them before */
+    /* the arena is reused for this row. */
+    this->ldt_pairs.clear();
+    this->ldt_arena.reset();
+
+    data_parser dp(&ds, &this->ldt_arena);
     dp.parse();
 
     lf_iter->set_schema(dp.dp_schema_id);
@@ -160,7 +166,6 @@ log_data_table::next(log_cursor& lc, logfile_sub_source& lss)
         return false;
     }
 
-    this->ldt_pairs.clear();
     this->ldt_pairs.swap(dp.dp_pairs, __FILE__, __LINE__);
 
     return true;
@@ -167,6 +167,115 @@ opid_time_range::close_sub_ops(const string_fragment& subid)
     }
 }
 
+void
+log_opid_state::opid_changed(const string_fragment& opid)
+{
+    if (this->los_changed_opids.size() >= MAX_CHANGED_OPIDS) {
+        this->los_changed_opids.clear();
+        this->los_generation += 1;
+    }
+    this->los_changed_opids.insert(opid);
+}
+
+void
+log_opid_state::reset()
+{
+    this->los_opid_ranges.clear();
+    this->los_sub_in_use.clear();
+    this->los_changed_opids.clear();
+    this->los_generation += 1;
+}
+
+bool
+log_opid_state::discard_before(const timeval& tv)
+{
+    auto retval = false;
+
+    for (auto iter = this->los_opid_ranges.begin();
+         iter != this->los_opid_ranges.end();)
+    {
+        auto& otr = iter->second;
+
+        if (otr.otr_range.tr_end < tv) {
+            iter = this->los_opid_ranges.erase(iter);
+            retval = true;
+            continue;
+        }
+
+        if (otr.otr_range.tr_begin < tv) {
+            otr.otr_range.tr_begin = tv;
+        }
+        otr.otr_sub_ops.erase(
+            std::remove_if(otr.otr_sub_ops.begin(),
+                           otr.otr_sub_ops.end(),
+                           [&tv](const auto& ostr) {
+                               return !ostr.ostr_open
+                                   && ostr.ostr_range.tr_end < tv;
+                           }),
+            otr.otr_sub_ops.end());
+        ++iter;
+    }
+
+    if (retval) {
+        for (auto iter = this->los_sub_in_use.begin();
+             iter != this->los_sub_in_use.end();)
+        {
+            if (this->los_opid_ranges.contains(iter->second)) {
+                ++iter;
+            } else {
+                iter = this->los_sub_in_use.erase(iter);
+            }
+        }
+        // Consumers hold on to the dropped opids, so they need to walk
+        // the whole map again.
+        this->los_changed_opids.clear();
+        this->los_generation += 1;
+    }
+
+    return retval;
+}
+
+void
+log_opid_state::copy_to(ArenaAlloc::Alloc<char>& alloc)
+{
+    log_opid_map opid_ranges;
+    sub_opid_map sub_in_use;
+    opid_set changed_opids;
+
+    opid_ranges.reserve(this->los_opid_ranges.size());
+    for (auto& pair : this->los_opid_ranges) {
+        opid_ranges.emplace(pair.first.to_owned(alloc),
+                            std::move(pair.second));
+    }
+    for (const auto& pair : this->los_sub_in_use) {
+        auto opid_iter = opid_ranges.find(pair.second);
+        if (opid_iter == opid_ranges.end()) {
+            continue;
+        }
+        sub_in_use.emplace(pair.first.to_owned(alloc), opid_iter->first);
+    }
+    for (auto& pair : opid_ranges) {
+        for (auto& ostr : pair.second.otr_sub_ops) {
+            auto sub_iter = sub_in_use.find(ostr.ostr_subid);
+            if (sub_iter == sub_in_use.end()) {
+                ostr.ostr_subid = ostr.ostr_subid.to_owned(alloc);
+            } else {
+                ostr.ostr_subid = sub_iter->first;
+            }
+        }
+    }
+    for (const auto& opid : this->los_changed_opids) {
+        auto opid_iter = opid_ranges.find(opid);
+        if (opid_iter != opid_ranges.end()) {
+            changed_opids.insert(opid_iter->first);
+        }
+    }
+
+    this->los_opid_ranges = std::move(opid_ranges);
+    this->los_sub_in_use = std::move(sub_in_use);
+    this->los_changed_opids = std::move(changed_opids);
+}
+
 log_opid_map::iterator
 log_opid_state::insert_op(ArenaAlloc::Alloc<char>& alloc,
                           const string_fragment& opid,
@@ -3877,7 +3986,8 @@ external_log_format::build(std::vector<lnav::console::user_message>& errors)
         }
     }
 
-    for (size_t sample_index = 0; sample_index < this->elf_samples.size();
+    for (size_t sample_index = 0;
+         !this->elf_samples_validated && sample_index < this->elf_samples.size();
          sample_index += 1)
     {
         auto& elf_sample = this->elf_samples[sample_index];
@@ -3892,7 +4002,7 @@ external_log_format::build(std::vector<lnav::console::user_message>& errors)
         }
     }
 
-    if (!this->elf_samples.empty()) {
+    if (!this->elf_samples_validated && !this->elf_samples.empty()) {
         for (const auto& elf_sample : this->elf_samples) {
             if (elf_sample.s_matched_regexes.size() <= 1) {
                 continue;
@@ -4202,6 +4312,38 @@ public:
         }
     }
 
+    std::optional<log_cursor::prescreen_literal> get_prescreen_literal(
+        int32_t col, const log_cursor::string_constraint& sc) const override
+    {
+        const auto& elf = this->elt_format;
+        auto sub_col = logline_value_meta::table_column{
+            (size_t) (col - VT_COL_MAX)};
+
+        for (const auto& vd : elf.elf_value_def_order) {
+            if (!vd->vd_meta.lvm_column.is<logline_value_meta::table_column>()
+                || !(vd->vd_meta.lvm_column
+                         .get<logline_value_meta::table_column>()
+                     == sub_col))
+            {
+                continue;
+            }
+            if (vd->vd_meta.lvm_kind != value_kind_t::VALUE_TEXT) {
+                return std::nullopt;
+            }
+
+            // Values in JSON and CSV logs can be escaped or quoted in the
+            // raw text, so only trust the characters that are never
+            // changed by those encodings.
+            if (elf.elf_type == external_log_format::elf_type_t::ELF_TYPE_TEXT)
+            {
+                return log_cursor::prescreen_literal::from(sc, "-_.:@/ ");
+            }
+            return log_cursor::prescreen_literal::from(sc, "-_.@");
+        }
+
+        return std::nullopt;
+    }
+
     bool next(log_cursor& lc, logfile_sub_source& lss) override
     {
         if (lc.is_eof()) {
@@ -4573,6 +4715,29 @@ log_format::pattern_index_for_line(uint64_t line_number) const
     return iter->pfl_pat_index;
 }
 
+void
+log_format::discard_lines(size_t count)
+{
+    if (this->lf_pattern_locks.empty() || count == 0) {
+        return;
+    }
+
+    // The lock that covers the new first line becomes the lock for line
+    // zero and anything before it can go.
+    auto iter = std::upper_bound(this->lf_pattern_locks.begin(),
+                                 this->lf_pattern_locks.end(),
+                                 count,
+                                 [](size_t line, const pattern_for_lines& pfl) {
+                                     return line < pfl.pfl_line;
+                                 });
+    --iter;
+    iter = this->lf_pattern_locks.erase(this->lf_pattern_locks.begin(), iter);
+    iter->pfl_line = 0;
+    for (++iter; iter != this->lf_pattern_locks.end(); ++iter) {
+        iter->pfl_line -= count;
+    }
+}
+
 std::string
 log_format::get_pattern_path(uint64_t line_number) const
 {
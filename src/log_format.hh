@@ -597,6 +597,12 @@ public:
 
     int pattern_index_for_line(uint64_t line_number) const;
 
+    /**
+     * Shift the pattern locks to match a logfile that has dropped the
+     * given number of lines from the front of its index.
+     */
+    void discard_lines(size_t count);
+
     bool operator<(const log_format& rhs) const
     {
         return this->get_name() < rhs.get_name();
@@ -357,6 +357,11 @@ public:
     bool elf_container{false};
     bool elf_has_module_format{false};
     bool elf_builtin_format{false};
+    /**
+     * True if the samples were checked against the patterns by a
+     * previous run with the same format sources.
+     */
+    bool elf_samples_validated{false};
 
     struct header_exprs {
         std::map<std::string, std::string> he_exprs;
@@ -106,9 +106,47 @@ using sub_opid_map = robin_hood::unordered_map<string_fragment,
                                                frag_hasher,
                                                std::equal_to<string_fragment>>;
 
+using opid_set = robin_hood::unordered_set<string_fragment,
+                                           frag_hasher,
+                                           std::equal_to<string_fragment>>;
+
 struct log_opid_state {
+    /**
+     * The number of changed opids to track before giving up and forcing
+     * consumers to walk the whole map again.
+     */
+    static constexpr size_t MAX_CHANGED_OPIDS = 64 * 1024;
+
     log_opid_map los_opid_ranges;
     sub_opid_map los_sub_in_use;
+    /**
+     * The opids that were added to or updated in los_opid_ranges since a
+     * consumer last took the changes.
+     */
+    opid_set los_changed_opids;
+    /**
+     * Incremented when the changes in los_changed_opids are no longer
+     * complete, for example, after the map is reset.
+     */
+    uint32_t los_generation{0};
+
+    void opid_changed(const string_fragment& opid);
+
+    void reset();
+
+    /**
+     * Drop the operations that ended before the given time and trim the
+     * rest so they start no earlier than it.
+     *
+     * @return True if any operations were dropped.
+     */
+    bool discard_before(const timeval& tv);
+
+    /**
+     * Copy the opids and sub-ids into the given allocator so the one they
+     * currently live in can be reset.
+     */
+    void copy_to(ArenaAlloc::Alloc<char>& alloc);
 
     log_opid_map::iterator insert_op(ArenaAlloc::Alloc<char>& alloc,
                                      const string_fragment& opid,
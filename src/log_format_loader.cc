@@ -29,6 +29,7 @@
  * @file log_format_loader.cc
  */
 
+#include <chrono>
 #include <map>
 #include <string>
 
@@ -51,6 +52,7 @@
 #include "file_format.hh"
 #include "fmt/format.h"
 #include "format.scripts.hh"
+#include "hasher.hh"
 #include "lnav_config.hh"
 #include "log_format_ext.hh"
 #include "sql_execute.hh"
@@ -1391,6 +1393,198 @@ load_from_path(const std::filesystem::path& path,
     }
 }
 
+namespace {
+
+/**
+ * The results of checking the format samples, which are saved so that
+ * later runs with the same format sources can skip the checks.
+ */
+struct format_snapshot {
+    struct pattern_state {
+        std::string ps_name;
+        int64_t ps_timestamp_end{-1};
+    };
+
+    struct format_state {
+        std::string fs_name;
+        std::vector<std::string> fs_collisions;
+        std::vector<pattern_state> fs_patterns;
+    };
+
+    std::string fsn_sources_hash;
+    std::vector<format_state> fsn_formats;
+};
+
+const json_path_container pattern_state_handlers = {
+    yajlpp::property_handler("name").for_field(
+        &format_snapshot::pattern_state::ps_name),
+    yajlpp::property_handler("timestamp-end")
+        .for_field(&format_snapshot::pattern_state::ps_timestamp_end),
+};
+
+const json_path_container format_state_handlers = {
+    yajlpp::property_handler("name").for_field(
+        &format_snapshot::format_state::fs_name),
+    yajlpp::property_handler("collisions#")
+        .for_field(&format_snapshot::format_state::fs_collisions),
+    yajlpp::property_handler("patterns#")
+        .for_field(&format_snapshot::format_state::fs_patterns)
+        .with_children(pattern_state_handlers),
+};
+
+const typed_json_path_container<format_snapshot> format_snapshot_handlers = {
+    yajlpp::property_handler("sources-hash")
+        .for_field(&format_snapshot::fsn_sources_hash),
+    yajlpp::property_handler("formats#")
+        .for_field(&format_snapshot::fsn_formats)
+        .with_children(format_state_handlers),
+};
+
+std::filesystem::path
+format_snapshot_path()
+{
+    return lnav::paths::workdir() / "format-snapshot.json";
+}
+
+/**
+ * Compute a hash over everything that the format definitions are loaded
+ * from.  The builtin formats are covered by the version and mtime of
+ * the executable.
+ */
+std::string
+format_sources_hash(const std::vector<std::filesystem::path>& extra_paths)
+{
+    hasher h;
+
+    h.update(std::string(PACKAGE_VERSION));
+    h.update((int64_t) lnav::filesystem::self_mtime());
+    for (const auto& extra_path : extra_paths) {
+        auto format_path = extra_path / "formats/*/*.json";
+        static_root_mem<glob_t, globfree> gl;
+
+        if (glob(format_path.c_str(), 0, nullptr, gl.inout()) != 0) {
+            continue;
+        }
+        for (size_t lpc = 0; lpc < gl->gl_pathc; lpc++) {
+            struct stat st;
+
+            if (stat(gl->gl_pathv[lpc], &st) == -1) {
+                continue;
+            }
+            h.update(gl->gl_pathv[lpc], strlen(gl->gl_pathv[lpc]));
+            h.update((int64_t) st.st_size);
+            h.update((int64_t) st.st_mtime);
+        }
+    }
+
+    return h.to_string();
+}
+
+std::optional<format_snapshot>
+read_format_snapshot(const std::string& sources_hash)
+{
+    static const auto SNAPSHOT_SRC = intern_string::lookup("format-snapshot");
+
+    auto read_res = lnav::filesystem::read_file(format_snapshot_path());
+    if (read_res.isErr()) {
+        log_info("no format snapshot: %s", read_res.unwrapErr().c_str());
+        return std::nullopt;
+    }
+
+    auto parse_res = format_snapshot_handlers.parser_for(SNAPSHOT_SRC)
+                         .of(read_res.unwrap());
+    if (parse_res.isErr()) {
+        log_warning("unable to parse format snapshot");
+        return std::nullopt;
+    }
+
+    auto retval = parse_res.unwrap();
+    if (retval.fsn_sources_hash != sources_hash) {
+        log_info("format sources have changed, ignoring snapshot");
+        return std::nullopt;
+    }
+
+    return retval;
+}
+
+/**
+ * Copy the results of the sample checks from the snapshot into the
+ * formats.  The snapshot is only used if it covers every format.
+ */
+bool
+apply_format_snapshot(const format_snapshot& snapshot,
+                      log_formats_map_t& formats)
+{
+    if (snapshot.fsn_formats.size() != formats.size()) {
+        return false;
+    }
+
+    for (const auto& fs : snapshot.fsn_formats) {
+        auto iter = formats.find(intern_string::lookup(fs.fs_name));
+        if (iter == formats.end()) {
+            return false;
+        }
+        for (const auto& ps : fs.fs_patterns) {
+            if (iter->second->elf_patterns.count(ps.ps_name) == 0) {
+                return false;
+            }
+        }
+    }
+
+    for (const auto& fs : snapshot.fsn_formats) {
+        auto& elf = formats[intern_string::lookup(fs.fs_name)];
+
+        elf->elf_samples_validated = true;
+        for (const auto& coll : fs.fs_collisions) {
+            elf->elf_collision.push_back(intern_string::lookup(coll));
+        }
+        for (const auto& ps : fs.fs_patterns) {
+            elf->elf_patterns[ps.ps_name]->p_timestamp_end
+                = ps.ps_timestamp_end;
+        }
+    }
+
+    return true;
+}
+
+void
+write_format_snapshot(const std::string& sources_hash,
+                      const log_formats_map_t& formats)
+{
+    format_snapshot snapshot;
+
+    snapshot.fsn_sources_hash = sources_hash;
+    for (const auto& format_pair : formats) {
+        const auto& elf = format_pair.second;
+        format_snapshot::format_state fs;
+
+        fs.fs_name = format_pair.first.to_string();
+        for (const auto& coll : elf->elf_collision) {
+            fs.fs_collisions.emplace_back(coll.to_string());
+        }
+        for (const auto& pat_pair : elf->elf_patterns) {
+            fs.fs_patterns.emplace_back(format_snapshot::pattern_state{
+                pat_pair.first,
+                pat_pair.second->p_timestamp_end,
+            });
+        }
+        snapshot.fsn_formats.emplace_back(std::move(fs));
+    }
+
+    auto path = format_snapshot_path();
+    std::error_code errc;
+    std::filesystem::create_directories(path.parent_path(), errc);
+    auto write_res = lnav::filesystem::write_file(
+        path, format_snapshot_handlers.to_string(snapshot));
+    if (write_res.isErr()) {
+        log_warning("unable to write format snapshot: %s -- %s",
+                    path.c_str(),
+                    write_res.unwrapErr().c_str());
+    }
+}
+
+}  // namespace
+
 void
 load_formats(const std::vector<std::filesystem::path>& extra_paths,
              std::vector<lnav::console::user_message>& errors)
@@ -1427,6 +1621,13 @@ load_formats(const std::vector<std::filesystem::path>& extra_paths,
 
     uint8_t mod_counter = 0;
 
+    auto build_start = std::chrono::steady_clock::now();
+    auto sources_hash = format_sources_hash(extra_paths);
+    auto snapshot_opt = read_format_snapshot(sources_hash);
+    auto used_snapshot = snapshot_opt.has_value()
+        && apply_format_snapshot(snapshot_opt.value(), LOG_FORMATS);
+    auto errors_before = errors.size();
+
     std::vector<std::shared_ptr<external_log_format>> alpha_ordered_formats;
     for (auto iter = LOG_FORMATS.begin(); iter != LOG_FORMATS.end(); ++iter) {
         auto& elf = iter->second;
@@ -1437,6 +1638,11 @@ load_formats(const std::vector<std::filesystem::path>& extra_paths,
             elf->lf_mod_index = mod_counter;
         }
 
+        alpha_ordered_formats.push_back(elf);
+        if (used_snapshot) {
+            continue;
+        }
+
         for (auto& check_iter : LOG_FORMATS) {
             if (iter->first == check_iter.first) {
                 continue;
@@ -1451,9 +1657,18 @@ load_formats(const std::vector<std::filesystem::path>& extra_paths,
                 elf->elf_collision.push_back(check_elf->get_name());
             }
         }
+    }
 
-        alpha_ordered_formats.push_back(elf);
+    if (!used_snapshot && errors.size() == errors_before) {
+        // Only save the results when there were no messages, since the
+        // messages would not be reported again by later runs.
+        write_format_snapshot(sources_hash, LOG_FORMATS);
     }
+    log_info("built formats in %lld ms (snapshot %s)",
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - build_start)
+                 .count(),
+             used_snapshot ? "used" : "not used");
 
     auto& graph_ordered_formats = external_log_format::GRAPH_ORDERED_FORMATS;
 
@@ -316,6 +316,17 @@ log_vtab_impl::is_valid(log_cursor& lc, logfile_sub_source& lss)
         return false;
     }
 
+    if (!lc.lc_prescreen_literals.empty()) {
+        lf->read_full_message(lf_iter, this->vi_prescreen_sbr);
+        auto msg_sf = this->vi_prescreen_sbr.to_string_fragment();
+        for (const auto& pl : lc.lc_prescreen_literals) {
+            if (!pl.matches(msg_sf)) {
+                lc.lc_prescreened_rows += 1;
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -489,7 +500,9 @@ vt_eof(sqlite3_vtab_cursor* cur)
 }
 
 static void
-populate_indexed_columns(vtab_cursor* vc, log_vtab* vt)
+populate_indexed_columns(vtab_cursor* vc,
+                         log_vtab_impl& vi,
+                         logfile_sub_source& lss)
 {
     if (vc->log_cursor.is_eof() || vc->log_cursor.lc_indexed_columns.empty()) {
         return;
@@ -498,7 +511,12 @@ populate_indexed_columns(vtab_cursor* vc, log_vtab* vt)
     logfile* lf = nullptr;
 
     for (const auto& ic : vc->log_cursor.lc_indexed_columns) {
-        auto& ci = vt->vi->vi_column_indexes[ic.cc_column];
+        auto ci_iter = vi.vi_column_indexes.find(ic.cc_column);
+        if (ci_iter == vi.vi_column_indexes.end()) {
+            continue;
+        }
+
+        auto& ci = ci_iter->second;
         const auto vl = vc->log_cursor.lc_curr_line;
 
         if (ci.ci_indexed_range.contains(vl)) {
@@ -507,15 +525,15 @@ populate_indexed_columns(vtab_cursor* vc, log_vtab* vt)
         }
 
         if (lf == nullptr) {
-            const auto cl = vt->lss->at(vl);
+            const auto cl = lss.at(vl);
             uint64_t line_number;
-            auto ld = vt->lss->find_data(cl, line_number);
+            auto ld = lss.find_data(cl, line_number);
             lf = (*ld)->get_file_ptr();
             auto ll = lf->begin() + line_number;
 
             vc->cache_msg(lf, ll);
             require(vc->line_values.lvv_sbr.get_data() != nullptr);
-            vt->vi->extract(lf, line_number, vc->line_values);
+            vi.extract(lf, line_number, vc->line_values);
         }
 
         auto sub_col = logline_value_meta::table_column{
@@ -598,8 +616,14 @@ vt_next(sqlite3_vtab_cursor* cur)
                      vc->log_cursor.lc_end_line,
                      vc->log_cursor.lc_direction,
                      vc->log_cursor.lc_scanned_rows);
+            if (vc->log_cursor.lc_prescreened_rows > 0) {
+                log_info("  rows rejected by prescreen %lu",
+                         vc->log_cursor.lc_prescreened_rows);
+            }
+            log_info("  rows visited %lu", vc->log_cursor.lc_visited_rows);
             done = true;
         } else {
+            vc->log_cursor.lc_visited_rows += 1;
             done = vt->vi->next(vc->log_cursor, *vt->lss);
             if (done) {
                 if (vc->log_cursor.lc_curr_line % 10000 == 0) {
@@ -609,7 +633,7 @@ vt_next(sqlite3_vtab_cursor* cur)
                 log_debug("scanned %d", vc->log_cursor.lc_curr_line);
 #endif
                 vc->log_cursor.lc_scanned_rows += 1;
-                populate_indexed_columns(vc, vt);
+                populate_indexed_columns(vc, *vt->vi, *vt->lss);
                 vt->vi->expand_indexes_to(vc->log_cursor.lc_indexed_columns,
                                           vc->log_cursor.lc_curr_line);
             } else {
@@ -656,13 +680,14 @@ vt_next_no_rowid(sqlite3_vtab_cursor* cur)
         }
 
         auto vl_before = vc->log_cursor.lc_curr_line;
+        vc->log_cursor.lc_visited_rows += 1;
         done = vt->vi->next(vc->log_cursor, *vt->lss);
         if (vl_before != vc->log_cursor.lc_curr_line) {
             vt->vi->expand_indexes_to(vc->log_cursor.lc_indexed_columns,
                                       vl_before);
         }
         if (done) {
-            populate_indexed_columns(vc, vt);
+            populate_indexed_columns(vc, *vt->vi, *vt->lss);
         } else if (vc->log_cursor.is_eof()) {
             done = true;
         } else {
@@ -699,6 +724,86 @@ vt_next_no_rowid(sqlite3_vtab_cursor* cur)
     return SQLITE_OK;
 }
 
+bool
+log_vtab_impl::build_column_indexes(logfile_sub_source& lss,
+                                    const std::vector<int32_t>& cols)
+{
+    vtab_cursor vc;
+    auto& lc = vc.log_cursor;
+    const auto line_count = vis_line_t(lss.text_line_count());
+
+    lc.lc_curr_line = 0_vl;
+    lc.lc_direction = 1_vl;
+    lc.lc_end_line = line_count;
+    lc.lc_sub_index = 0;
+    for (const auto col : cols) {
+        auto& coli = this->vi_column_indexes[col];
+
+        if (coli.ci_index_generation == lss.lss_index_generation
+            && line_count > 0_vl && coli.ci_indexed_range.contains(0_vl)
+            && coli.ci_indexed_range.contains(line_count - 1_vl))
+        {
+            continue;
+        }
+
+        // A partial index might not be contiguous with this scan, so
+        // start it over.
+        coli.ci_value_to_lines.clear();
+        coli.ci_index_generation = lss.lss_index_generation;
+        coli.ci_indexed_range = msg_range::empty();
+        coli.ci_string_arena.reset();
+        lc.lc_indexed_columns.emplace_back(
+            col,
+            log_cursor::string_constraint{SQLITE_INDEX_CONSTRAINT_EQ, ""});
+    }
+
+    if (lc.lc_indexed_columns.empty()) {
+        return true;
+    }
+
+    for (auto& ld : lss) {
+        auto* lf = ld->get_file_ptr();
+
+        if (lf != nullptr) {
+            lf->enable_cache();
+        }
+    }
+
+    // Tables with a primary key, like the search tables, can have more
+    // than one row for a message.
+    std::vector<std::string> primary_keys;
+    this->get_primary_keys(primary_keys);
+    const auto multiple_rows = !primary_keys.empty();
+
+    log_info("building %zu column index(es) for %s",
+             lc.lc_indexed_columns.size(),
+             this->vi_name.get());
+    while (!lc.is_eof()) {
+        log_cursor_latest = lc;
+        if ((lc.lc_curr_line % 1024) == 0
+            && log_vtab_data.lvd_progress != nullptr
+            && log_vtab_data.lvd_progress(log_cursor_latest))
+        {
+            return false;
+        }
+
+        if (this->is_valid(lc, lss)) {
+            do {
+                vc.invalidate();
+                if (!this->next(lc, lss)) {
+                    break;
+                }
+                populate_indexed_columns(&vc, *this, lss);
+            } while (multiple_rows);
+        }
+        this->expand_indexes_to(lc.lc_indexed_columns, lc.lc_curr_line);
+        lc.lc_curr_line += 1_vl;
+        lc.lc_sub_index = 0;
+    }
+
+    return true;
+}
+
 static int
 vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
 {
@@ -1415,6 +1520,106 @@ log_cursor::string_constraint::matches(const std::string& sf) const
     }
 }
 
+std::optional<log_cursor::prescreen_literal>
+log_cursor::prescreen_literal::from(const string_constraint& sc,
+                                    const char* plain_punct)
+{
+    const char* wildcards;
+    switch (sc.sc_op) {
+        case SQLITE_INDEX_CONSTRAINT_LIKE:
+            wildcards = "%_";
+            break;
+        case SQLITE_INDEX_CONSTRAINT_GLOB:
+            wildcards = "*?[";
+            break;
+        default:
+            return std::nullopt;
+    }
+
+    auto is_plain = [wildcards, plain_punct](char ch) {
+        if (isascii(ch) && isalnum(ch)) {
+            return true;
+        }
+        return strchr(wildcards, ch) == nullptr
+            && strchr(plain_punct, ch) != nullptr;
+    };
+
+    // A GLOB bracket expression, like "[0-9]" or "[^abc]", matches a single
+    // character, so none of the characters inside it are literal.  Returns
+    // the index after the closing bracket.
+    auto skip_bracket = [&sc](size_t start) {
+        auto end = start + 1;
+
+        if (end < sc.sc_value.size() && sc.sc_value[end] == '^') {
+            end += 1;
+        }
+        if (end < sc.sc_value.size() && sc.sc_value[end] == ']') {
+            end += 1;
+        }
+        while (end < sc.sc_value.size() && sc.sc_value[end] != ']') {
+            end += 1;
+        }
+
+        return std::min(end + 1, sc.sc_value.size());
+    };
+
+    // A pattern with a wildcard inside a run would not be a literal, so
+    // find the longest run that consists of only plain characters.
+    size_t best_start = 0, best_len = 0;
+    for (size_t start = 0; start < sc.sc_value.size();) {
+        if (sc.sc_op == SQLITE_INDEX_CONSTRAINT_GLOB
+            && sc.sc_value[start] == '[')
+        {
+            start = skip_bracket(start);
+            continue;
+        }
+        if (!is_plain(sc.sc_value[start])) {
+            start += 1;
+            continue;
+        }
+        auto end = start;
+        while (end < sc.sc_value.size() && is_plain(sc.sc_value[end])) {
+            end += 1;
+        }
+        if (end - start > best_len) {
+            best_start = start;
+            best_len = end - start;
+        }
+        start = end;
+    }
+
+    if (best_len < 3) {
+        return std::nullopt;
+    }
+
+    return prescreen_literal{
+        sc.sc_value.substr(best_start, best_len),
+        sc.sc_op == SQLITE_INDEX_CONSTRAINT_LIKE,
+    };
+}
+
+bool
+log_cursor::prescreen_literal::matches(string_fragment sf) const
+{
+    if (this->pl_ignore_case) {
+        return std::search(sf.begin(),
+                           sf.end(),
+                           this->pl_value.begin(),
+                           this->pl_value.end(),
+                           [](char lhs, char rhs) {
+                               return tolower((unsigned char) lhs)
+                                   == tolower((unsigned char) rhs);
+                           })
+            != sf.end();
+    }
+
+    return std::search(sf.begin(),
+                       sf.end(),
+                       this->pl_value.begin(),
+                       this->pl_value.end())
+        != sf.end();
+}
+
 struct vtab_time_range {
     std::optional<timeval> vtr_begin;
     std::optional<timeval> vtr_end;
@@ -1489,6 +1694,10 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
         p_cur->log_cursor.lc_end_line = vis_line_t(vt->lss->text_line_count());
     }
     p_cur->log_cursor.lc_scanned_rows = 0;
+    p_cur->log_cursor.lc_visited_rows = 0;
+    p_cur->log_cursor.lc_prescreened_rows = 0;
+    p_cur->log_cursor.lc_indexed_columns.clear();
+    p_cur->log_cursor.lc_prescreen_literals.clear();
     p_cur->log_cursor.lc_indexed_lines.clear();
     p_cur->log_cursor.lc_indexed_lines_range = msg_range::empty();
 
@@ -1749,7 +1958,29 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
                     const auto* value
                         = (const char*) sqlite3_value_text(argv[lpc]);
 
-                    if (value != nullptr) {
+                    if (value != nullptr
+                        && (op == SQLITE_INDEX_CONSTRAINT_LIKE
+                            || op == SQLITE_INDEX_CONSTRAINT_GLOB))
+                    {
+                        auto value_len
+                            = (size_t) sqlite3_value_bytes(argv[lpc]);
+                        auto pl_opt = vt->vi->get_prescreen_literal(
+                            col,
+                            log_cursor::string_constraint{
+                                op,
+                                std::string{value, value_len},
+                            });
+
+                        if (pl_opt) {
+                            log_info("  prescreening column %d %s %s with %s",
+                                     col,
+                                     sql_constraint_op_name(op),
+                                     value,
+                                     pl_opt->pl_value.c_str());
+                            p_cur->log_cursor.lc_prescreen_literals.emplace_back(
+                                std::move(pl_opt.value()));
+                        }
+                    } else if (value != nullptr) {
                         auto value_len
                             = (size_t) sqlite3_value_bytes(argv[lpc]);
 
@@ -1806,7 +2037,7 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
         }
 
         for (const auto& icol : p_cur->log_cursor.lc_indexed_columns) {
-            const auto& coli = vt->vi->vi_column_indexes[icol.cc_column];
+            const auto& coli = vt->vi->vi_column_indexes.at(icol.cc_column);
 
             auto iter
                 = coli.ci_value_to_lines.find(icol.cc_constraint.sc_value);
@@ -1873,7 +2104,13 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
                     for (const auto& icol :
                          p_cur->log_cursor.lc_indexed_columns)
                     {
-                        vt->vi->vi_column_indexes.erase(icol.cc_column);
+                        // Start the index over, the scan will fill it in.
+                        auto& coli = vt->vi->vi_column_indexes.at(
+                            icol.cc_column);
+
+                        coli.ci_value_to_lines.clear();
+                        coli.ci_indexed_range = msg_range::empty();
+                        coli.ci_string_arena.reset();
                     }
                     p_cur->log_cursor.lc_indexed_lines.clear();
                     p_cur->log_cursor.lc_indexed_lines_range
@@ -1904,6 +2141,15 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
                                 = index_valid_opt->v_max_line;
                         }
                     }
+                } else if (p_cur->log_cursor.lc_direction > 0
+                           && index_valid_opt->v_min_line
+                               <= scan_range.v_min_line)
+                {
+                    // The index covers the start of the scan, so only the
+                    // lines appended since it was built need to be scanned.
+                    log_debug("  scanning from the end of the index");
+                    p_cur->log_cursor.lc_indexed_lines.push_back(
+                        index_valid_opt->v_max_line);
                 }
             } else {
                 log_debug("  min_index_range::empty");
@@ -2026,6 +2272,7 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
     std::vector<sqlite3_index_info::sqlite3_index_constraint> indexes;
     std::vector<std::string> index_desc;
     int argvInUse = 0;
+    int prescreen_count = 0;
     auto* vt = (log_vtab*) tab;
     char direction = 1;
 
@@ -2190,6 +2437,19 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
                         fmt::format(FMT_STRING("col({}) {} ?"),
                                     col,
                                     sql_constraint_op_name(op)));
+                } else if (op == SQLITE_INDEX_CONSTRAINT_LIKE
+                           || op == SQLITE_INDEX_CONSTRAINT_GLOB)
+                {
+                    // The constraint is not omitted, SQLite will still
+                    // check the rows that make it past the prescreen.
+                    argvInUse += 1;
+                    prescreen_count += 1;
+                    indexes.push_back(constraint);
+                    p_info->aConstraintUsage[lpc].argvIndex = argvInUse;
+                    index_desc.emplace_back(
+                        fmt::format(FMT_STRING("prescreen col({}) {} ?"),
+                                    col,
+                                    sql_constraint_op_name(op)));
                 }
                 break;
             }
@@ -2228,7 +2488,13 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
         p_info->idxNum = argvInUse;
         p_info->idxStr = static_cast<char*>(storage);
         p_info->needToFreeIdxStr = 1;
-        p_info->estimatedCost = 10.0;
+        if (prescreen_count == argvInUse) {
+            // A prescreen still visits every row, so it should not look
+            // as cheap as a real index when planning joins.
+            p_info->estimatedCost = 500000000.0;
+        } else {
+            p_info->estimatedCost = 10.0;
+        }
     } else {
         static char fullscan_asc[] = "fullscan\0\001";
         static char fullscan_desc[] = "fullscan\0\377";
@@ -211,6 +211,26 @@ struct log_cursor {
         string_constraint cc_constraint;
     };
 
+    /**
+     * A string that must be in the raw text of a message for it to
+     * satisfy a constraint on one of the format's columns.  Messages
+     * without the literal are skipped before they are annotated.
+     */
+    struct prescreen_literal {
+        std::string pl_value;
+        bool pl_ignore_case{false};
+
+        /**
+         * Extract the longest run of characters from a LIKE or GLOB
+         * pattern that does not contain a wildcard or any character
+         * that is not in the given set of punctuation.
+         */
+        static std::optional<prescreen_literal> from(
+            const string_constraint& sc, const char* plain_punct);
+
+        bool matches(string_fragment sf) const;
+    };
+
     vis_line_t lc_curr_line;
     int lc_sub_index;
     vis_line_t lc_end_line;
@@ -233,7 +253,11 @@ struct log_cursor {
     std::vector<vis_line_t> lc_indexed_lines;
     msg_range lc_indexed_lines_range = msg_range::empty();
 
+    std::vector<prescreen_literal> lc_prescreen_literals;
+
     size_t lc_scanned_rows{0};
+    size_t lc_visited_rows{0};
+    size_t lc_prescreened_rows{0};
 
     enum class constraint_t {
         none,
@@ -328,6 +352,16 @@ public:
                          uint64_t line_number,
                          logline_value_vector& values);
 
+    /**
+     * @return The literal that must be in the raw text of a message for
+     *   the given constraint on a format column to be satisfied.
+     */
+    virtual std::optional<log_cursor::prescreen_literal> get_prescreen_literal(
+        int32_t col, const log_cursor::string_constraint& sc) const
+    {
+        return std::nullopt;
+    }
+
     struct column_index {
         robin_hood::
             unordered_map<string_fragment, std::deque<vis_line_t>, frag_hasher>
@@ -340,13 +374,28 @@ public:
 
     std::map<int32_t, column_index> vi_column_indexes;
 
+    /**
+     * Build the indexes for the given columns in one pass over the
+     * messages, instead of waiting for a query with a constraint on them.
+     * Indexes that already cover every message are left as they are.
+     *
+     * @param lss The source the table is scanning.
+     * @param cols The column numbers, which start at VT_COL_MAX.
+     * @return False if the scan was interrupted by the progress callback.
+     */
+    bool build_column_indexes(logfile_sub_source& lss,
+                              const std::vector<int32_t>& cols);
+
     void expand_indexes_to(
         const std::vector<log_cursor::column_constraint>& cons,
         const vis_line_t vl)
     {
         for (const auto& cc : cons) {
-            this->vi_column_indexes[cc.cc_column].ci_indexed_range.expand_to(
-                vl);
+            auto iter = this->vi_column_indexes.find(cc.cc_column);
+
+            if (iter != this->vi_column_indexes.end()) {
+                iter->second.ci_indexed_range.expand_to(vl);
+            }
         }
     }
 
@@ -354,6 +403,7 @@ public:
     bool vi_supports_indexes{true};
     int vi_column_count{0};
     string_attrs_t vi_attrs;
+    shared_buffer_ref vi_prescreen_sbr;
 
 protected:
     const intern_string_t vi_name;
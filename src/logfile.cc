@@ -45,6 +45,7 @@
 #include "base/attr_line.builder.hh"
 #include "base/date_time_scanner.cfg.hh"
 #include "base/fs_util.hh"
+#include "base/humanize.hh"
 #include "base/injector.hh"
 #include "base/snippet_highlighters.hh"
 #include "base/string_util.hh"
@@ -344,9 +345,10 @@ logfile::process_prefix(shared_buffer_ref& sbr,
     size_t prescan_size = this->lf_index.size();
     auto prescan_time = std::chrono::microseconds{0};
     bool retval = false;
+    auto lines_indexed = this->lf_discarded_lines + this->lf_index.size();
 
     if (this->lf_options.loo_detect_format
-        && (this->lf_format == nullptr || this->lf_index.size() < 250))
+        && (this->lf_format == nullptr || lines_indexed < 250))
     {
         const auto& root_formats = log_format::get_root_formats();
         std::optional<std::pair<log_format*, log_format::scan_match>>
@@ -371,7 +373,7 @@ logfile::process_prefix(shared_buffer_ref& sbr,
         auto starting_index_size = this->lf_index.size();
         size_t prev_index_size = this->lf_index.size();
         for (const auto& curr : root_formats) {
-            if (this->lf_index.size()
+            if (this->lf_discarded_lines + this->lf_index.size()
                 >= curr->lf_max_unrecognized_lines.value_or(
                     max_unrecognized_lines))
             {
@@ -740,6 +742,7 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
             opid_iter->second.otr_range.extend_to(ll.get_timeval());
             opid_iter->second.otr_level_stats.update_msg_count(
                 ll.get_msg_level());
+            writeOpids->opid_changed(opid_iter->first);
         }
         this->lf_invalidated_opids.clear();
     }
@@ -768,8 +771,7 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
             safe::WriteAccess<logfile::safe_opid_state> writable_opid_map(
                 this->lf_opids);
 
-            writable_opid_map->los_opid_ranges.clear();
-            writable_opid_map->los_sub_in_use.clear();
+            writable_opid_map->reset();
         }
         this->lf_allocator.reset();
     }
@@ -1223,10 +1225,13 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
                     = writable_opid_map->los_opid_ranges.find(opid_pair.first);
 
                 if (opid_iter == writable_opid_map->los_opid_ranges.end()) {
-                    writable_opid_map->los_opid_ranges.emplace(opid_pair);
+                    opid_iter = writable_opid_map->los_opid_ranges
+                                    .emplace(opid_pair)
+                                    .first;
                 } else {
                     opid_iter->second |= opid_pair.second;
                 }
+                writable_opid_map->opid_changed(opid_iter->first);
             }
             log_debug(
                 "%s: opid_map size: count=%zu; sizeof(otr)=%zu; alloc=%zu",
@@ -1242,7 +1247,7 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
             retval = rebuild_result_t::NEW_LINES;
         }
 
-        {
+        if (!this->lf_options.loo_streaming) {
             auto est_rem = this->estimated_remaining_lines();
             if (est_rem > 0) {
                 this->lf_index.reserve(this->lf_index.size() + est_rem);
@@ -1382,6 +1387,95 @@ logfile::set_logline_observer(logline_observer* llo)
     }
 }
 
+void
+logfile::discard_lines(size_t count)
+{
+    require_lt(count, this->lf_index.size());
+
+    this->lf_index.erase(this->lf_index.begin(),
+                         this->lf_index.begin() + count);
+    this->lf_discarded_lines += count;
+
+    if (!this->lf_bookmark_metadata.empty()) {
+        robin_hood::unordered_map<uint32_t, bookmark_metadata> shifted;
+
+        for (auto& bm_pair : this->lf_bookmark_metadata) {
+            if (bm_pair.first < count) {
+                continue;
+            }
+            shifted.emplace(bm_pair.first - count, std::move(bm_pair.second));
+        }
+        this->lf_bookmark_metadata = std::move(shifted);
+    }
+    if (this->lf_time_offset_line > 0) {
+        this->lf_time_offset_line = std::max(
+            0, this->lf_time_offset_line - static_cast<int>(count));
+    }
+    if (this->lf_format != nullptr) {
+        this->lf_format->discard_lines(count);
+    }
+
+    auto write_opids = this->lf_opids.writeAccess();
+    if (!write_opids->discard_before(this->lf_index.front().get_timeval())) {
+        return;
+    }
+
+    // The opids for the dropped operations are still taking up space in
+    // the arena, so move the survivors out, reset it, and move them back.
+    ArenaAlloc::Alloc<char> scratch{64 * 1024};
+    auto copy_invalidated = [this](ArenaAlloc::Alloc<char>& alloc) {
+        decltype(this->lf_invalidated_opids) invalidated;
+
+        for (const auto& opid : this->lf_invalidated_opids) {
+            invalidated.insert(opid.to_owned(alloc));
+        }
+        this->lf_invalidated_opids = std::move(invalidated);
+    };
+
+    write_opids->copy_to(scratch);
+    copy_invalidated(scratch);
+    this->lf_allocator.reset();
+    write_opids->copy_to(this->lf_allocator);
+    copy_invalidated(this->lf_allocator);
+}
+
+size_t
+logfile::lines_outside_retention(std::chrono::seconds max_age,
+                                 uint64_t max_size) const
+{
+    if (this->lf_index.size() < 2
+        || (max_age.count() == 0 && max_size == 0))
+    {
+        return 0;
+    }
+
+    const auto last_time
+        = this->lf_index.back().get_time<std::chrono::microseconds>();
+    const auto limit = this->lf_index.size() - 1;
+    size_t retval = 0;
+
+    while (retval < limit) {
+        const auto& ll = this->lf_index[retval];
+        auto too_old = max_age.count() > 0
+            && ll.get_time<std::chrono::microseconds>() + max_age < last_time;
+        auto too_big = max_size > 0
+            && static_cast<uint64_t>(this->lf_index_size - ll.get_offset())
+                > max_size;
+
+        if (!too_old && !too_big) {
+            break;
+        }
+        retval += 1;
+    }
+
+    /* Keep the whole message that straddles the limit. */
+    while (retval > 0 && this->lf_index[retval].is_continued()) {
+        retval -= 1;
+    }
+
+    return retval;
+}
+
 void
 logfile::reobserve_from(iterator iter)
 {
@@ -1518,6 +1612,56 @@ logfile::mark_as_duplicate(const std::string& name)
     return true;
 }
 
+void
+logfile::set_remote_elided(std::vector<logfile_remote_gap> gaps)
+{
+    safe::WriteAccess<safe_notes> notes(this->lf_notes);
+    int64_t elided_bytes = 0;
+
+    this->lf_remote_gaps = std::move(gaps);
+    for (const auto& gap : this->lf_remote_gaps) {
+        elided_bytes += gap.lrg_length;
+    }
+    if (elided_bytes == 0) {
+        notes->erase(note_type::remote_filtered);
+        return;
+    }
+
+    auto note_um
+        = lnav::console::user_message::warning(
+              "only the lines that passed the filters were transferred")
+              .with_reason(
+                  attr_line_t()
+                      .append(lnav::roles::number(humanize::file_size(
+                          elided_bytes, humanize::alignment::none)))
+                      .appendf(FMT_STRING(" in {} range(s) of the remote file "
+                                          "were left out by the tailer"),
+                               this->lf_remote_gaps.size()))
+              .with_help(attr_line_t("disable ")
+                             .append("/tuning/remote/filter-pushdown"_symbol)
+                             .append(" to transfer the whole file"))
+              .move();
+    (*notes)[note_type::remote_filtered] = note_um;
+}
+
+int64_t
+logfile::remote_elided_before(file_off_t offset) const
+{
+    auto iter = std::lower_bound(
+        this->lf_remote_gaps.begin(),
+        this->lf_remote_gaps.end(),
+        offset,
+        [](const logfile_remote_gap& gap, file_off_t off) {
+            return gap.lrg_offset < off;
+        });
+
+    if (iter == this->lf_remote_gaps.end() || iter->lrg_offset != offset) {
+        return 0;
+    }
+
+    return iter->lrg_length;
+}
+
 void
 logfile::adjust_content_time(int line, const timeval& tv, bool abs_offset)
 {
@@ -1666,6 +1810,7 @@ logfile::set_logline_opid(uint32_t line_number, string_fragment opid)
     auto& otr = opid_iter->second;
 
     otr.otr_level_stats.update_msg_count(ll.get_msg_level());
+    write_opids->opid_changed(opid_iter->first);
     ll.set_opid(opid.hash());
     this->lf_bookmark_metadata[line_number].bm_opid = opid.to_string();
 }
@@ -1706,10 +1851,12 @@ logfile::clear_logline_opid(uint32_t line_number)
         {
             otr_iter->second.otr_level_stats.update_msg_count(
                 ll.get_msg_level(), -1);
+            writeOpids->opid_changed(otr_iter->first);
             return;
         }
 
         otr_iter->second.clear();
+        writeOpids->opid_changed(otr_iter->first);
         this->lf_invalidated_opids.insert(opid_sf);
     }
 }
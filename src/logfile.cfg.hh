@@ -32,10 +32,17 @@
 #ifndef lnav_logfile_cfg_hh
 #define lnav_logfile_cfg_hh
 
+#include <chrono>
+#include <cstdint>
+
 namespace lnav::logfile {
 
 struct config {
     uint64_t lc_max_unrecognized_lines{1000};
+    /** Discard log messages older than this, zero means keep everything. */
+    std::chrono::seconds lc_retention_max_age{0};
+    /** Discard log messages once a file grows past this many bytes. */
+    uint64_t lc_retention_max_size{0};
 };
 
 }  // namespace lnav::logfile
@@ -212,6 +212,20 @@ public:
 
     bool mark_as_duplicate(const std::string& name);
 
+    /**
+     * Record that the remote tailer left parts of this file out because
+     * the lines did not pass the filters that were pushed down to it.
+     *
+     * @param gaps The gaps in the local copy, sorted by offset.
+     */
+    void set_remote_elided(std::vector<logfile_remote_gap> gaps);
+
+    /**
+     * @return The number of bytes of the remote file that were left out
+     * right before the line at the given offset in the local copy.
+     */
+    int64_t remote_elided_before(file_off_t offset) const;
+
     const logfile_open_options& get_open_options() const
     {
         return this->lf_options;
@@ -353,6 +367,35 @@ public:
 
     void reobserve_from(iterator iter);
 
+    /**
+     * Drop the given number of lines from the front of the index.  This is
+     * used when streaming a file so that only a window of the index is kept
+     * in memory.  The lines after the ones that were dropped keep their
+     * offsets into the file, so indexing can continue as usual.
+     *
+     * @param count The number of lines to drop, which must be less than the
+     *   number of lines in the index.
+     */
+    void discard_lines(size_t count);
+
+    /** @return The number of lines dropped by discard_lines(). */
+    size_t get_discarded_lines() const { return this->lf_discarded_lines; }
+
+    /**
+     * Count the lines at the front of the index that fall outside of the
+     * given retention limits.  The count always ends on a message boundary
+     * and never includes the last message in the file.
+     *
+     * @param max_age Lines older than this, relative to the last line, are
+     *   outside the limit.  Zero means no age limit.
+     * @param max_size Lines that start more than this many bytes before the
+     *   end of the indexed content are outside the limit.  Zero means no
+     *   size limit.
+     * @return The number of lines that can be passed to discard_lines().
+     */
+    size_t lines_outside_retention(std::chrono::seconds max_age,
+                                   uint64_t max_size) const;
+
     void set_logfile_observer(logfile_observer* lo)
     {
         this->lf_logfile_observer = lo;
@@ -398,6 +441,7 @@ public:
         indexing_disabled,
         duplicate,
         not_utf,
+        remote_filtered,
     };
 
     using note_map = std::map<note_type, lnav::console::user_message>;
@@ -496,6 +540,7 @@ private:
     std::shared_ptr<log_format> lf_format;
     uint32_t lf_format_quality{0};
     std::vector<logline> lf_index;
+    size_t lf_discarded_lines{0};
     std::chrono::microseconds lf_index_time{0};
     file_off_t lf_index_size{0};
     int lf_index_generation{0};
@@ -517,6 +562,7 @@ private:
     text_format_t lf_text_format{text_format_t::TF_UNKNOWN};
     uint32_t lf_out_of_time_order_count{0};
     safe_notes lf_notes;
+    std::vector<logfile_remote_gap> lf_remote_gaps;
     safe_opid_state lf_opids;
     size_t lf_watch_count{0};
     ArenaAlloc::Alloc<char> lf_allocator{64 * 1024};
@@ -58,6 +58,39 @@ enum class logfile_name_source {
 
 using file_location_t = mapbox::util::variant<vis_line_t, std::string>;
 
+/** A part of a remote file that was left out by the tailer's filter. */
+struct logfile_remote_gap {
+    /** The offset in the local copy of the line that follows the gap. */
+    int64_t lrg_offset{0};
+    /** The number of bytes of the remote file that were left out. */
+    int64_t lrg_length{0};
+};
+
+/**
+ * Predicates that are pushed down to the tailer for a remote file so that
+ * only the lines that could pass the local filters are transferred.
+ */
+struct logfile_remote_filter {
+    /** Files last modified before this time are not transferred. */
+    time_t lrf_min_mtime{0};
+    /** Lines containing one of these strings are transferred. */
+    std::vector<std::string> lrf_literals;
+    /** Lines matching one of these POSIX extended regexes are transferred. */
+    std::vector<std::string> lrf_regexes;
+
+    bool operator==(const logfile_remote_filter& rhs) const
+    {
+        return this->lrf_min_mtime == rhs.lrf_min_mtime
+            && this->lrf_literals == rhs.lrf_literals
+            && this->lrf_regexes == rhs.lrf_regexes;
+    }
+
+    bool operator!=(const logfile_remote_filter& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
 struct logfile_open_options_base {
     std::string loo_filename;
     logfile_name_source loo_source{logfile_name_source::USER};
@@ -75,6 +108,8 @@ struct logfile_open_options_base {
     std::optional<lnav::piper::running_handle> loo_piper;
     file_location_t loo_init_location{mapbox::util::no_init{}};
     std::vector<lnav::console::user_message> loo_match_details;
+    std::optional<logfile_remote_filter> loo_remote_filter;
+    bool loo_streaming{false};
 };
 
 struct logfile_open_options : public logfile_open_options_base {
@@ -177,6 +212,21 @@ struct logfile_open_options : public logfile_open_options_base {
 
         return *this;
     }
+
+    logfile_open_options& with_streaming(bool val)
+    {
+        this->loo_streaming = val;
+
+        return *this;
+    }
+
+    logfile_open_options& with_remote_filter(
+        std::optional<logfile_remote_filter> rf)
+    {
+        this->loo_remote_filter = std::move(rf);
+
+        return *this;
+    }
 };
 
 #endif
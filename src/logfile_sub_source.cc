@@ -37,6 +37,7 @@
 #include "base/ansi_scrubber.hh"
 #include "base/ansi_vars.hh"
 #include "base/fs_util.hh"
+#include "base/injector.hh"
 #include "base/itertools.hh"
 #include "base/string_util.hh"
 #include "bookmarks.json.hh"
@@ -46,6 +47,7 @@
 #include "k_merge_tree.h"
 #include "lnav_util.hh"
 #include "log_accel.hh"
+#include "logfile.cfg.hh"
 #include "md2attr_line.hh"
 #include "ptimec.hh"
 #include "shlex.hh"
@@ -772,6 +774,9 @@ struct logline_cmp {
 logfile_sub_source::rebuild_result
 logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
 {
+    static const auto& logfile_cfg
+        = injector::get<const lnav::logfile::config&>();
+
     if (this->tss_view == nullptr) {
         return rebuild_result::rr_no_change;
     }
@@ -921,6 +926,107 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
         return rebuild_result::rr_appended_lines;
     }
 
+    // Drop the oldest messages from files that have grown past the
+    // retention limits.  This is only done once a decent chunk of a file
+    // can be dropped so that the index is not compacted on every update.
+    std::vector<size_t> discard_counts;
+    std::optional<content_line_t> anchor_top, anchor_sel;
+    if ((logfile_cfg.lc_retention_max_age.count() > 0
+         || logfile_cfg.lc_retention_max_size > 0)
+        && !this->tss_view->is_paused())
+    {
+        for (auto& ld : this->lss_files) {
+            auto* lf = ld->get_file_ptr();
+
+            if (lf == nullptr) {
+                continue;
+            }
+
+            auto count = lf->lines_outside_retention(
+                logfile_cfg.lc_retention_max_age,
+                logfile_cfg.lc_retention_max_size);
+            if (count == 0 || count < lf->size() / 16) {
+                continue;
+            }
+
+            log_info("%s: discarding %zu lines outside of retention limits",
+                     lf->get_filename().c_str(),
+                     count);
+            if (discard_counts.empty()) {
+                // Remember the content lines at the top and selection so
+                // the view stays on them after the index shrinks.
+                auto top = this->tss_view->get_top();
+                auto sel = this->tss_view->get_selection();
+                auto vis_count = vis_line_t(this->lss_filtered_index.size());
+
+                if (0_vl <= top && top < vis_count) {
+                    anchor_top = this->at(top);
+                }
+                if (0_vl <= sel && sel < vis_count) {
+                    anchor_sel = this->at(sel);
+                }
+            }
+            lf->discard_lines(count);
+            ld->ld_filter_state.lfo_filter_state.discard_lines(count);
+            ld->ld_lines_indexed -= std::min(count, ld->ld_lines_indexed);
+
+            const auto base_cl = ld->ld_file_index * MAX_LINES_PER_FILE;
+            const auto keep_cl = content_line_t(base_cl + count);
+            const auto end_cl = content_line_t(base_cl + MAX_LINES_PER_FILE);
+            for (auto& bm_pair : this->lss_user_marks) {
+                auto& bv = bm_pair.second;
+                auto start_iter = std::lower_bound(
+                    bv.begin(), bv.end(), content_line_t(base_cl));
+                auto keep_iter
+                    = std::lower_bound(start_iter, bv.end(), keep_cl);
+                auto end_iter = std::lower_bound(keep_iter, bv.end(), end_cl);
+
+                for (auto bm_iter = keep_iter; bm_iter != end_iter; ++bm_iter) {
+                    *bm_iter = content_line_t(*bm_iter - count);
+                }
+                bv.erase(start_iter, keep_iter);
+            }
+
+            discard_counts.resize(this->lss_files.size());
+            discard_counts[ld->ld_file_index] = count;
+        }
+    }
+
+    bool compacted = false;
+    if (!discard_counts.empty()) {
+        this->clear_line_size_cache();
+        if (force || full_sort || retval == rebuild_result::rr_partial_rebuild)
+        {
+            force = true;
+            full_sort = true;
+        } else {
+            // The remaining lines keep their relative order, so the index
+            // can be compacted in place instead of being resorted.
+            size_t out_index = 0;
+            for (size_t in_index = 0; in_index < this->lss_index.size();
+                 in_index++)
+            {
+                const auto cl = (content_line_t) this->lss_index[in_index];
+                const auto file_index = cl / MAX_LINES_PER_FILE;
+                const auto count = file_index < discard_counts.size()
+                    ? discard_counts[file_index]
+                    : 0;
+
+                if (cl % MAX_LINES_PER_FILE < count) {
+                    continue;
+                }
+                this->lss_index[out_index++] = content_line_t(cl - count);
+            }
+            log_debug("compacted index from %zu to %zu lines",
+                      this->lss_index.size(),
+                      out_index);
+            this->lss_index.shrink_to(out_index);
+            this->lss_filtered_index.clear();
+            compacted = true;
+        }
+        retval = rebuild_result::rr_full_rebuild;
+    }
+
     if (this->lss_index.reserve(total_lines + est_remaining_lines)) {
         // The index array was reallocated, just do a full sort/rebuild since
         // it's been cleared out.
@@ -932,6 +1038,10 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
 
     auto& vis_bm = this->tss_view->get_bookmarks();
 
+    if (compacted) {
+        vis_bm[&textview_curses::BM_USER_EXPR].clear();
+    }
+
     if (force) {
         for (iter = this->lss_files.begin(); iter != this->lss_files.end();
              iter++)
@@ -1014,7 +1124,8 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
     }
 
     if (retval != rebuild_result::rr_no_change || force) {
-        size_t index_size = 0, start_size = this->lss_index.size();
+        size_t index_size = 0,
+               start_size = compacted ? 0 : this->lss_index.size();
         logline_cmp line_cmper(*this);
 
         for (auto& ld : this->lss_files) {
@@ -1253,6 +1364,10 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
             log_debug("redoing search");
             this->lss_index_generation += 1;
             this->tss_view->reload_data();
+            if (!discard_counts.empty()) {
+                this->restore_retention_anchor(
+                    discard_counts, anchor_top, anchor_sel);
+            }
             this->tss_view->redo_search();
             break;
         case rebuild_result::rr_partial_rebuild:
@@ -1270,6 +1385,39 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
     return retval;
 }
 
+void
+logfile_sub_source::restore_retention_anchor(
+    const std::vector<size_t>& discard_counts,
+    std::optional<content_line_t> anchor_top,
+    std::optional<content_line_t> anchor_sel)
+{
+    // Lines that were discarded map to the first line left in their file.
+    auto shift = [&discard_counts](content_line_t cl) {
+        const auto file_index = cl / MAX_LINES_PER_FILE;
+        const auto line = cl % MAX_LINES_PER_FILE;
+        const auto count = file_index < discard_counts.size()
+            ? discard_counts[file_index]
+            : 0;
+
+        return content_line_t(cl - std::min<int64_t>(line, count));
+    };
+
+    if (anchor_top) {
+        auto top_opt = this->find_from_content(shift(anchor_top.value()));
+
+        if (top_opt) {
+            this->tss_view->set_top(top_opt.value(), true);
+        }
+    }
+    if (anchor_sel && this->tss_view->is_selectable()) {
+        auto sel_opt = this->find_from_content(shift(anchor_sel.value()));
+
+        if (sel_opt) {
+            this->tss_view->set_selection(sel_opt.value());
+        }
+    }
+}
+
 void
 logfile_sub_source::text_update_marks(vis_bookmarks& bm)
 {
@@ -775,6 +775,10 @@ private:
 
     bool check_extra_filters(iterator ld, logfile::iterator ll);
 
+    void restore_retention_anchor(const std::vector<size_t>& discard_counts,
+                                  std::optional<content_line_t> anchor_top,
+                                  std::optional<content_line_t> anchor_sel);
+
     size_t lss_basename_width = 0;
     size_t lss_filename_width = 0;
     unsigned long lss_flags{0};
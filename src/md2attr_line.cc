@@ -102,6 +102,10 @@ md2attr_line::flush_footnotes()
 Result<void, std::string>
 md2attr_line::enter_block(const md4cpp::event_handler::block& bl)
 {
+    if (this->ml_is_cancelled && this->ml_is_cancelled()) {
+        return Err(std::string("cancelled"));
+    }
+
     if (this->ml_source_path) {
         log_trace("enter_block %s",
                   mapbox::util::apply_visitor(type_visitor(), bl));
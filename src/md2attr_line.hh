@@ -31,6 +31,7 @@
 #define lnav_md2attr_line_hh
 
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <string>
 #include <vector>
@@ -53,6 +54,16 @@ public:
         return *this;
     }
 
+    /**
+     * @param func Checked at the start of each block, a true result stops
+     *   the parse with an error.
+     */
+    md2attr_line& with_cancel_check(std::function<bool()> func)
+    {
+        this->ml_is_cancelled = std::move(func);
+        return *this;
+    }
+
     Result<void, std::string> enter_block(const block& bl) override;
 
     Result<void, std::string> leave_block(const block& bl) override;
@@ -100,6 +111,7 @@ private:
     attr_line_t to_attr_line(const pugi::xml_node& doc);
 
     std::optional<std::filesystem::path> ml_source_path;
+    std::function<bool()> ml_is_cancelled;
     std::vector<attr_line_t> ml_blocks;
     std::vector<list_block_t> ml_list_stack;
     std::vector<table_t> ml_tables;
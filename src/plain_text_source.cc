@@ -149,6 +149,20 @@ plain_text_source::replace_with(const std::vector<attr_line_t>& text_lines)
     return *this;
 }
 
+plain_text_source&
+plain_text_source::append_line(attr_line_t al)
+{
+    file_off_t off = 0;
+    if (!this->tds_lines.empty()) {
+        const auto& last_line = this->tds_lines.back();
+        off = last_line.tl_offset + last_line.tl_value.length() + 1;
+    }
+    this->tds_longest_line
+        = std::max(this->tds_longest_line, (size_t) al.length());
+    this->tds_lines.emplace_back(off, std::move(al));
+    return *this;
+}
+
 void
 plain_text_source::clear()
 {
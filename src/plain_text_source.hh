@@ -87,6 +87,13 @@ public:
         return this->replace_with(attr_line_t::from_ansi_str(str));
     }
 
+    /**
+     * Add a line to the end of the text, for content that is produced a
+     * line at a time.  The view is not notified since this is meant for
+     * building up a source before it is displayed.
+     */
+    plain_text_source& append_line(attr_line_t al);
+
     void clear();
 
     plain_text_source& truncate_to(size_t max_lines);
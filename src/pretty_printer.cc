@@ -36,6 +36,28 @@
 #include "base/string_util.hh"
 #include "config.h"
 
+/**
+ * Tokens that start in the last part of a window are left for the next
+ * window since they might be cut off.
+ */
+static constexpr size_t STREAM_LOOKAHEAD = 64 * 1024;
+
+/**
+ * The amount of output to collect before passing the completed lines to the
+ * sink.
+ */
+static constexpr size_t STREAM_FLUSH_SIZE = 1024 * 1024;
+
+pretty_printer::pretty_printer(line_sink sink)
+    : pp_leading_indent(0), pp_scanner(nullptr), pp_sink(std::move(sink)),
+      pp_stream_flush_size(STREAM_FLUSH_SIZE)
+{
+    this->pp_body_lines.push(0);
+    this->pp_interval_state.resize(1);
+    this->pp_hier_nodes.push_back(
+        std::make_unique<lnav::document::hier_node>());
+}
+
 void
 pretty_printer::append_to(attr_line_t& al)
 {
@@ -56,88 +78,9 @@ pretty_printer::append_to(attr_line_t& al)
             break;
         }
 
-        element el(tok_res->tr_token, tok_res->tr_capture);
-
-        switch (el.e_token) {
-            case DT_XML_DECL_TAG:
-            case DT_XML_EMPTY_TAG:
-                if (this->pp_is_xml && this->pp_line_length > 0) {
-                    this->start_new_line();
-                }
-                this->pp_values.emplace_back(el);
-                if (this->pp_is_xml) {
-                    this->start_new_line();
-                }
-                continue;
-            case DT_XML_OPEN_TAG:
-                if (this->pp_is_xml) {
-                    this->start_new_line();
-                    this->write_element(el);
-                    this->pp_interval_state.back().is_start
-                        = this->pp_stream.tellp();
-                    this->pp_interval_state.back().is_name
-                        = tok_res->to_string();
-                    this->descend(DT_XML_CLOSE_TAG);
-                } else {
-                    this->pp_values.emplace_back(el);
-                }
-                continue;
-            case DT_XML_CLOSE_TAG:
-                this->flush_values();
-                this->ascend(el.e_token);
-                this->append_child_node();
-                this->write_element(el);
-                this->start_new_line();
-                continue;
-            case DT_LCURLY:
-            case DT_LSQUARE:
-            case DT_LPAREN:
-                this->flush_values(true);
-                this->pp_values.emplace_back(el);
-                this->descend(to_closer(el.e_token));
-                this->pp_interval_state.back().is_start
-                    = this->pp_stream.tellp();
-                continue;
-            case DT_RCURLY:
-            case DT_RSQUARE:
-            case DT_RPAREN:
-                this->flush_values();
-                if (this->pp_body_lines.top()) {
-                    this->start_new_line();
-                }
-                this->ascend(el.e_token);
-                this->write_element(el);
-                continue;
-            case DT_COMMA:
-                if (this->pp_depth > 0) {
-                    this->flush_values(true);
-                    if (!this->pp_is_xml) {
-                        this->append_child_node();
-                    }
-                    this->write_element(el);
-                    this->start_new_line();
-                    this->pp_interval_state.back().is_start
-                        = this->pp_stream.tellp();
-                    continue;
-                }
-                break;
-            case DT_WHITE:
-                if (this->pp_values.empty() && this->pp_depth == 0
-                    && this->pp_line_length == 0)
-                {
-                    this->pp_leading_indent = el.e_capture.length();
-                    continue;
-                }
-                break;
-            default:
-                break;
-        }
-        this->pp_values.emplace_back(el);
+        this->handle_token(tok_res.value());
     }
-    while (this->pp_depth > 0) {
-        this->ascend(this->pp_container_tokens.back());
-    }
-    this->flush_values();
+    this->close_containers();
 
     attr_line_t combined;
     combined.get_string() = this->pp_stream.str();
@@ -168,10 +111,327 @@ pretty_printer::append_to(attr_line_t& al)
     }
 }
 
+static bool
+is_quote_start(string_fragment window, int off)
+{
+    switch (window[off]) {
+        case '"':
+        case '\'':
+            return true;
+        case 'f':
+        case 'u':
+        case 'r':
+        case 'R':
+            return off + 1 < window.length()
+                && (window[off + 1] == '"' || window[off + 1] == '\'');
+        default:
+            return false;
+    }
+}
+
+/**
+ * Check if the quoted string that starts at the given offset could extend
+ * past the end of the window.  A string that cannot be terminated, because
+ * there is a newline first, is left to the scanner as usual.  The offset
+ * where the check ran out of input is stored in "resume" so that the next
+ * check of the same string does not start over.
+ */
+static bool
+is_unterminated_quote(string_fragment window, int off, int& resume)
+{
+    auto pos = off;
+    if (window[pos] == 'R' && pos + 2 < window.length()
+        && window[pos + 2] == '(')
+    {
+        auto body_start = std::max(pos + 3, resume);
+        auto rest = window.substr(body_start).to_string_view();
+        if (rest.find(")\"") != std::string_view::npos) {
+            return false;
+        }
+        resume = std::max(body_start, window.length() - 1);
+        return true;
+    }
+    if (window[pos] != '"' && window[pos] != '\'') {
+        pos += 1;
+    }
+
+    const auto quote = window[pos];
+    if (pos + 2 >= window.length()) {
+        return true;
+    }
+    if (window[pos + 1] == quote && window[pos + 2] == quote) {
+        auto body_start = std::max(pos + 3, resume);
+        auto rest = window.substr(body_start).to_string_view();
+        if (rest.find(std::string(3, quote)) != std::string_view::npos) {
+            return false;
+        }
+        resume = std::max(body_start, window.length() - 2);
+        return true;
+    }
+
+    for (pos = std::max(pos + 1, resume); pos < window.length(); pos++) {
+        switch (window[pos]) {
+            case '\\':
+                if (pos + 1 >= window.length()) {
+                    resume = pos;
+                    return true;
+                }
+                pos += 1;
+                break;
+            case '\n':
+            case '\0':
+            case '\x16':
+            case '\x1b':
+                return false;
+            default:
+                if (window[pos] == quote) {
+                    if (pos + 1 >= window.length()) {
+                        resume = pos;
+                        return true;
+                    }
+                    if (window[pos + 1] != quote) {
+                        return false;
+                    }
+                    pos += 1;
+                }
+                break;
+        }
+    }
+
+    resume = window.length();
+    return true;
+}
+
+void
+pretty_printer::feed(string_fragment sf)
+{
+    this->pp_window.append(sf.data(), sf.length());
+    if (this->pp_window.size() - this->pp_window_offset > STREAM_LOOKAHEAD) {
+        this->process_window(false);
+    }
+}
+
+void
+pretty_printer::finish()
+{
+    this->process_window(true);
+    this->close_containers();
+    this->flush_stream_lines(true);
+}
+
+void
+pretty_printer::process_window(bool final)
+{
+    auto window = string_fragment::from_str(this->pp_window);
+
+    if (!this->pp_window_scanner) {
+        data_scanner prescan(window);
+
+        while (true) {
+            auto tok_res = prescan.tokenize2();
+            if (!tok_res) {
+                break;
+            }
+            if (tok_res->tr_token == DT_XML_CLOSE_TAG
+                || tok_res->tr_token == DT_XML_DECL_TAG)
+            {
+                this->pp_is_xml = true;
+                break;
+            }
+        }
+        this->pp_window_scanner.emplace(window);
+        this->pp_scanner = &this->pp_window_scanner.value();
+    } else {
+        this->pp_window_scanner->shift_input(window, 0);
+    }
+
+    auto consumed = this->pp_window_offset;
+    while (true) {
+        if (!final) {
+            if (consumed + STREAM_LOOKAHEAD > (size_t) window.length()) {
+                break;
+            }
+            if (is_quote_start(window, consumed)
+                && is_unterminated_quote(
+                    window, consumed, this->pp_quote_resume))
+            {
+                break;
+            }
+            this->pp_quote_resume = 0;
+        }
+
+        auto tok_res = this->pp_scanner->tokenize2();
+        if (!tok_res) {
+            break;
+        }
+
+        consumed = tok_res->tr_capture.c_end;
+        this->handle_token(tok_res.value());
+        if ((size_t) this->pp_stream.tellp() >= this->pp_stream_flush_size) {
+            this->flush_stream_lines(false);
+        }
+    }
+
+    // Drop the part of the window that has been written out, keeping
+    // anything still referenced by values waiting to be flushed.
+    auto dropped = consumed;
+    for (const auto& el : this->pp_values) {
+        dropped = std::min(dropped, el.e_capture.c_begin);
+    }
+    if (dropped > 0) {
+        for (auto& el : this->pp_values) {
+            el.e_capture.c_begin -= dropped;
+            el.e_capture.c_end -= dropped;
+        }
+        this->pp_window.erase(0, dropped);
+        this->pp_window_scanner->shift_input(
+            string_fragment::from_str(this->pp_window), dropped);
+        consumed -= dropped;
+        if (this->pp_quote_resume > 0) {
+            this->pp_quote_resume -= dropped;
+        }
+    }
+    this->pp_window_offset = consumed;
+
+    this->flush_stream_lines(false);
+}
+
+void
+pretty_printer::flush_stream_lines(bool final)
+{
+    auto output = this->pp_stream.str();
+    size_t start = 0;
+
+    while (start < output.size()) {
+        auto eol = output.find('\n', start);
+        if (eol == std::string::npos) {
+            if (!final) {
+                break;
+            }
+            eol = output.size();
+        }
+
+        if (eol == start) {
+            // Blank lines are held back so that the ones at the end of the
+            // output can be dropped.
+            this->pp_pending_blank_lines += 1;
+        } else {
+            for (; this->pp_pending_blank_lines > 0;
+                 this->pp_pending_blank_lines--)
+            {
+                this->pp_sink(attr_line_t());
+            }
+            this->pp_sink(attr_line_t(output.substr(start, eol - start)));
+        }
+        start = eol + 1;
+    }
+
+    if (start > 0) {
+        start = std::min(start, output.size());
+        this->pp_stream_base += start;
+        this->pp_stream.str("");
+        this->pp_stream << string_fragment::from_str_range(
+            output, start, output.size());
+    }
+    // A long line that is still being built should not be copied out of
+    // the stream on every token.
+    this->pp_stream_flush_size = std::max(
+        STREAM_FLUSH_SIZE, 2 * (size_t) this->pp_stream.tellp());
+}
+
+void
+pretty_printer::handle_token(const data_scanner::tokenize_result& tr)
+{
+    element el(tr.tr_token, tr.tr_capture);
+
+    switch (el.e_token) {
+        case DT_XML_DECL_TAG:
+        case DT_XML_EMPTY_TAG:
+            if (this->pp_is_xml && this->pp_line_length > 0) {
+                this->start_new_line();
+            }
+            this->pp_values.emplace_back(el);
+            if (this->pp_is_xml) {
+                this->start_new_line();
+            }
+            return;
+        case DT_XML_OPEN_TAG:
+            if (this->pp_is_xml) {
+                this->start_new_line();
+                this->write_element(el);
+                this->pp_interval_state.back().is_start
+                    = this->stream_offset();
+                this->pp_interval_state.back().is_name = tr.to_string();
+                this->descend(DT_XML_CLOSE_TAG);
+            } else {
+                this->pp_values.emplace_back(el);
+            }
+            return;
+        case DT_XML_CLOSE_TAG:
+            this->flush_values();
+            this->ascend(el.e_token);
+            this->append_child_node();
+            this->write_element(el);
+            this->start_new_line();
+            return;
+        case DT_LCURLY:
+        case DT_LSQUARE:
+        case DT_LPAREN:
+            this->flush_values(true);
+            this->pp_values.emplace_back(el);
+            this->descend(to_closer(el.e_token));
+            this->pp_interval_state.back().is_start = this->stream_offset();
+            return;
+        case DT_RCURLY:
+        case DT_RSQUARE:
+        case DT_RPAREN:
+            this->flush_values();
+            if (this->pp_body_lines.top()) {
+                this->start_new_line();
+            }
+            this->ascend(el.e_token);
+            this->write_element(el);
+            return;
+        case DT_COMMA:
+            if (this->pp_depth > 0) {
+                this->flush_values(true);
+                if (!this->pp_is_xml) {
+                    this->append_child_node();
+                }
+                this->write_element(el);
+                this->start_new_line();
+                this->pp_interval_state.back().is_start
+                    = this->stream_offset();
+                return;
+            }
+            break;
+        case DT_WHITE:
+            if (this->pp_values.empty() && this->pp_depth == 0
+                && this->pp_line_length == 0)
+            {
+                this->pp_leading_indent = el.e_capture.length();
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    this->pp_values.emplace_back(el);
+}
+
+void
+pretty_printer::close_containers()
+{
+    while (this->pp_depth > 0) {
+        this->ascend(this->pp_container_tokens.back());
+    }
+    this->flush_values();
+}
+
 void
 pretty_printer::write_element(const element& el)
 {
-    ssize_t start_size = this->pp_stream.tellp();
+    ssize_t start_size = this->stream_offset();
     if (this->pp_leading_indent == 0 && this->pp_line_length == 0
         && el.e_token == DT_WHITE)
     {
@@ -251,11 +511,11 @@ pretty_printer::write_element(const element& el)
 int
 pretty_printer::append_indent()
 {
-    auto start_size = this->pp_stream.tellp();
+    auto start_size = this->stream_offset();
     auto prefix_size = this->pp_leading_indent + this->pp_soft_indent;
     this->pp_stream << std::string(prefix_size, ' ');
     this->pp_soft_indent = 0;
-    if (this->pp_stream.tellp() != this->pp_leading_indent) {
+    if (this->stream_offset() != this->pp_leading_indent) {
         for (int lpc = 0; lpc < this->pp_depth; lpc++) {
             this->pp_stream << "    ";
         }
@@ -264,7 +524,7 @@ pretty_printer::append_indent()
                                     + 4 * this->pp_depth);
         }
     }
-    return (this->pp_stream.tellp() - start_size);
+    return (this->stream_offset() - start_size);
 }
 
 bool
@@ -293,7 +553,7 @@ pretty_printer::flush_values(bool start_on_depth)
                                   .to_string();
                         if (!this->pp_interval_state.back().is_name.empty()) {
                             this->pp_interval_state.back().is_start
-                                = static_cast<ssize_t>(this->pp_stream.tellp());
+                                = static_cast<ssize_t>(this->stream_offset());
                         }
                         last_key = std::nullopt;
                     }
@@ -305,7 +565,7 @@ pretty_printer::flush_values(bool start_on_depth)
                 && (el.e_token == DT_LSQUARE || el.e_token == DT_LCURLY))
             {
                 if (this->pp_line_length > 0) {
-                    ssize_t start_size = this->pp_stream.tellp();
+                    ssize_t start_size = this->stream_offset();
                     this->pp_stream << std::endl;
 
                     auto shift_cover = line_range::empty_at(start_size);
@@ -325,7 +585,7 @@ pretty_printer::start_new_line()
 {
     bool has_output;
 
-    ssize_t start_size = this->pp_stream.tellp();
+    ssize_t start_size = this->stream_offset();
     if (this->pp_line_length > 0) {
         this->pp_stream << std::endl;
         auto shift_cover = line_range::empty_at(start_size);
@@ -334,7 +594,7 @@ pretty_printer::start_new_line()
     }
     has_output = this->flush_values();
     if (has_output && this->pp_line_length > 0) {
-        start_size = this->pp_stream.tellp();
+        start_size = this->stream_offset();
         this->pp_stream << std::endl;
         auto shift_cover = line_range::empty_at(start_size);
         shift_string_attrs(this->pp_attrs, shift_cover, 1);
@@ -394,7 +654,7 @@ void
 pretty_printer::append_child_node()
 {
     auto& ivstate = this->pp_interval_state.back();
-    if (!ivstate.is_start) {
+    if (!ivstate.is_start || this->pp_sink) {
         return;
     }
 
@@ -404,7 +664,7 @@ pretty_printer::append_child_node()
         : lnav::document::section_key_t{ivstate.is_name};
     this->pp_intervals.emplace_back(
         ivstate.is_start.value(),
-        static_cast<ssize_t>(this->pp_stream.tellp()),
+        static_cast<ssize_t>(this->stream_offset()),
         new_key);
     auto new_node = this->pp_hier_stage != nullptr
         ? std::move(this->pp_hier_stage)
@@ -31,6 +31,7 @@
 #define pretty_printer_hh
 
 #include <deque>
+#include <functional>
 #include <optional>
 #include <set>
 #include <sstream>
@@ -46,7 +47,7 @@
 class pretty_printer {
 public:
     struct element {
-        element(data_token_t token, data_scanner::capture_t& cap)
+        element(data_token_t token, const data_scanner::capture_t& cap)
             : e_token(token), e_capture(cap)
         {
         }
@@ -79,8 +80,28 @@ public:
             std::make_unique<lnav::document::hier_node>());
     }
 
+    /**
+     * Receives each line of output, without the line terminator, when the
+     * printer is used in streaming mode.
+     */
+    using line_sink = std::function<void(attr_line_t&&)>;
+
+    /**
+     * Construct a printer for input that is too large to hold in memory at
+     * once.  The input is passed in pieces to feed() and output lines are
+     * passed to the sink as soon as they are complete, so memory use depends
+     * on the nesting depth, the window size, and the longest token instead
+     * of the size of the document.  Sections are not tracked in this mode
+     * and the check for XML only looks at the start of the input.
+     */
+    explicit pretty_printer(line_sink sink);
+
     void append_to(attr_line_t& al);
 
+    void feed(string_fragment sf);
+
+    void finish();
+
     std::vector<lnav::document::section_interval_t> take_intervals()
     {
         return std::move(this->pp_intervals);
@@ -98,6 +119,19 @@ public:
     std::set<size_t> take_indents() { return std::move(this->pp_indents); }
 
 private:
+    void handle_token(const data_scanner::tokenize_result& tr);
+
+    void close_containers();
+
+    void process_window(bool final);
+
+    void flush_stream_lines(bool final);
+
+    file_off_t stream_offset()
+    {
+        return this->pp_stream_base + this->pp_stream.tellp();
+    }
+
     void descend(data_token_t dt);
 
     void ascend(data_token_t dt);
@@ -135,6 +169,14 @@ private:
     std::vector<std::unique_ptr<lnav::document::hier_node>> pp_hier_nodes;
     std::unique_ptr<lnav::document::hier_node> pp_hier_stage;
     std::set<size_t> pp_indents;
+    line_sink pp_sink;
+    std::string pp_window;
+    std::optional<data_scanner> pp_window_scanner;
+    int pp_window_offset{0};
+    int pp_quote_resume{0};
+    size_t pp_stream_flush_size{0};
+    file_off_t pp_stream_base{0};
+    size_t pp_pending_blank_lines{0};
 };
 
 #endif
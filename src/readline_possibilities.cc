@@ -55,21 +55,18 @@
 #include "yajlpp/yajlpp_def.hh"
 
 static void
-tokenize_view_text(std::unordered_set<std::string>& accum, string_fragment text)
+tokenize_view_text(std::unordered_set<std::string>& accum,
+                   std::string_view text)
 {
-    data_scanner ds(text);
+    std::vector<data_scanner::batch_token> tokens;
 
-    while (true) {
-        auto tok_res = ds.tokenize2();
-
-        if (!tok_res) {
-            break;
-        }
-        if (tok_res->tr_capture.length() < 4) {
+    data_scanner::tokenize_lines(text, tokens);
+    for (const auto& tok : tokens) {
+        if (tok.bt_capture.length() < 4) {
             continue;
         }
 
-        switch (tok_res->tr_token) {
+        switch (tok.bt_token) {
             case DT_DATE:
             case DT_TIME:
             case DT_WHITE:
@@ -78,11 +75,14 @@ tokenize_view_text(std::unordered_set<std::string>& accum, string_fragment text)
                 break;
         }
 
-        accum.emplace(tok_res->to_string());
-        switch (tok_res->tr_token) {
+        accum.emplace(
+            text.substr(tok.bt_capture.c_begin, tok.bt_capture.length()));
+        switch (tok.bt_token) {
             case DT_QUOTED_STRING:
                 tokenize_view_text(
-                    accum, ds.to_string_fragment(tok_res->tr_inner_capture));
+                    accum,
+                    text.substr(tok.bt_inner_capture.c_begin,
+                                tok.bt_inner_capture.length()));
                 break;
             default:
                 break;
@@ -117,6 +117,7 @@ statusview_curses::do_update()
     ncplane_cursor_move_yx(this->sc_window, top, 0);
     ncplane_hline(this->sc_window, &clear_cell, width);
     nccell_release(this->sc_window, &clear_cell);
+    damage_rows(this->sc_window, top);
 
     if (this->sc_source != nullptr) {
         auto field_count = this->sc_source->statusview_fields();
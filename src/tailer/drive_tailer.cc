@@ -27,7 +27,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <fstream>
+#include <sstream>
 #include <thread>
+#include <tuple>
 
 #include <unistd.h>
 
@@ -56,7 +59,7 @@ read_err_pipe(auto_fd& err, std::string& eq)
 int
 main(int argc, char* const* argv)
 {
-    if (argc != 3) {
+    if (argc < 3) {
         fprintf(stderr, "usage: %s <cmd> <path>\n", argv[0]);
         exit(EXIT_FAILURE);
     }
@@ -119,6 +122,9 @@ main(int argc, char* const* argv)
     auto& to_child = in_pipe.write_end();
     auto& from_child = out_pipe.read_end();
     auto cmd = std::string(argv[1]);
+    auto tail_mode = false;
+    auto deflate = false;
+    auto filter = false;
 
     if (cmd == "open") {
         send_packet(
@@ -134,13 +140,46 @@ main(int argc, char* const* argv)
     } else if (cmd == "possible") {
         send_packet(
             to_child.get(), TPT_COMPLETE_PATH, TPPT_STRING, argv[2], TPPT_DONE);
+    } else if (cmd == "tail" || cmd == "tail-deflate") {
+        tail_mode = true;
+        deflate = cmd == "tail-deflate";
+        send_packet(
+            to_child.get(), TPT_OPEN_PATH, TPPT_STRING, argv[2], TPPT_DONE);
+    } else if (cmd == "tail-filter" || cmd == "tail-filter-deflate") {
+        if (argc < 4) {
+            fprintf(stderr,
+                    "usage: %s %s <path> <regex>\n",
+                    argv[0],
+                    cmd.c_str());
+            exit(EXIT_FAILURE);
+        }
+        tail_mode = true;
+        filter = true;
+        deflate = cmd == "tail-filter-deflate";
+        send_packet(to_child.get(),
+                    TPT_OPEN_PATH,
+                    TPPT_STRING,
+                    argv[2],
+                    TPPT_INT64,
+                    int64_t{0},
+                    TPPT_STRING,
+                    "",
+                    TPPT_STRING,
+                    argv[3],
+                    TPPT_DONE);
     } else {
         fprintf(stderr, "error: unknown command -- %s\n", cmd.c_str());
         exit(EXIT_FAILURE);
     }
 
-    close(to_child.get());
+    if (!tail_mode) {
+        close(to_child.get());
+    }
 
+    std::string tail_content;
+    int64_t wire_bytes = 0;
+    // The local offset, remote offset, and length of each filtered gap.
+    std::vector<std::tuple<int64_t, int64_t, int64_t>> tail_gaps;
     bool done = false;
     while (!done) {
         auto read_res = tailer::read_packet(from_child);
@@ -156,7 +195,15 @@ main(int argc, char* const* argv)
                 printf("all done!\n");
                 done = true;
             },
-            [&](const tailer::packet_announce& pa) {},
+            [&](const tailer::packet_announce& pa) {
+                if (deflate && (pa.pa_features & TF_DEFLATE)) {
+                    send_packet(to_child.get(),
+                                TPT_SET_FEATURES,
+                                TPPT_INT64,
+                                (int64_t) TF_DEFLATE,
+                                TPPT_DONE);
+                }
+            },
             [&](const tailer::packet_log& te) {
                 printf("log: %s\n", te.pl_msg.c_str());
             },
@@ -177,6 +224,15 @@ main(int argc, char* const* argv)
                        pob.pob_offset,
                        pob.pob_length);
 
+                if (tail_mode) {
+                    send_packet(to_child.get(),
+                                TPT_NEED_BLOCK,
+                                TPPT_STRING,
+                                pob.pob_path.c_str(),
+                                TPPT_DONE);
+                    return;
+                }
+
                 auto remote_path = std::filesystem::absolute(
                                        std::filesystem::path(pob.pob_path))
                                        .relative_path();
@@ -231,6 +287,22 @@ main(int argc, char* const* argv)
 #endif
             },
             [&](const tailer::packet_tail_block& ptb) {
+                if (tail_mode) {
+                    tail_content.resize(ptb.ptb_offset);
+                    tail_content.append((const char*) ptb.ptb_bits.data(),
+                                        ptb.ptb_bits.size());
+                    wire_bytes += ptb.ptb_wire_length;
+
+                    int64_t elided = 0;
+                    for (const auto& [off, len] : ptb.ptb_gaps) {
+                        tail_gaps.emplace_back(ptb.ptb_offset + off,
+                                               ptb.ptb_remote_offset + off
+                                                   + elided,
+                                               len);
+                        elided += len;
+                    }
+                    return;
+                }
 #if 0
                 //printf("got a tail: %s %lld %ld\n", ptb.ptb_path.c_str(),
                 //       ptb.ptb_offset, ptb.ptb_bits.size());
@@ -252,7 +324,9 @@ main(int argc, char* const* argv)
 #endif
             },
             [&](const tailer::packet_synced& ps) {
-
+                if (tail_mode && ps.ps_path == argv[2]) {
+                    to_child.reset();
+                }
             },
             [&](const tailer::packet_link& pl) {
                 printf("link value: %s -> %s\n",
@@ -283,6 +357,39 @@ main(int argc, char* const* argv)
 
     err_reader.join();
 
+    if (tail_mode) {
+        std::ifstream local_file(argv[2], std::ios::binary);
+        std::stringstream local_content;
+
+        local_content << local_file.rdbuf();
+        if (filter) {
+            // Put the elided parts back to check that the gaps are right.
+            auto remote_content = local_content.str();
+            std::string rebuilt;
+            int64_t content_off = 0;
+
+            for (const auto& [local_off, remote_off, len] : tail_gaps) {
+                rebuilt.append(
+                    tail_content, content_off, local_off - content_off);
+                rebuilt.append(remote_content, remote_off, len);
+                content_off = local_off;
+            }
+            rebuilt.append(tail_content, content_off);
+
+            printf("%s", tail_content.c_str());
+            fprintf(stderr, "wire bytes: %lld\n", (long long) wire_bytes);
+            fprintf(stderr,
+                    "gaps match: %s\n",
+                    rebuilt == remote_content ? "yes" : "no");
+            return EXIT_SUCCESS;
+        }
+        printf("content bytes: %zu\n", tail_content.size());
+        printf("wire bytes: %lld\n", (long long) wire_bytes);
+        printf("content matches: %s\n",
+               tail_content == local_content.str() ? "yes" : "no");
+        return EXIT_SUCCESS;
+    }
+
     printf("tailer stderr:\n%s", error_queue.c_str());
     fprintf(stderr, "tailer stderr:\n%s", error_queue.c_str());
 }
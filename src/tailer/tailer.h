@@ -59,8 +59,36 @@ typedef enum {
     TPT_COMPLETE_PATH,
     TPT_POSSIBLE_PATH,
     TPT_ANNOUNCE,
+    TPT_SET_FEATURES,
+    TPT_DEFLATED_TAIL_BLOCK,
+    TPT_FILTERED_TAIL_BLOCK,
 } tailer_packet_type_t;
 
+/**
+ * Optional protocol features.  The tailer advertises the features it
+ * supports in the TPT_ANNOUNCE packet and the client turns on the ones
+ * it wants with a TPT_SET_FEATURES packet.
+ *
+ * If TF_FILTER is supported, a TPT_OPEN_PATH packet can have the
+ * following payloads after the path: an INT64 with the minimum
+ * modification time of files to transfer, a STRING with newline-separated
+ * literals, and a STRING with newline-separated POSIX extended regular
+ * expressions.  Only the lines that contain one of the literals or match
+ * one of the expressions are then sent in TPT_FILTERED_TAIL_BLOCK packets.
+ * Those carry the range of the remote file that was filtered, the length
+ * of the matching content, and a BITS payload with the gaps as pairs of
+ * INT64s: the offset in the content where lines were left out and the
+ * number of bytes that were left out there.  If TF_DEFLATE is enabled,
+ * the content is compressed when that makes it shorter.  To change the
+ * filter, the client closes the path and opens it again.
+ */
+typedef enum {
+    TF_DEFLATE = 1 << 0,
+    TF_FILTER = 1 << 1,
+} tailer_feature_t;
+
+#define TAILER_FEATURES ((int64_t) (TF_DEFLATE | TF_FILTER))
+
 #ifdef __cplusplus
 extern "C" {
 #endif
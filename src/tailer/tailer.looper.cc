@@ -27,6 +27,7 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <regex>
 
 #include "tailer.looper.hh"
@@ -40,6 +41,7 @@
 #include "line_buffer.hh"
 #include "lnav.hh"
 #include "lnav.indexing.hh"
+#include "pcrepp/pcre2pp.hh"
 #include "service_tags.hh"
 #include "tailer.h"
 #include "tailer.looper.cfg.hh"
@@ -49,6 +51,7 @@
 using namespace std::chrono_literals;
 
 static const auto HOST_RETRY_DELAY = 1min;
+static constexpr std::chrono::seconds MIN_MTIME_SLACK = 24h;
 
 static void
 read_err_pipe(const std::string& netloc,
@@ -171,6 +174,9 @@ tailer::looper::loop_body()
             auto ht = create_res.unwrap();
             this->l_remotes[netloc] = ht;
             this->s_children.add_child_service(ht);
+            ht->send([files = this->l_single_line_files](auto& ht) {
+                ht.set_single_line_files(files);
+            });
 
             rpq.rpq_new_paths.insert(rpq.rpq_existing_paths.begin(),
                                      rpq.rpq_existing_paths.end());
@@ -268,6 +274,30 @@ tailer::looper::complete_path(const network::path& path)
         [file_path = path.p_path](auto& ht) { ht.complete_path(file_path); });
 }
 
+void
+tailer::looper::update_remote_filter(
+    std::optional<logfile_remote_filter> rf,
+    std::set<std::filesystem::path> single_line_files)
+{
+    this->l_single_line_files = single_line_files;
+    for (auto& netloc_pair : this->l_netlocs_to_paths) {
+        auto& rpq = netloc_pair.second;
+
+        for (auto* paths : {&rpq.rpq_new_paths, &rpq.rpq_existing_paths}) {
+            for (auto& pair : *paths) {
+                if (pair.second.loo_remote_filter) {
+                    pair.second.loo_remote_filter = rf;
+                }
+            }
+        }
+    }
+    for (auto& pair : this->l_remotes) {
+        pair.second->send([rf, single_line_files](auto& ht) {
+            ht.update_remote_filter(rf, single_line_files);
+        });
+    }
+}
+
 static std::vector<std::string>
 create_ssh_args_from_config(const std::string& dest)
 {
@@ -516,12 +546,14 @@ tailer::looper::host_tailer::open_remote_path(const std::string& path,
 {
     this->ht_state.match(
         [&](connected& conn) {
+            auto has_filter = loo.loo_remote_filter.has_value();
+
             conn.c_desired_paths[path] = std::move(loo);
-            send_packet(conn.ht_to_child.get(),
-                        TPT_OPEN_PATH,
-                        TPPT_STRING,
-                        path.c_str(),
-                        TPPT_DONE);
+            if (has_filter && !conn.c_features) {
+                conn.c_pending_filtered_paths.emplace_back(path);
+                return;
+            }
+            conn.send_open_path(path, this->filter_for_path(conn, path));
         },
         [&](const disconnected& d) {
             log_warning("disconnected from host, cannot tail: %s",
@@ -532,6 +564,187 @@ tailer::looper::host_tailer::open_remote_path(const std::string& path,
         });
 }
 
+std::optional<logfile_remote_filter>
+tailer::looper::host_tailer::filter_for_path(const connected& conn,
+                                             const std::string& path) const
+{
+    auto desired_iter = conn.c_desired_paths.find(path);
+
+    if (desired_iter == conn.c_desired_paths.end()) {
+        return std::nullopt;
+    }
+
+    auto retval = desired_iter->second.loo_remote_filter;
+    if (retval) {
+        auto local_path = this->ht_local_path
+            / std::filesystem::absolute(std::filesystem::path(path))
+                  .relative_path();
+
+        if (this->ht_single_line_files.count(local_path) == 0) {
+            // The format is not known yet or a message can span lines, and
+            // the tailer cannot tell where those messages start and end.
+            retval->lrf_literals.clear();
+            retval->lrf_regexes.clear();
+        }
+    }
+
+    return retval;
+}
+
+void
+tailer::looper::host_tailer::connected::send_open_path(
+    const std::string& path, const std::optional<logfile_remote_filter>& rf)
+{
+    this->c_sent_filters.erase(path);
+    if (rf) {
+        if (this->c_features.value_or(0) & TF_FILTER) {
+            auto literals = fmt::format(FMT_STRING("{}"),
+                                        fmt::join(rf->lrf_literals, "\n"));
+            auto regexes = fmt::format(FMT_STRING("{}"),
+                                       fmt::join(rf->lrf_regexes, "\n"));
+
+            log_info("opening remote path with filter: %s", path.c_str());
+            send_packet(this->ht_to_child.get(),
+                        TPT_OPEN_PATH,
+                        TPPT_STRING,
+                        path.c_str(),
+                        TPPT_INT64,
+                        (int64_t) rf->lrf_min_mtime,
+                        TPPT_STRING,
+                        literals.c_str(),
+                        TPPT_STRING,
+                        regexes.c_str(),
+                        TPPT_DONE);
+            this->c_sent_filters[path] = rf.value();
+            return;
+        }
+        log_warning("tailer does not support filtering, transferring all of: %s",
+                    path.c_str());
+    }
+
+    send_packet(this->ht_to_child.get(),
+                TPT_OPEN_PATH,
+                TPPT_STRING,
+                path.c_str(),
+                TPPT_DONE);
+}
+
+void
+tailer::looper::host_tailer::update_remote_filter(
+    const std::optional<logfile_remote_filter>& rf,
+    std::set<std::filesystem::path> single_line_files)
+{
+    this->ht_single_line_files = std::move(single_line_files);
+    this->ht_state.match(
+        [&](connected& conn) {
+            if (!(conn.c_features.value_or(0) & TF_FILTER)) {
+                return;
+            }
+            for (auto& pair : conn.c_desired_paths) {
+                auto& loo = pair.second;
+
+                if (!loo.loo_remote_filter) {
+                    continue;
+                }
+
+                loo.loo_remote_filter = rf;
+
+                auto curr_filter = this->filter_for_path(conn, pair.first);
+                auto sent_iter = conn.c_sent_filters.find(pair.first);
+                if (sent_iter != conn.c_sent_filters.end() && curr_filter
+                    && sent_iter->second == curr_filter.value())
+                {
+                    continue;
+                }
+                if (std::find(conn.c_pending_filtered_paths.begin(),
+                              conn.c_pending_filtered_paths.end(),
+                              pair.first)
+                    != conn.c_pending_filtered_paths.end())
+                {
+                    // Not opened yet, the new filter will be sent then.
+                    continue;
+                }
+
+                log_info("filters changed, requesting remote path again: %s",
+                         pair.first.c_str());
+                send_packet(conn.ht_to_child.get(),
+                            TPT_CLOSE_PATH,
+                            TPPT_STRING,
+                            pair.first.c_str(),
+                            TPPT_DONE);
+                conn.send_open_path(pair.first, curr_filter);
+            }
+        },
+        [&](const disconnected& d) {},
+        [&](const synced& s) {});
+}
+
+void
+tailer::looper::host_tailer::record_elided_range(
+    connected& conn, const tailer::packet_tail_block& ptb)
+{
+    auto iter = conn.c_elided_ranges.find(ptb.ptb_path);
+
+    if (ptb.ptb_remote_offset == 0 && iter != conn.c_elided_ranges.end()) {
+        // The file is being sent from the start again.
+        conn.c_elided_ranges.erase(iter);
+        this->send_elided_ranges(conn, ptb.ptb_path);
+    }
+    if (ptb.ptb_gaps.empty()) {
+        return;
+    }
+
+    auto& ranges = conn.c_elided_ranges[ptb.ptb_path];
+    int64_t elided_so_far = 0;
+    for (const auto& [content_offset, length] : ptb.ptb_gaps) {
+        auto local_offset = ptb.ptb_offset + content_offset;
+        auto remote_offset
+            = ptb.ptb_remote_offset + content_offset + elided_so_far;
+
+        log_debug("  remote filter elided %lld bytes at %lld (local %lld)",
+                  length,
+                  remote_offset,
+                  local_offset);
+        elided_so_far += length;
+        if (!ranges.empty() && ranges.back().er_local_offset == local_offset) {
+            // Nothing was kept since the last gap, so extend it.
+            ranges.back().er_length += length;
+        } else {
+            ranges.emplace_back(connected::elided_range{
+                remote_offset,
+                length,
+                local_offset,
+            });
+        }
+    }
+}
+
+void
+tailer::looper::host_tailer::send_elided_ranges(const connected& conn,
+                                                const std::string& path)
+{
+    auto local_path = this->ht_local_path
+        / std::filesystem::absolute(std::filesystem::path(path))
+              .relative_path();
+    std::vector<logfile_remote_gap> gaps;
+    auto ranges_iter = conn.c_elided_ranges.find(path);
+    if (ranges_iter != conn.c_elided_ranges.end()) {
+        gaps.reserve(ranges_iter->second.size());
+        for (const auto& er : ranges_iter->second) {
+            gaps.emplace_back(
+                logfile_remote_gap{er.er_local_offset, er.er_length});
+        }
+    }
+    isc::to<main_looper&, services::main_t>().send(
+        [local_path, gaps = std::move(gaps)](auto& mlooper) {
+            for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+                if (lf->get_actual_path() == local_path) {
+                    lf->set_remote_elided(gaps);
+                }
+            }
+        });
+}
+
 void
 tailer::looper::host_tailer::load_preview(int64_t id, const std::string& path)
 {
@@ -632,6 +845,20 @@ tailer::looper::host_tailer::loop_body()
                 update_tailer_description(
                     this->ht_netloc, conn.c_desired_paths, pa.pa_uname);
                 this->ht_uname = pa.pa_uname;
+                conn.c_features = pa.pa_features;
+                if (pa.pa_features & TF_DEFLATE) {
+                    log_info("tailer(%s): enabling compressed tail blocks",
+                             this->ht_netloc.c_str());
+                    send_packet(conn.ht_to_child.get(),
+                                TPT_SET_FEATURES,
+                                TPPT_INT64,
+                                (int64_t) TF_DEFLATE,
+                                TPPT_DONE);
+                }
+                for (const auto& path : conn.c_pending_filtered_paths) {
+                    conn.send_open_path(path, this->filter_for_path(conn, path));
+                }
+                conn.c_pending_filtered_paths.clear();
                 return std::move(this->ht_state);
             },
             [&](const tailer::packet_log& pl) {
@@ -866,10 +1093,12 @@ tailer::looper::host_tailer::loop_body()
                                        .relative_path();
                 auto local_path = this->ht_local_path / remote_path;
 
-                log_debug("writing tail to: %lld/%ld %s",
+                log_debug("writing tail to: %lld/%ld (wire %lld) %s",
                           ptb.ptb_offset,
                           ptb.ptb_bits.size(),
+                          ptb.ptb_wire_length,
                           local_path.c_str());
+                this->record_elided_range(conn, ptb);
                 std::filesystem::create_directories(local_path.parent_path());
                 auto create_res = lnav::filesystem::create_file(
                     local_path, O_WRONLY | O_APPEND | O_CREAT, 0600);
@@ -891,6 +1120,11 @@ tailer::looper::host_tailer::loop_body()
                 return std::move(this->ht_state);
             },
             [&](const tailer::packet_synced& ps) {
+                if (conn.c_elided_ranges.count(ps.ps_path) > 0) {
+                    // Pass the gaps on once the tailer has caught up, instead
+                    // of after every block.
+                    this->send_elided_ranges(conn, ps.ps_path);
+                }
                 if (ps.ps_root_path == ps.ps_path) {
                     auto iter = conn.c_desired_paths.find(ps.ps_path);
 
@@ -1181,6 +1415,97 @@ tailer::looper::report_error(std::string path, std::string msg)
     });
 }
 
+/**
+ * The enabled "filter-in"
+ * patterns are only pushed down if all of them can be evaluated remotely,
+ * since a line needs to match only one of them to be shown.
+ */
+std::optional<logfile_remote_filter>
+tailer::remote_filter_from_log_view()
+{
+    static const auto POSIX_INCOMPATIBLE
+        = lnav::pcre2pp::code::from_const(R"(\\|\(\?|[*+?}]\?)");
+    static const auto REGEX_META
+        = lnav::pcre2pp::code::from_const(R"([.\[\]()*+?{}|^$])");
+
+    const auto& cfg = injector::get<const tailer::config&>();
+
+    if (!cfg.c_filter_pushdown) {
+        return std::nullopt;
+    }
+
+    auto& lss = lnav_data.ld_log_source;
+    logfile_remote_filter retval;
+    auto pushable = true;
+
+    auto min_time = lss.get_min_row_time();
+    if (min_time) {
+        // The message times are not always in UTC, so leave a day of slack
+        // before comparing them with the mtime of the remote file.
+        retval.lrf_min_mtime = std::max(
+            time_t{0}, min_time->tv_sec - MIN_MTIME_SLACK.count());
+    }
+    for (const auto& tf : lss.get_filters()) {
+        if (!tf->is_enabled() || tf->get_type() != text_filter::INCLUDE) {
+            continue;
+        }
+
+        auto pattern = tf->get_id();
+        if (tf->get_lang() != filter_lang_t::REGEX
+            || POSIX_INCOMPATIBLE.find_in(pattern).ignore_error())
+        {
+            pushable = false;
+            break;
+        }
+        if (REGEX_META.find_in(pattern).ignore_error()) {
+            retval.lrf_regexes.emplace_back(pattern);
+        } else {
+            retval.lrf_literals.emplace_back(pattern);
+        }
+    }
+    if (!pushable) {
+        retval.lrf_literals.clear();
+        retval.lrf_regexes.clear();
+    }
+
+    return retval;
+}
+
+void
+tailer::check_remote_filters()
+{
+    static std::optional<logfile_remote_filter> last_filter;
+    static std::set<std::filesystem::path> last_single_line_files;
+
+    auto curr_filter = remote_filter_from_log_view();
+    std::set<std::filesystem::path> single_line_files;
+    if (curr_filter) {
+        for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+            const auto* format = lf->get_format_ptr();
+            auto actual_path = lf->get_actual_path();
+
+            if (lf->get_open_options().loo_source != logfile_name_source::REMOTE
+                || format == nullptr || format->lf_multiline || !actual_path)
+            {
+                continue;
+            }
+            single_line_files.insert(actual_path.value());
+        }
+    }
+    if (curr_filter == last_filter
+        && single_line_files == last_single_line_files)
+    {
+        return;
+    }
+
+    last_filter = curr_filter;
+    last_single_line_files = single_line_files;
+    isc::to<tailer::looper&, services::remote_tailer_t>().send(
+        [curr_filter, single_line_files](auto& tlooper) {
+            tlooper.update_remote_filter(curr_filter, single_line_files);
+        });
+}
+
 void
 tailer::cleanup_cache()
 {
@@ -39,6 +39,7 @@ struct config {
     std::chrono::seconds c_cache_ttl{std::chrono::hours(48)};
     std::string c_transfer_cmd{"cat > {0:} && chmod ugo+rx ./{0:}"};
     std::string c_start_cmd{"bash -c ./{0:}"};
+    bool c_filter_pushdown{false};
     std::string c_ssh_cmd{"ssh"};
     std::string c_ssh_flags{};
     std::map<std::string, std::string> c_ssh_options{};
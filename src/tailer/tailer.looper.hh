@@ -43,6 +43,8 @@
 
 namespace tailer {
 
+struct packet_tail_block;
+
 class looper : public isc::service<looper> {
 public:
     void add_remote(const network::path& path,
@@ -52,6 +54,20 @@ public:
 
     void complete_path(const network::path& path);
 
+    /**
+     * Change the filter for the remote paths that were opened with one.
+     * The paths are requested again from the tailers so that the local
+     * copies match the new filter.
+     *
+     * @param rf The new filter.
+     * @param single_line_files The local copies of the remote files that
+     *   have a format where each line is a message.  The tailer filters
+     *   line by line, so the patterns are only sent for these files.
+     */
+    void update_remote_filter(
+        std::optional<logfile_remote_filter> rf,
+        std::set<std::filesystem::path> single_line_files);
+
     bool empty() const { return this->l_netlocs_to_paths.empty(); }
 
     std::set<std::string> active_netlocs() const
@@ -88,6 +104,15 @@ private:
 
         void complete_path(const std::string& path);
 
+        void update_remote_filter(
+            const std::optional<logfile_remote_filter>& rf,
+            std::set<std::filesystem::path> single_line_files);
+
+        void set_single_line_files(std::set<std::filesystem::path> files)
+        {
+            this->ht_single_line_files = std::move(files);
+        }
+
         bool is_synced() const { return this->ht_state.is<synced>(); }
 
     protected:
@@ -114,10 +139,53 @@ private:
             std::map<std::string, logfile_open_options_base> c_child_paths;
             std::set<std::string> c_synced_child_paths;
             bool c_initial_sync_done{false};
+            /** The features supported by the tailer, once it announces. */
+            std::optional<int64_t> c_features;
+            /**
+             * Paths with a remote filter that cannot be opened until the
+             * tailer announces whether it supports filtering.
+             */
+            std::vector<std::string> c_pending_filtered_paths;
+
+            /** A part of a remote file that was left out by the filter. */
+            struct elided_range {
+                int64_t er_remote_offset{0};
+                int64_t er_length{0};
+                /** The offset in the local copy of the line after the gap. */
+                int64_t er_local_offset{0};
+            };
+
+            /** The parts left out of each filtered file, by remote path. */
+            std::map<std::string, std::vector<elided_range>>
+                c_elided_ranges;
+            /** The filter that was last sent for each path. */
+            std::map<std::string, logfile_remote_filter> c_sent_filters;
+
+            void send_open_path(
+                const std::string& path,
+                const std::optional<logfile_remote_filter>& rf);
 
             auto_pid<process_state::finished> close() &&;
         };
 
+        /**
+         * Keep track of the parts of a filtered file that the tailer left
+         * out.  They are passed on to the logfile when the tailer reports
+         * that it has caught up with the file.
+         */
+        void record_elided_range(connected& conn,
+                                 const packet_tail_block& ptb);
+
+        void send_elided_ranges(const connected& conn,
+                                const std::string& path);
+
+        /**
+         * @return The filter to send for a path, without the patterns if
+         * the messages in the file might span more than one line.
+         */
+        std::optional<logfile_remote_filter> filter_for_path(
+            const connected& conn, const std::string& path) const;
+
         struct disconnected {};
         struct synced {};
 
@@ -127,6 +195,7 @@ private:
         std::string ht_uname;
         const std::filesystem::path ht_local_path;
         std::set<std::filesystem::path> ht_active_files;
+        std::set<std::filesystem::path> ht_single_line_files;
         std::vector<std::string> ht_error_queue;
         std::thread ht_error_reader;
         state_v ht_state{disconnected()};
@@ -149,10 +218,24 @@ private:
 
     std::map<std::string, remote_path_queue> l_netlocs_to_paths;
     std::map<std::string, std::shared_ptr<host_tailer>> l_remotes;
+    std::set<std::filesystem::path> l_single_line_files;
 };
 
 void cleanup_cache();
 
+/**
+ * Build the predicates that can be pushed down to the tailer for a remote
+ * file from the current state of the LOG view.
+ */
+std::optional<logfile_remote_filter> remote_filter_from_log_view();
+
+/**
+ * Request the remote files that were opened with a filter again if the
+ * filters in the LOG view have changed since the last call or a format
+ * with single-line messages was found for one of them.
+ */
+void check_remote_filters();
+
 }  // namespace tailer
 
 #endif
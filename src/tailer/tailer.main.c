@@ -38,12 +38,15 @@
 #include <stdarg.h>
 #include <limits.h>
 #include <poll.h>
+#include <regex.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/utsname.h>
 #include <ctype.h>
 #include <stdint.h>
+#include <time.h>
+#include <zlib.h>
 #endif
 
 #include "sha-256.h"
@@ -126,6 +129,104 @@ typedef enum {
     CS_SYNCED,
 } client_state_t;
 
+/**
+ * The predicates pushed down by the client for a path that was opened
+ * with the TF_FILTER feature.
+ */
+struct path_filter {
+    int64_t pf_min_mtime;
+    size_t pf_literal_count;
+    char **pf_literals;
+    size_t pf_regex_count;
+    regex_t *pf_regexes;
+};
+
+void delete_path_filter(struct path_filter *pf)
+{
+    if (pf == NULL) {
+        return;
+    }
+
+    for (size_t lpc = 0; lpc < pf->pf_literal_count; lpc++) {
+        free(pf->pf_literals[lpc]);
+    }
+    free(pf->pf_literals);
+    for (size_t lpc = 0; lpc < pf->pf_regex_count; lpc++) {
+        regfree(&pf->pf_regexes[lpc]);
+    }
+    free(pf->pf_regexes);
+    free(pf);
+}
+
+struct path_filter *create_path_filter(int64_t min_mtime,
+                                       char *literals,
+                                       char *regexes)
+{
+    struct path_filter *retval = calloc(1, sizeof(struct path_filter));
+    char *saveptr = NULL;
+    char *pattern;
+
+    retval->pf_min_mtime = min_mtime;
+    for (pattern = strtok_r(literals, "\n", &saveptr);
+         pattern != NULL;
+         pattern = strtok_r(NULL, "\n", &saveptr)) {
+        retval->pf_literals = realloc(
+            retval->pf_literals,
+            (retval->pf_literal_count + 1) * sizeof(char *));
+        retval->pf_literals[retval->pf_literal_count++] = strdup(pattern);
+    }
+
+    saveptr = NULL;
+    for (pattern = strtok_r(regexes, "\n", &saveptr);
+         pattern != NULL;
+         pattern = strtok_r(NULL, "\n", &saveptr)) {
+        regex_t re;
+        int rc = regcomp(&re, pattern, REG_EXTENDED | REG_ICASE | REG_NOSUB);
+
+        if (rc != 0) {
+            char errbuf[256];
+
+            regerror(rc, &re, errbuf, sizeof(errbuf));
+            fprintf(stderr,
+                    "warning: ignoring patterns, unable to compile '%s' -- %s\n",
+                    pattern,
+                    errbuf);
+            // Dropping just this pattern would hide lines the client wants
+            // to see, so fall back to sending every line.
+            delete_path_filter(retval);
+            retval = calloc(1, sizeof(struct path_filter));
+            retval->pf_min_mtime = min_mtime;
+            break;
+        }
+        retval->pf_regexes = realloc(
+            retval->pf_regexes,
+            (retval->pf_regex_count + 1) * sizeof(regex_t));
+        retval->pf_regexes[retval->pf_regex_count++] = re;
+    }
+
+    return retval;
+}
+
+static int path_filter_matches(const struct path_filter *pf, const char *line)
+{
+    if (pf->pf_literal_count == 0 && pf->pf_regex_count == 0) {
+        return 1;
+    }
+
+    for (size_t lpc = 0; lpc < pf->pf_literal_count; lpc++) {
+        if (strcasestr(line, pf->pf_literals[lpc]) != NULL) {
+            return 1;
+        }
+    }
+    for (size_t lpc = 0; lpc < pf->pf_regex_count; lpc++) {
+        if (regexec(&pf->pf_regexes[lpc], line, 0, NULL, 0) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 typedef enum {
     PS_UNKNOWN,
     PS_OK,
@@ -139,8 +240,13 @@ struct client_path_state {
     struct stat cps_last_stat;
     int64_t cps_client_file_offset;
     int64_t cps_client_file_size;
+    int64_t cps_last_tail_time;
     client_state_t cps_client_state;
     struct list cps_children;
+    /** The filter for a root path, children use the one from their root. */
+    struct path_filter *cps_filter;
+    /** The offset in the file that has been filtered so far. */
+    int64_t cps_remote_offset;
 };
 
 struct client_path_state *create_client_path_state(const char *path)
@@ -152,8 +258,11 @@ struct client_path_state *create_client_path_state(const char *path)
     memset(&retval->cps_last_stat, 0, sizeof(retval->cps_last_stat));
     retval->cps_client_file_offset = -1;
     retval->cps_client_file_size = 0;
+    retval->cps_last_tail_time = 0;
     retval->cps_client_state = CS_INIT;
     list_init(&retval->cps_children);
+    retval->cps_filter = NULL;
+    retval->cps_remote_offset = 0;
     return retval;
 }
 
@@ -173,6 +282,7 @@ void delete_client_path_state(struct client_path_state *cps)
 {
     free(cps->cps_path);
     delete_client_path_list(&cps->cps_children);
+    delete_path_filter(cps->cps_filter);
     free(cps);
 }
 
@@ -344,8 +454,145 @@ static int readint64(recv_state_t *state, int sock, int64_t *i)
     return 0;
 }
 
+static int read_path_filter(recv_state_t *state,
+                            int sock,
+                            struct path_filter **pf_out)
+{
+    tailer_packet_payload_type_t payload_type = read_payload_type(state, sock);
+    int64_t min_mtime = 0;
+    char *literals = NULL, *regexes = NULL;
+    int retval = -1;
+
+    *pf_out = NULL;
+    if (*state == RS_ERROR) {
+        return -1;
+    }
+    if (payload_type == TPPT_DONE) {
+        return 0;
+    }
+    if (payload_type != TPPT_INT64) {
+        fprintf(stderr, "error: expected int64, got: %d\n", payload_type);
+        return -1;
+    }
+
+    *state = RS_PAYLOAD_CONTENT;
+    *state = readall(*state, sock, &min_mtime, sizeof(min_mtime));
+    if (*state == RS_ERROR) {
+        fprintf(stderr, "error: unable to read minimum mtime\n");
+        return -1;
+    }
+
+    if ((literals = readstr(state, sock)) != NULL &&
+        (regexes = readstr(state, sock)) != NULL &&
+        read_payload_type(state, sock) == TPPT_DONE) {
+        *pf_out = create_path_filter(min_mtime, literals, regexes);
+        retval = 0;
+    }
+    free(literals);
+    free(regexes);
+
+    return retval;
+}
+
 struct list client_path_list;
 
+/**
+ * The features the client has turned on with TPT_SET_FEATURES.
+ */
+static int64_t enabled_features = 0;
+
+/**
+ * The number of paths with appended data that is being held back so that
+ * it can be sent in a single, larger block.
+ */
+static int pending_tails = 0;
+
+#define TAILER_BATCH_SIZE (64 * 1024)
+#define TAILER_BATCH_DELAY_MSECS 100
+
+static int64_t current_msecs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((int64_t) ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/**
+ * Check if the data appended to a file that is being tailed should be held
+ * back for a little while so that several small appends can be sent in one
+ * block instead of a packet for each write done by the remote process.
+ */
+static int defer_tail(const struct client_path_state *cps,
+                      int64_t offset,
+                      int64_t file_size)
+{
+    if (cps->cps_client_state != CS_TAILING) {
+        return 0;
+    }
+    if (file_size - offset >= TAILER_BATCH_SIZE) {
+        return 0;
+    }
+
+    return (current_msecs() - cps->cps_last_tail_time)
+        < TAILER_BATCH_DELAY_MSECS;
+}
+
+/**
+ * Compress a block of content if the client has enabled TF_DEFLATE and
+ * doing so actually saves some bytes.
+ *
+ * @return The compressed bits or NULL if the content should be sent as-is.
+ */
+static const unsigned char *deflate_bits(const unsigned char *bits,
+                                         int32_t len,
+                                         int32_t *zlen_out)
+{
+    static unsigned char zbuffer[4 * 1024 * 1024 + 64 * 1024];
+    uLongf zlen = sizeof(zbuffer);
+
+    if ((enabled_features & TF_DEFLATE) &&
+        compress2(zbuffer, &zlen, bits, len, Z_DEFAULT_COMPRESSION) == Z_OK &&
+        zlen < len) {
+        *zlen_out = (int32_t) zlen;
+        return zbuffer;
+    }
+
+    return NULL;
+}
+
+static void send_tail_block(const char *root_path,
+                            struct client_path_state *cps,
+                            int64_t mtime,
+                            const unsigned char *bits,
+                            int32_t len)
+{
+    int32_t zlen = 0;
+    const unsigned char *zbits = deflate_bits(bits, len, &zlen);
+
+    if (zbits != NULL) {
+        send_packet(STDOUT_FILENO,
+                    TPT_DEFLATED_TAIL_BLOCK,
+                    TPPT_STRING, root_path,
+                    TPPT_STRING, cps->cps_path,
+                    TPPT_INT64, mtime,
+                    TPPT_INT64, cps->cps_client_file_offset,
+                    TPPT_INT64, (int64_t) len,
+                    TPPT_BITS, zlen, zbits,
+                    TPPT_DONE);
+        return;
+    }
+
+    send_packet(STDOUT_FILENO,
+                TPT_TAIL_BLOCK,
+                TPPT_STRING, root_path,
+                TPPT_STRING, cps->cps_path,
+                TPPT_INT64, mtime,
+                TPPT_INT64, cps->cps_client_file_offset,
+                TPPT_BITS, len, bits,
+                TPPT_DONE);
+}
+
 struct client_path_state *find_client_path_state(struct list *path_list, const char *path)
 {
     struct client_path_state *curr = (struct client_path_state *) path_list->l_head;
@@ -388,6 +635,187 @@ void send_preview_data(int64_t id, const char *path, int32_t len, const char *bi
                 TPPT_DONE);
 }
 
+/** The most gaps that are recorded for a single filtered block. */
+#define MAX_FILTER_GAPS (64 * 1024)
+
+/**
+ * Poll a regular file under a path that was opened with a filter.  The
+ * local copy of the file only has the matching lines, so the usual
+ * offer/ack handshake cannot be used to verify it.  Instead, an empty block
+ * is offered to get the client to start tailing and then each chunk of the
+ * file is sent with only the lines that pass the filter.
+ */
+static int poll_filtered_file(struct client_path_state *root_cps,
+                              struct client_path_state *curr,
+                              const struct stat *st)
+{
+    static unsigned char buffer[4 * 1024 * 1024 + 1];
+    const struct path_filter *pf = root_cps->cps_filter;
+
+    if (curr->cps_client_state == CS_OFFERED) {
+        // Still waiting for the client ack
+        return 0;
+    }
+
+    if (curr->cps_client_file_offset < 0) {
+        if (st->st_mtime < pf->pf_min_mtime) {
+            // Everything in the file is older than the lower bound.
+            if (curr->cps_client_state != CS_SYNCED) {
+                send_packet(STDOUT_FILENO,
+                            TPT_SYNCED,
+                            TPPT_STRING, root_cps->cps_path,
+                            TPPT_STRING, curr->cps_path,
+                            TPPT_DONE);
+                curr->cps_client_state = CS_SYNCED;
+            }
+            return 0;
+        }
+
+        BYTE hash[SHA256_BLOCK_SIZE];
+        SHA256_CTX shactx;
+
+        sha256_init(&shactx);
+        sha256_final(&shactx, hash);
+        send_packet(STDOUT_FILENO,
+                    TPT_OFFER_BLOCK,
+                    TPPT_STRING, root_cps->cps_path,
+                    TPPT_STRING, curr->cps_path,
+                    TPPT_INT64, (int64_t) st->st_mtime,
+                    TPPT_INT64, (int64_t) 0,
+                    TPPT_INT64, (int64_t) 0,
+                    TPPT_HASH, hash,
+                    TPPT_DONE);
+        curr->cps_client_file_offset = 0;
+        curr->cps_remote_offset = 0;
+        curr->cps_client_state = CS_OFFERED;
+        return 1;
+    }
+
+    if (curr->cps_remote_offset > st->st_size) {
+        // The file was truncated, start over like the unfiltered path does.
+        send_error(curr, "replaced");
+        set_client_path_state_error(curr, "replace");
+        return 0;
+    }
+
+    if (curr->cps_remote_offset < st->st_size &&
+        defer_tail(curr, curr->cps_remote_offset, st->st_size)) {
+        pending_tails += 1;
+        return 0;
+    }
+
+    int64_t bytes_read = 0;
+
+    if (curr->cps_remote_offset < st->st_size) {
+        int fd = open(curr->cps_path, O_RDONLY);
+
+        if (fd == -1) {
+            set_client_path_state_error(curr, "open");
+            return 0;
+        }
+        bytes_read = pread(fd,
+                           buffer,
+                           sizeof(buffer) - 1,
+                           curr->cps_remote_offset);
+        close(fd);
+        if (bytes_read == -1) {
+            set_client_path_state_error(curr, "pread");
+            return 0;
+        }
+    }
+
+    // Only complete lines are filtered, unless a line fills the whole buffer
+    int64_t consumed = bytes_read;
+    const unsigned char *last_nl = memrchr(buffer, '\n', bytes_read);
+
+    if (last_nl != NULL) {
+        consumed = last_nl - buffer + 1;
+    } else if (bytes_read < sizeof(buffer) - 1) {
+        consumed = 0;
+    }
+
+    if (consumed == 0) {
+        if (curr->cps_client_state != CS_SYNCED) {
+            send_packet(STDOUT_FILENO,
+                        TPT_SYNCED,
+                        TPPT_STRING, root_cps->cps_path,
+                        TPPT_STRING, curr->cps_path,
+                        TPPT_DONE);
+            curr->cps_client_state = CS_SYNCED;
+        }
+        return 0;
+    }
+
+    // Compact the matching lines to the front of the buffer.  Each line is
+    // filtered on its own since the client only sends patterns for files
+    // where every line is a message.  The gaps are recorded as pairs of
+    // the offset in the compacted content and the number of bytes that
+    // were left out there, so the client knows exactly where they are.
+    static int64_t gaps[2 * MAX_FILTER_GAPS];
+    size_t gap_count = 0;
+    unsigned char *end = buffer + consumed;
+    unsigned char *line_start = buffer;
+    int64_t match_len = 0;
+
+    while (line_start < end) {
+        unsigned char *line_end = memchr(line_start, '\n', end - line_start);
+        unsigned char saved;
+        int matched;
+
+        if (line_end == NULL) {
+            line_end = end;
+        }
+        saved = *line_end;
+        *line_end = '\0';
+        matched = path_filter_matches(pf, (const char *) line_start);
+        *line_end = saved;
+
+        int64_t line_len = (line_end < end ? line_end + 1 : end) - line_start;
+
+        if (matched) {
+            memmove(&buffer[match_len], line_start, line_len);
+            match_len += line_len;
+        } else if (gap_count > 0 && gaps[2 * (gap_count - 1)] == match_len) {
+            gaps[2 * (gap_count - 1) + 1] += line_len;
+        } else if (gap_count < MAX_FILTER_GAPS) {
+            gaps[2 * gap_count] = match_len;
+            gaps[2 * gap_count + 1] = line_len;
+            gap_count += 1;
+        } else {
+            // Out of room for gaps, the rest goes in the next block.
+            break;
+        }
+        line_start += line_len;
+    }
+    consumed = line_start - buffer;
+
+    int32_t zlen = 0;
+    const unsigned char *zbits = deflate_bits(buffer, match_len, &zlen);
+
+    if (zbits == NULL) {
+        zbits = buffer;
+        zlen = match_len;
+    }
+    send_packet(STDOUT_FILENO,
+                TPT_FILTERED_TAIL_BLOCK,
+                TPPT_STRING, root_cps->cps_path,
+                TPPT_STRING, curr->cps_path,
+                TPPT_INT64, (int64_t) st->st_mtime,
+                TPPT_INT64, curr->cps_client_file_offset,
+                TPPT_INT64, curr->cps_remote_offset,
+                TPPT_INT64, consumed,
+                TPPT_INT64, match_len,
+                TPPT_BITS, zlen, zbits,
+                TPPT_BITS, (int32_t) (gap_count * 2 * sizeof(int64_t)), gaps,
+                TPPT_DONE);
+    curr->cps_client_file_offset += match_len;
+    curr->cps_remote_offset += consumed;
+    curr->cps_last_tail_time = current_msecs();
+    curr->cps_client_state = CS_TAILING;
+
+    return 1;
+}
+
 int poll_paths(struct list *path_list, struct client_path_state *root_cps)
 {
     struct client_path_state *curr = (struct client_path_state *) path_list->l_head;
@@ -507,13 +935,22 @@ int poll_paths(struct list *path_list, struct client_path_state *root_cps)
 
             retval += poll_paths(&curr->cps_children, root_cps);
 
+            curr->cps_last_path_state = PS_OK;
+        } else if (S_ISREG(st.st_mode) && root_cps->cps_filter != NULL) {
+            retval += poll_filtered_file(root_cps, curr, &st);
+
             curr->cps_last_path_state = PS_OK;
         } else if (S_ISREG(st.st_mode)) {
             switch (curr->cps_client_state) {
                 case CS_INIT:
                 case CS_TAILING:
                 case CS_SYNCED: {
-                    if (curr->cps_client_file_offset < st.st_size) {
+                    if (curr->cps_client_file_offset < st.st_size &&
+                        defer_tail(curr,
+                                   curr->cps_client_file_offset,
+                                   st.st_size)) {
+                        pending_tails += 1;
+                    } else if (curr->cps_client_file_offset < st.st_size) {
                         int fd = open(curr->cps_path, O_RDONLY);
 
                         if (fd == -1) {
@@ -612,15 +1049,13 @@ int poll_paths(struct list *path_list, struct client_path_state *root_cps)
                                     curr->cps_client_file_offset = 0;
                                 }
 
-                                send_packet(STDOUT_FILENO,
-                                            TPT_TAIL_BLOCK,
-                                            TPPT_STRING, root_cps->cps_path,
-                                            TPPT_STRING, curr->cps_path,
-                                            TPPT_INT64, (int64_t) st.st_mtime,
-                                            TPPT_INT64, curr->cps_client_file_offset,
-                                            TPPT_BITS, bytes_read, buffer,
-                                            TPPT_DONE);
+                                send_tail_block(root_cps->cps_path,
+                                                curr,
+                                                (int64_t) st.st_mtime,
+                                                buffer,
+                                                bytes_read);
                                 curr->cps_client_file_offset += bytes_read;
+                                curr->cps_last_tail_time = current_msecs();
                                 curr->cps_client_state = CS_TAILING;
                             }
                             close(fd);
@@ -921,22 +1356,26 @@ int main(int argc, char *argv[])
 
     {
         FILE *unameFile = popen("uname -mrsv", "r");
+        char buffer[1024] = "";
 
         if (unameFile != NULL) {
-            char buffer[1024];
-
-            fgets(buffer, sizeof(buffer), unameFile);
-            char *bufend = buffer + strlen(buffer) - 1;
-            while (isspace(*bufend)) {
-                bufend -= 1;
+            if (fgets(buffer, sizeof(buffer), unameFile) != NULL) {
+                char *bufend = buffer + strlen(buffer) - 1;
+                while (isspace(*bufend)) {
+                    bufend -= 1;
+                }
+                *bufend = '\0';
             }
-            *bufend = '\0';
-            send_packet(STDOUT_FILENO,
-                        TPT_ANNOUNCE,
-                        TPPT_STRING, buffer,
-                        TPPT_DONE);
             pclose(unameFile);
         }
+
+        // The announcement is always sent since the client waits for the
+        // set of supported features before opening filtered paths.
+        send_packet(STDOUT_FILENO,
+                    TPT_ANNOUNCE,
+                    TPPT_STRING, buffer,
+                    TPPT_INT64, TAILER_FEATURES,
+                    TPPT_DONE);
     }
 
     while (!done) {
@@ -963,6 +1402,7 @@ int main(int argc, char *argv[])
                     case TPT_LOAD_PREVIEW:
                     case TPT_COMPLETE_PATH: {
                         char *path = readstr(&rstate, STDIN_FILENO);
+                        struct path_filter *pf = NULL;
                         int64_t preview_id = 0;
 
                         if (type == TPT_LOAD_PREVIEW) {
@@ -974,7 +1414,9 @@ int main(int argc, char *argv[])
                         if (path == NULL) {
                             fprintf(stderr, "error: unable to get path to open\n");
                             done = 1;
-                        } else if (read_payload_type(&rstate, STDIN_FILENO) != TPPT_DONE) {
+                        } else if (type == TPT_OPEN_PATH ?
+                                   read_path_filter(&rstate, STDIN_FILENO, &pf) == -1 :
+                                   read_payload_type(&rstate, STDIN_FILENO) != TPPT_DONE) {
                             fprintf(stderr, "error: invalid open packet\n");
                             done = 1;
                         } else if (type == TPT_OPEN_PATH) {
@@ -983,10 +1425,19 @@ int main(int argc, char *argv[])
                             cps = find_client_path_state(&client_path_list, path);
                             if (cps != NULL) {
                                 fprintf(stderr, "warning: already monitoring -- %s\n", path);
+                                delete_path_filter(pf);
                             } else {
                                 cps = create_client_path_state(path);
+                                cps->cps_filter = pf;
 
                                 fprintf(stderr, "info: monitoring path: %s\n", path);
+                                if (pf != NULL) {
+                                    fprintf(stderr,
+                                            "info: filtering path with %zu "
+                                            "literal(s) and %zu regex(es)\n",
+                                            pf->pf_literal_count,
+                                            pf->pf_regex_count);
+                                }
                                 list_append(&client_path_list, &cps->cps_node);
                             }
                         } else if (type == TPT_CLOSE_PATH) {
@@ -1007,6 +1458,22 @@ int main(int argc, char *argv[])
                         free(path);
                         break;
                     }
+                    case TPT_SET_FEATURES: {
+                        int64_t features = 0;
+
+                        if (readint64(&rstate, STDIN_FILENO, &features) == -1) {
+                            done = 1;
+                        } else if (read_payload_type(&rstate, STDIN_FILENO) != TPPT_DONE) {
+                            fprintf(stderr, "error: invalid features packet\n");
+                            done = 1;
+                        } else {
+                            enabled_features = features & TAILER_FEATURES;
+                            fprintf(stderr,
+                                    "info: enabled features -- %lld\n",
+                                    enabled_features);
+                        }
+                        break;
+                    }
                     case TPT_ACK_BLOCK:
                     case TPT_NEED_BLOCK: {
                         char *path = readstr(&rstate, STDIN_FILENO);
@@ -1060,8 +1527,11 @@ int main(int argc, char *argv[])
         }
 
         if (!done) {
+            pending_tails = 0;
             if (poll_paths(&client_path_list, NULL)) {
                 timeout = 0;
+            } else if (pending_tails > 0) {
+                timeout = TAILER_BATCH_DELAY_MSECS;
             } else {
                 timeout = 1000;
             }
@@ -29,7 +29,9 @@
 
 #include "tailerpp.hh"
 
+#include <string.h>
 #include <unistd.h>
+#include <zlib.h>
 
 namespace tailer {
 
@@ -62,6 +64,48 @@ readall(int sock, void* buf, size_t len)
     return 0;
 }
 
+/**
+ * Fill in the bits of a tail block from the content received over the
+ * wire, inflating them if they were compressed.
+ */
+static Result<void, std::string>
+inflate_tail_block(packet_tail_block& ptb,
+                   std::vector<uint8_t> zbits,
+                   int64_t content_length)
+{
+    ptb.ptb_wire_length = zbits.size();
+    if (zbits.size() == (size_t) content_length) {
+        ptb.ptb_bits = std::move(zbits);
+        return Ok();
+    }
+
+    try {
+        ptb.ptb_bits.resize(content_length);
+    } catch (...) {
+        return Err(fmt::format(FMT_STRING("unable to resize tail block to {}"),
+                               content_length));
+    }
+
+    uLongf inflated_length = content_length;
+    auto rc = ::uncompress(
+        ptb.ptb_bits.data(), &inflated_length, zbits.data(), zbits.size());
+    if (rc != Z_OK) {
+        return Err(
+            fmt::format(FMT_STRING("unable to inflate tail block for {} -- {}"),
+                        ptb.ptb_path,
+                        zError(rc)));
+    }
+    if (inflated_length != (uLongf) content_length) {
+        return Err(fmt::format(
+            FMT_STRING("tail block for {} has length {}, expected {}"),
+            ptb.ptb_path,
+            inflated_length,
+            content_length));
+    }
+
+    return Ok();
+}
+
 Result<packet, std::string>
 read_packet(int fd)
 {
@@ -79,8 +123,31 @@ read_packet(int fd)
         }
         case TPT_ANNOUNCE: {
             packet_announce pa;
+            tailer_packet_payload_type_t payload_type;
 
-            TRY(read_payloads_into(fd, pa.pa_uname));
+            TRY(TRY(TRY(protocol_recv<TPPT_STRING>::create(fd))
+                        .read_length(pa.pa_uname))
+                    .read_content(pa.pa_uname));
+            // Older tailers do not send the set of features they support.
+            if (readall(fd, &payload_type, sizeof(payload_type)) == -1) {
+                return Err(
+                    fmt::format(FMT_STRING("unable to read payload type: {}"),
+                                strerror(errno)));
+            }
+            if (payload_type == TPPT_INT64) {
+                if (readall(fd, &pa.pa_features, sizeof(pa.pa_features))
+                    == -1)
+                {
+                    return Err(fmt::format(
+                        FMT_STRING("unable to read features: {}"),
+                        strerror(errno)));
+                }
+                TRY(read_payloads_into(fd));
+            } else if (payload_type != TPPT_DONE) {
+                return Err(fmt::format(
+                    FMT_STRING("unexpected payload-type in announce: {}"),
+                    (int) payload_type));
+            }
             return Ok(packet{pa});
         }
         case TPT_OFFER_BLOCK: {
@@ -104,6 +171,53 @@ read_packet(int fd)
                                    ptb.ptb_mtime,
                                    ptb.ptb_offset,
                                    ptb.ptb_bits));
+            ptb.ptb_wire_length = ptb.ptb_bits.size();
+            ptb.ptb_remote_offset = ptb.ptb_offset;
+            ptb.ptb_remote_length = ptb.ptb_bits.size();
+            return Ok(packet{ptb});
+        }
+        case TPT_FILTERED_TAIL_BLOCK: {
+            packet_tail_block ptb;
+            int64_t content_length;
+            std::vector<uint8_t> zbits;
+            std::vector<uint8_t> gap_bits;
+
+            TRY(read_payloads_into(fd,
+                                   ptb.ptb_root_path,
+                                   ptb.ptb_path,
+                                   ptb.ptb_mtime,
+                                   ptb.ptb_offset,
+                                   ptb.ptb_remote_offset,
+                                   ptb.ptb_remote_length,
+                                   content_length,
+                                   zbits,
+                                   gap_bits));
+            TRY(inflate_tail_block(ptb, std::move(zbits), content_length));
+            for (size_t off = 0; off + 2 * sizeof(int64_t) <= gap_bits.size();
+                 off += 2 * sizeof(int64_t))
+            {
+                int64_t gap[2];
+
+                memcpy(gap, &gap_bits[off], sizeof(gap));
+                ptb.ptb_gaps.emplace_back(gap[0], gap[1]);
+            }
+            return Ok(packet{ptb});
+        }
+        case TPT_DEFLATED_TAIL_BLOCK: {
+            packet_tail_block ptb;
+            int64_t content_length;
+            std::vector<uint8_t> zbits;
+
+            TRY(read_payloads_into(fd,
+                                   ptb.ptb_root_path,
+                                   ptb.ptb_path,
+                                   ptb.ptb_mtime,
+                                   ptb.ptb_offset,
+                                   content_length,
+                                   zbits));
+            TRY(inflate_tail_block(ptb, std::move(zbits), content_length));
+            ptb.ptb_remote_offset = ptb.ptb_offset;
+            ptb.ptb_remote_length = content_length;
             return Ok(packet{ptb});
         }
         case TPT_SYNCED: {
@@ -31,6 +31,7 @@
 #define lnav_tailerpp_hh
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/result.h"
@@ -50,6 +51,7 @@ struct packet_error {
 
 struct packet_announce {
     std::string pa_uname;
+    int64_t pa_features{0};
 };
 
 struct hash_frag {
@@ -81,6 +83,20 @@ struct packet_tail_block {
     int64_t ptb_mtime;
     int64_t ptb_offset;
     std::vector<uint8_t> ptb_bits;
+    /** The number of content bytes that were sent over the wire. */
+    int64_t ptb_wire_length{0};
+    /**
+     * The range of the remote file covered by this block.  For a filtered
+     * file, this can be larger than the bits since the lines that did not
+     * match were elided.
+     */
+    int64_t ptb_remote_offset{0};
+    int64_t ptb_remote_length{0};
+    /**
+     * For a filtered file, the offsets in the bits where lines were left
+     * out paired with the number of bytes that were left out there.
+     */
+    std::vector<std::pair<int64_t, int64_t>> ptb_gaps;
 };
 
 struct packet_synced {
@@ -48,3 +48,59 @@ tailer stderr:
 info: monitoring path: foo
 info: exiting...
 EOF
+
+for i in $(seq 1 200); do
+    cat ${test_dir}/logfile_access_log.0
+done > tail-big.0
+
+run_test ./drive_tailer tail tail-big.0
+
+grep -q "content matches: yes" `test_filename` || {
+    echo "error: plain tail did not mirror the file"
+    cat `test_filename`
+    exit 1
+}
+raw_wire=$(grep '^wire bytes:' `test_filename` | cut -d ' ' -f 3)
+
+run_test ./drive_tailer tail-deflate tail-big.0
+
+grep -q "content matches: yes" `test_filename` || {
+    echo "error: deflated tail did not mirror the file"
+    cat `test_filename`
+    exit 1
+}
+deflate_wire=$(grep '^wire bytes:' `test_filename` | cut -d ' ' -f 3)
+
+echo "tail block bytes on the wire: plain=${raw_wire} deflate=${deflate_wire}"
+if test "${deflate_wire}" -ge "${raw_wire}"; then
+    echo "error: compressed tail blocks are not smaller"
+    exit 1
+fi
+
+run_test ./drive_tailer tail-filter tail-big.0 ' 404 |POST '
+
+{
+    echo "Got an offer: tail-big.0  0 - 0"
+    echo "all done!"
+    grep -iE ' 404 |POST ' tail-big.0
+} > tail-big.0.expected
+check_output "filtered tail did not match grep" < tail-big.0.expected
+filter_wire=$(grep '^wire bytes:' `test_err_filename` | cut -d ' ' -f 3)
+
+grep -q "gaps match: yes" `test_err_filename` || {
+    echo "error: the filtered gaps do not line up with the file"
+    cat `test_err_filename`
+    exit 1
+}
+
+run_test ./drive_tailer tail-filter-deflate tail-big.0 ' 404 |POST '
+
+check_output "compressed filtered tail did not match grep" \
+    < tail-big.0.expected
+filter_deflate_wire=$(grep '^wire bytes:' `test_err_filename` | cut -d ' ' -f 3)
+
+echo "filtered bytes on the wire: plain=${filter_wire} deflate=${filter_deflate_wire}"
+if test "${filter_deflate_wire}" -ge "${filter_wire}"; then
+    echo "error: compressed filtered blocks are not smaller"
+    exit 1
+fi
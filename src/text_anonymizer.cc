@@ -27,7 +27,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <filesystem>
+#include <future>
+#include <thread>
 
 #include "text_anonymizer.hh"
 
@@ -168,7 +171,7 @@ text_anonymizer::next(string_fragment line)
                         == CURLUE_OK)
                     {
                         auto anon_user = this->get_default(
-                            this->ta_user_names,
+                            &text_anonymizer::ta_user_names,
                             url_part.in(),
                             [](size_t size, auto& user) {
                                 return get_animal_list().at_index(size);
@@ -200,7 +203,7 @@ text_anonymizer::next(string_fragment line)
                         == CURLUE_OK)
                     {
                         auto anon_host = this->get_default(
-                            this->ta_host_names,
+                            &text_anonymizer::ta_host_names,
                             url_part.in(),
                             [](size_t size, auto& hn) {
                                 const auto& diseases = get_disease_list();
@@ -340,7 +343,7 @@ text_anonymizer::next(string_fragment line)
                 auto mac_addr = tok_res->to_string();
 
                 retval += this->get_default(
-                    this->ta_mac_addresses,
+                    &text_anonymizer::ta_mac_addresses,
                     mac_addr,
                     [](size_t size, auto& inp) {
                         uint32_t base_mac = 0x5e005300;
@@ -376,7 +379,9 @@ text_anonymizer::next(string_fragment line)
             case DT_IPV4_ADDRESS: {
                 auto ipv4 = tok_res->to_string();
                 retval += this->get_default(
-                    this->ta_ipv4_addresses, ipv4, [](size_t size, auto& _) {
+                    &text_anonymizer::ta_ipv4_addresses,
+                    ipv4,
+                    [](size_t size, auto& _) {
                         char anon_ipv4[INET_ADDRSTRLEN];
                         struct in_addr ia;
 
@@ -390,7 +395,9 @@ text_anonymizer::next(string_fragment line)
             case DT_IPV6_ADDRESS: {
                 auto ipv6 = tok_res->to_string();
                 retval += this->get_default(
-                    this->ta_ipv6_addresses, ipv6, [](size_t size, auto& _) {
+                    &text_anonymizer::ta_ipv6_addresses,
+                    ipv6,
+                    [](size_t size, auto& _) {
                         char anon_ipv6[INET6_ADDRSTRLEN];
                         struct in6_addr ia;
                         uint32_t* ia6_addr32 = (uint32_t*) &ia.s6_addr[12];
@@ -408,13 +415,13 @@ text_anonymizer::next(string_fragment line)
 
                 retval += fmt::format(
                     FMT_STRING("{}@{}.example.com"),
-                    this->get_default(this->ta_user_names,
+                    this->get_default(&text_anonymizer::ta_user_names,
                                       email_addr.substr(0, at_index),
                                       [](auto size, const auto& inp) {
                                           return get_animal_list().at_index(
                                               size);
                                       }),
-                    this->get_default(this->ta_host_names,
+                    this->get_default(&text_anonymizer::ta_host_names,
                                       email_addr.substr(at_index + 1),
                                       [](auto size, const auto& inp) {
                                           return get_disease_list().at_index(
@@ -446,7 +453,9 @@ text_anonymizer::next(string_fragment line)
                               auto comp = md.leading().to_string();
                               retval
                                   += this->get_default(
-                                         this->ta_symbols, comp, sym_provider)
+                                         &text_anonymizer::ta_symbols,
+                                         comp,
+                                         sym_provider)
                                   + md[0]->to_string();
                           });
                 if (cap_res.isErr()) {
@@ -455,7 +464,7 @@ text_anonymizer::next(string_fragment line)
                     auto remaining = cap_res.unwrap().to_string();
 
                     retval += this->get_default(
-                        this->ta_symbols, remaining, sym_provider);
+                        &text_anonymizer::ta_symbols, remaining, sym_provider);
                 }
                 break;
             }
@@ -533,4 +542,97 @@ text_anonymizer::next(string_fragment line)
     return retval;
 }
 
+std::vector<std::string>
+text_anonymizer::next_batch(const std::vector<std::string>& lines,
+                            size_t threads)
+{
+    static constexpr size_t MIN_LINES_PER_SHARD = 64;
+
+    std::vector<std::string> retval(lines.size());
+
+    if (threads == 0) {
+        threads = std::clamp(std::thread::hardware_concurrency(), 1U, 8U);
+    }
+
+    auto shard_count = std::min(threads,
+                                (lines.size() + MIN_LINES_PER_SHARD - 1)
+                                    / MIN_LINES_PER_SHARD);
+    if (shard_count <= 1) {
+        for (size_t lpc = 0; lpc < lines.size(); lpc++) {
+            retval[lpc] = this->next(lines[lpc]);
+        }
+        return retval;
+    }
+
+    // The values handed out depend on the order in which inputs are first
+    // seen, so the workers cannot add to the mappings themselves.  Instead,
+    // each worker anonymizes a contiguous shard of lines using the current
+    // mappings and makes up values for anything new.  The new inputs are
+    // then added to the mappings in line order, which is the same order a
+    // serial pass would have seen them in.  Finally, the lines that used a
+    // made-up value are redone with the complete mappings.
+    struct shard {
+        explicit shard(const text_anonymizer* shared) : s_anonymizer(shared)
+        {
+        }
+
+        text_anonymizer s_anonymizer;
+        size_t s_begin{0};
+        size_t s_end{0};
+        std::vector<size_t> s_redo;
+    };
+
+    std::vector<shard> shards;
+    auto lines_per_shard = (lines.size() + shard_count - 1) / shard_count;
+
+    shards.reserve(shard_count);
+    for (size_t start = 0; start < lines.size(); start += lines_per_shard) {
+        auto& sh = shards.emplace_back(this);
+
+        sh.s_begin = start;
+        sh.s_end = std::min(start + lines_per_shard, lines.size());
+    }
+
+    auto run_shards = [&shards](auto func) {
+        std::vector<std::future<void>> futures;
+
+        futures.reserve(shards.size() - 1);
+        for (size_t lpc = 1; lpc < shards.size(); lpc++) {
+            futures.emplace_back(
+                std::async(std::launch::async, func, std::ref(shards[lpc])));
+        }
+        func(shards[0]);
+        for (auto& fut : futures) {
+            fut.get();
+        }
+    };
+
+    run_shards([&lines, &retval](shard& sh) {
+        auto& ta = sh.s_anonymizer;
+
+        for (auto lpc = sh.s_begin; lpc < sh.s_end; lpc++) {
+            ta.ta_used_provisional = false;
+            retval[lpc] = ta.next(lines[lpc]);
+            if (ta.ta_used_provisional) {
+                sh.s_redo.emplace_back(lpc);
+            }
+        }
+    });
+
+    for (auto& sh : shards) {
+        for (const auto& sight : sh.s_anonymizer.ta_sightings) {
+            this->get_default(
+                sight.s_mapping, sight.s_input, sight.s_provider);
+        }
+    }
+
+    run_shards([&lines, &retval](shard& sh) {
+        for (auto lpc : sh.s_redo) {
+            retval[lpc] = sh.s_anonymizer.next(lines[lpc]);
+        }
+    });
+
+    return retval;
+}
+
 }  // namespace lnav
@@ -30,7 +30,9 @@
 #ifndef lnav_text_anonymizer_hh
 #define lnav_text_anonymizer_hh
 
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "base/intern_string.hh"
 #include "robin_hood/robin_hood.h"
@@ -43,30 +45,83 @@ public:
 
     std::string next(string_fragment line);
 
+    /**
+     * Anonymize a batch of lines by splitting them across worker threads.
+     * The result is the same as calling next() on each line in order, no
+     * matter how many threads are used.
+     *
+     * @param lines The lines to anonymize.
+     * @param threads The maximum number of threads to use or zero to pick
+     *   a count based on the number of cores.
+     * @return The anonymized lines, in the same order as the input.
+     */
+    std::vector<std::string> next_batch(const std::vector<std::string>& lines,
+                                        size_t threads = 0);
+
 private:
+    using mapping_t = robin_hood::unordered_map<std::string, std::string>;
+    using provider_t = std::function<std::string(size_t, const std::string&)>;
+
+    /**
+     * A value that a worker had to make up because it was not in the shared
+     * mapping.  The real value is assigned when the sightings from all the
+     * workers are merged in input order.
+     */
+    struct sighting {
+        mapping_t text_anonymizer::*s_mapping;
+        std::string s_input;
+        provider_t s_provider;
+    };
+
+    explicit text_anonymizer(const text_anonymizer* shared)
+        : ta_shared(shared)
+    {
+    }
+
     template<typename F>
-    const std::string& get_default(
-        robin_hood::unordered_map<std::string, std::string>& mapping,
-        const std::string& input,
-        F provider)
+    const std::string& get_default(mapping_t text_anonymizer::*mapping,
+                                   const std::string& input,
+                                   F provider)
     {
-        auto iter = mapping.find(input);
-        if (iter == mapping.end()) {
-            auto emp_res
-                = mapping.emplace(input, provider(mapping.size(), input));
+        if (this->ta_shared != nullptr) {
+            const auto& shared_mapping = this->ta_shared->*mapping;
+            auto shared_iter = shared_mapping.find(input);
+            if (shared_iter != shared_mapping.end()) {
+                return shared_iter->second;
+            }
+            this->ta_used_provisional = true;
+        }
+
+        auto& local_mapping = this->*mapping;
+        auto iter = local_mapping.find(input);
+        if (iter == local_mapping.end()) {
+            auto emp_res = local_mapping.emplace(
+                input, provider(local_mapping.size(), input));
 
             iter = emp_res.first;
+            if (this->ta_shared != nullptr) {
+                this->ta_sightings.emplace_back(
+                    sighting{mapping, input, provider});
+            }
         }
 
         return iter->second;
     }
 
-    robin_hood::unordered_map<std::string, std::string> ta_mac_addresses;
-    robin_hood::unordered_map<std::string, std::string> ta_ipv4_addresses;
-    robin_hood::unordered_map<std::string, std::string> ta_ipv6_addresses;
-    robin_hood::unordered_map<std::string, std::string> ta_user_names;
-    robin_hood::unordered_map<std::string, std::string> ta_host_names;
-    robin_hood::unordered_map<std::string, std::string> ta_symbols;
+    mapping_t ta_mac_addresses;
+    mapping_t ta_ipv4_addresses;
+    mapping_t ta_ipv6_addresses;
+    mapping_t ta_user_names;
+    mapping_t ta_host_names;
+    mapping_t ta_symbols;
+
+    /**
+     * For workers in next_batch(), the anonymizer whose mappings are
+     * consulted, read-only, before making up a value.
+     */
+    const text_anonymizer* ta_shared{nullptr};
+    std::vector<sighting> ta_sightings;
+    bool ta_used_provisional{false};
 };
 
 }  // namespace lnav
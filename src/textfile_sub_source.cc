@@ -53,6 +53,51 @@
 
 using namespace lnav::roles::literals;
 
+/**
+ * Documents at least this large have their metadata discovered and their
+ * content rendered on a worker thread when the UI is running so that it
+ * does not freeze while that work is done.
+ */
+static constexpr file_ssize_t BACKGROUND_WORK_SIZE = 1024 * 1024;
+/**
+ * The number of pretty-printed lines to collect before handing them over to
+ * the view.
+ */
+static constexpr size_t RENDER_BATCH_LINES = 1000;
+
+/**
+ * The size of the pieces that a file is read in when it is pretty-printed.
+ */
+static constexpr file_ssize_t PRETTY_PRINT_WINDOW_SIZE = 1024 * 1024;
+
+/**
+ * Get the ranges of the file to pass to the pretty-printer.  Files with line
+ * metadata need to be read a line at a time so that the metadata is removed.
+ * Other files are read in fixed-size windows since the line_buffer splits
+ * very long lines and the pieces need to be joined back together.
+ */
+static std::vector<file_range>
+pretty_print_ranges(logfile& lf)
+{
+    std::vector<file_range> retval;
+
+    if (lf.has_line_metadata()) {
+        for (auto iter = lf.begin(); iter != lf.end(); ++iter) {
+            retval.emplace_back(lf.get_file_range(iter));
+        }
+    } else if (lf.size() > 0) {
+        auto off = lf.begin()->get_offset();
+        auto end = lf.get_index_size();
+        while (off < end) {
+            auto size = std::min(PRETTY_PRINT_WINDOW_SIZE, end - off);
+            retval.emplace_back(file_range{off, size});
+            off += size;
+        }
+    }
+
+    return retval;
+}
+
 static bool
 file_needs_reformatting(const std::shared_ptr<logfile> lf)
 {
@@ -725,12 +770,115 @@ textfile_sub_source::text_crumbs_for_line(
     }
 }
 
+void
+textfile_sub_source::apply_discovery(file_view_state& fvs,
+                                     scan_callback& callback,
+                                     discovery_result dr)
+{
+    const auto& lf = fvs.fvs_file;
+
+    if (dr.dr_text_meta) {
+        lf->set_filename(dr.dr_text_meta->tfm_filename);
+        lf->set_include_in_session(true);
+        callback.renamed_file(lf);
+    }
+
+    fvs.fvs_mtime = dr.dr_mtime;
+    fvs.fvs_file_size = dr.dr_file_size;
+    fvs.fvs_metadata = std::move(dr.dr_metadata);
+}
+
+void
+textfile_sub_source::apply_render(file_view_state& fvs, render_result rdr)
+{
+    static auto& lnav_db = injector::get<auto_sqlite3&>();
+
+    const auto& lf = fvs.fvs_file;
+
+    fvs.fvs_mtime = rdr.rdr_mtime;
+    fvs.fvs_file_indexed_size = rdr.rdr_file_indexed_size;
+    fvs.fvs_file_size = rdr.rdr_file_size;
+    if (!rdr.rdr_error.empty()) {
+        // Show the raw text instead of a partial rendering that looks
+        // complete.
+        log_error("%s: unable to render file -- %s",
+                  lf->get_path_for_key().c_str(),
+                  rdr.rdr_error.c_str());
+        fvs.fvs_error = std::move(rdr.rdr_error);
+        fvs.fvs_render_progress = nullptr;
+        fvs.fvs_text_source = nullptr;
+        this->tss_view->set_needs_update();
+        return;
+    }
+    if (rdr.rdr_streamed) {
+        this->drain_render_progress(fvs);
+        fvs.fvs_render_progress = nullptr;
+        if (fvs.fvs_text_source == nullptr) {
+            fvs.fvs_text_source = std::make_unique<plain_text_source>();
+            fvs.fvs_text_source->set_text_format(lf->get_text_format());
+            fvs.fvs_text_source->register_view(this->tss_view);
+        }
+    } else {
+        fvs.fvs_text_source = std::make_unique<plain_text_source>();
+        fvs.fvs_text_source->set_text_format(lf->get_text_format());
+        fvs.fvs_text_source->register_view(this->tss_view);
+        fvs.fvs_text_source->replace_with(rdr.rdr_content);
+    }
+
+    if (lf->get_text_format() != text_format_t::TF_MARKDOWN
+        || !rdr.rdr_parsed)
+    {
+        return;
+    }
+
+    if (!rdr.rdr_frontmatter.empty()) {
+        auto& lf_meta = lf->get_embedded_metadata();
+
+        lf_meta["net.daringfireball.markdown.frontmatter"]
+            = {rdr.rdr_frontmatter_format, rdr.rdr_frontmatter};
+    }
+
+    lnav::events::publish(lnav_db,
+                          lnav::events::file::format_detected{
+                              lf->get_filename(),
+                              fmt::to_string(lf->get_text_format()),
+                          });
+}
+
+size_t
+textfile_sub_source::drain_render_progress(file_view_state& fvs)
+{
+    std::vector<attr_line_t> lines;
+
+    if (fvs.fvs_render_progress == nullptr) {
+        return 0;
+    }
+    {
+        std::lock_guard<std::mutex> lg(fvs.fvs_render_progress->rp_mutex);
+
+        lines.swap(fvs.fvs_render_progress->rp_lines);
+    }
+    if (lines.empty()) {
+        return 0;
+    }
+
+    if (fvs.fvs_text_source == nullptr) {
+        fvs.fvs_text_source = std::make_unique<plain_text_source>();
+        fvs.fvs_text_source->set_text_format(fvs.fvs_file->get_text_format());
+        fvs.fvs_text_source->register_view(this->tss_view);
+    }
+    for (auto& al : lines) {
+        fvs.fvs_text_source->append_line(std::move(al));
+    }
+    this->tss_view->set_needs_update();
+
+    return lines.size();
+}
+
 textfile_sub_source::rescan_result_t
 textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
                                   std::optional<ui_clock::time_point> deadline)
 {
-    static auto& lnav_db = injector::get<auto_sqlite3&>();
-
     file_iterator iter;
     rescan_result_t retval;
     size_t files_scanned = 0;
@@ -758,6 +906,11 @@ textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
         }
 
         if (!this->tss_completed_last_scan && lf->size() > 0) {
+            if (iter->fvs_pending_discovery.valid()
+                || iter->fvs_pending_render.valid())
+            {
+                retval.rr_background_work += 1;
+            }
             ++iter;
             continue;
         }
@@ -811,8 +964,16 @@ textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
                     }
                 }
 
-                if (!iter->fvs_metadata.m_sections_root
-                    && iter->fvs_error.empty())
+                if (iter->fvs_pending_discovery.valid()) {
+                    if (deadline && !iter->fvs_pending_discovery.is_ready()) {
+                        retval.rr_background_work += 1;
+                    } else {
+                        this->apply_discovery(
+                            *iter, callback, iter->fvs_pending_discovery.get());
+                        retval.rr_new_data += 1;
+                    }
+                } else if (!iter->fvs_metadata.m_sections_root
+                           && iter->fvs_error.empty())
                 {
                     auto read_res
                         = lf->read_file(logfile::read_format_t::with_framing);
@@ -828,29 +989,54 @@ textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
                             iter->fvs_mtime = st.st_mtime;
                             iter->fvs_file_size = lf->get_index_size();
                         } else {
-                            auto content
-                                = attr_line_t(read_file_res.rfr_content);
+                            auto background = deadline.has_value()
+                                && read_file_res.rfr_content.size()
+                                    >= BACKGROUND_WORK_SIZE;
 
-                            log_info("generating metadata for: %s (size=%zu)",
+                            log_info("generating metadata for: %s (size=%zu%s)",
                                      lf->get_path_for_key().c_str(),
-                                     content.length());
-                            scrub_ansi_string(content.get_string(),
-                                              &content.get_attrs());
-
-                            auto text_meta = extract_text_meta(
-                                content.get_string(), lf->get_text_format());
-                            if (text_meta) {
-                                lf->set_filename(text_meta->tfm_filename);
-                                lf->set_include_in_session(true);
-                                callback.renamed_file(lf);
+                                     read_file_res.rfr_content.size(),
+                                     background ? ", in background" : "");
+                            auto job = [mtime = st.st_mtime,
+                                        file_size = lf->get_index_size(),
+                                        tf = lf->get_text_format(),
+                                        content_str = std::move(
+                                            read_file_res.rfr_content)](
+                                           discovery_task::context& ctx) {
+                                discovery_result retval;
+                                auto content = attr_line_t(content_str);
+
+                                scrub_ansi_string(content.get_string(),
+                                                  &content.get_attrs());
+
+                                retval.dr_mtime = mtime;
+                                retval.dr_file_size = file_size;
+                                if (ctx.is_cancelled()) {
+                                    return retval;
+                                }
+                                retval.dr_text_meta = extract_text_meta(
+                                    content.get_string(), tf);
+                                retval.dr_metadata
+                                    = lnav::document::discover(content)
+                                          .with_text_format(tf)
+                                          .with_cancel_check([&ctx]() {
+                                              return ctx.is_cancelled();
+                                          })
+                                          .perform();
+
+                                return retval;
+                            };
+
+                            if (background) {
+                                iter->fvs_pending_discovery
+                                    = discovery_task::start(std::move(job));
+                                retval.rr_background_work += 1;
+                            } else {
+                                discovery_task::context ctx;
+
+                                this->apply_discovery(
+                                    *iter, callback, job(ctx));
                             }
-
-                            iter->fvs_mtime = st.st_mtime;
-                            iter->fvs_file_size = lf->get_index_size();
-                            iter->fvs_metadata
-                                = lnav::document::discover(content)
-                                      .with_text_format(lf->get_text_format())
-                                      .perform();
                         }
                     } else {
                         auto errmsg = read_res.unwrapErr();
@@ -879,7 +1065,21 @@ textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
                 lfo->lfo_filter_state.tfs_index.push_back(lpc);
             }
 
-            if (lf->get_text_format() == text_format_t::TF_MARKDOWN) {
+            if (iter->fvs_pending_render.valid()) {
+                if (this->drain_render_progress(*iter) > 0) {
+                    retval.rr_new_data += 1;
+                }
+                if (deadline && !iter->fvs_pending_render.is_ready()) {
+                    auto prog = iter->fvs_pending_render.get_progress();
+
+                    retval.rr_background_work += 1;
+                    retval.rr_background_done += prog.first;
+                    retval.rr_background_total += prog.second;
+                } else {
+                    this->apply_render(*iter, iter->fvs_pending_render.get());
+                    retval.rr_new_data += 1;
+                }
+            } else if (lf->get_text_format() == text_format_t::TF_MARKDOWN) {
                 if (iter->fvs_text_source) {
                     if (iter->fvs_file_size == st.st_size
                         && iter->fvs_file_indexed_size == lf->get_index_size()
@@ -895,108 +1095,125 @@ textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
 
                 auto read_res = lf->read_file(logfile::read_format_t::plain);
                 if (read_res.isOk()) {
-                    static const auto FRONT_MATTER_RE
-                        = lnav::pcre2pp::code::from_const(
-                            R"((?:^---\n(.*)\n---\n|^\+\+\+\n(.*)\n\+\+\+\n))",
-                            PCRE2_MULTILINE | PCRE2_DOTALL);
-                    thread_local auto md = FRONT_MATTER_RE.create_match_data();
-
                     auto read_file_res = read_res.unwrap();
-                    auto content_sf
-                        = string_fragment::from_str(read_file_res.rfr_content);
-                    std::string frontmatter;
-                    auto frontmatter_format = text_format_t::TF_UNKNOWN;
-
-                    auto cap_res = FRONT_MATTER_RE.capture_from(content_sf)
-                                       .into(md)
-                                       .matches()
-                                       .ignore_error();
-                    if (cap_res) {
-                        if (md[1]) {
-                            frontmatter_format = text_format_t::TF_YAML;
-                            frontmatter = md[1]->to_string();
-                        } else if (md[2]) {
-                            frontmatter_format = text_format_t::TF_TOML;
-                            frontmatter = md[2]->to_string();
+                    auto background = deadline.has_value()
+                        && read_file_res.rfr_content.size()
+                            >= BACKGROUND_WORK_SIZE;
+
+                    log_info("%s: rendering markdown content of size %zu%s",
+                             lf->get_basename().c_str(),
+                             read_file_res.rfr_content.size(),
+                             background ? " in background" : "");
+                    auto job = [mtime = st.st_mtime,
+                                file_size = st.st_size,
+                                indexed_size = lf->get_index_size(),
+                                filename = lf->get_filename(),
+                                source_path = lf->get_actual_path(),
+                                content = std::move(read_file_res.rfr_content)](
+                                   render_task::context& ctx) {
+                        static const auto FRONT_MATTER_RE
+                            = lnav::pcre2pp::code::from_const(
+                                R"((?:^---\n(.*)\n---\n|^\+\+\+\n(.*)\n\+\+\+\n))",
+                                PCRE2_MULTILINE | PCRE2_DOTALL);
+                        thread_local auto md
+                            = FRONT_MATTER_RE.create_match_data();
+
+                        render_result retval;
+                        auto content_sf = string_fragment::from_str(content);
+
+                        retval.rdr_mtime = mtime;
+                        retval.rdr_file_size = file_size;
+                        retval.rdr_file_indexed_size = indexed_size;
+                        if (ctx.is_cancelled()) {
+                            return retval;
                         }
-                        content_sf = cap_res->f_remaining;
-                    } else if (content_sf.startswith("{")) {
-                        yajlpp_parse_context ypc(
-                            intern_string::lookup(lf->get_filename()));
-                        auto handle
-                            = yajlpp::alloc_handle(&ypc.ypc_callbacks, &ypc);
-
-                        yajl_config(
-                            handle.in(), yajl_allow_trailing_garbage, 1);
-                        ypc.with_ignore_unused(true)
-                            .with_handle(handle.in())
-                            .with_error_reporter(
-                                [&lf](const auto& ypc, const auto& um) {
+
+                        auto cap_res = FRONT_MATTER_RE.capture_from(content_sf)
+                                           .into(md)
+                                           .matches()
+                                           .ignore_error();
+                        if (cap_res) {
+                            if (md[1]) {
+                                retval.rdr_frontmatter_format
+                                    = text_format_t::TF_YAML;
+                                retval.rdr_frontmatter = md[1]->to_string();
+                            } else if (md[2]) {
+                                retval.rdr_frontmatter_format
+                                    = text_format_t::TF_TOML;
+                                retval.rdr_frontmatter = md[2]->to_string();
+                            }
+                            content_sf = cap_res->f_remaining;
+                        } else if (content_sf.startswith("{")) {
+                            yajlpp_parse_context ypc(
+                                intern_string::lookup(filename));
+                            auto handle = yajlpp::alloc_handle(
+                                &ypc.ypc_callbacks, &ypc);
+
+                            yajl_config(
+                                handle.in(), yajl_allow_trailing_garbage, 1);
+                            ypc.with_ignore_unused(true)
+                                .with_handle(handle.in())
+                                .with_error_reporter([&filename](
+                                                         const auto& ypc,
+                                                         const auto& um) {
                                     log_error(
-                                        "%s: failed to parse JSON front matter "
-                                        "-- %s",
-                                        lf->get_filename().c_str(),
+                                        "%s: failed to parse JSON front "
+                                        "matter -- %s",
+                                        filename.c_str(),
                                         um.um_reason.al_string.c_str());
                                 });
-                        if (ypc.parse_doc(content_sf)) {
-                            auto consumed = ypc.ypc_total_consumed;
-                            if (consumed < content_sf.length()
-                                && content_sf[consumed] == '\n')
-                            {
-                                frontmatter_format = text_format_t::TF_JSON;
-                                frontmatter = string_fragment::from_str_range(
-                                                  read_file_res.rfr_content,
-                                                  0,
-                                                  consumed)
-                                                  .to_string();
-                                content_sf = content_sf.substr(consumed);
+                            if (ypc.parse_doc(content_sf)) {
+                                auto consumed = ypc.ypc_total_consumed;
+                                if (consumed < content_sf.length()
+                                    && content_sf[consumed] == '\n')
+                                {
+                                    retval.rdr_frontmatter_format
+                                        = text_format_t::TF_JSON;
+                                    retval.rdr_frontmatter
+                                        = string_fragment::from_str_range(
+                                              content, 0, consumed)
+                                              .to_string();
+                                    content_sf = content_sf.substr(consumed);
+                                }
                             }
                         }
-                    }
 
-                    log_info("%s: rendering markdown content of size %d",
-                             lf->get_basename().c_str(),
-                             read_file_res.rfr_content.size());
-                    md2attr_line mdal;
-
-                    mdal.with_source_path(lf->get_actual_path());
-                    auto parse_res = md4cpp::parse(content_sf, mdal);
-
-                    iter->fvs_mtime = st.st_mtime;
-                    iter->fvs_file_indexed_size = lf->get_index_size();
-                    iter->fvs_file_size = st.st_size;
-                    iter->fvs_text_source
-                        = std::make_unique<plain_text_source>();
-                    iter->fvs_text_source->set_text_format(
-                        lf->get_text_format());
-                    iter->fvs_text_source->register_view(this->tss_view);
-                    if (parse_res.isOk()) {
-                        auto& lf_meta = lf->get_embedded_metadata();
-
-                        iter->fvs_text_source->replace_with(parse_res.unwrap());
-
-                        if (!frontmatter.empty()) {
-                            lf_meta["net.daringfireball.markdown.frontmatter"]
-                                = {frontmatter_format, frontmatter};
+                        if (ctx.is_cancelled()) {
+                            return retval;
                         }
 
-                        lnav::events::publish(
-                            lnav_db,
-                            lnav::events::file::format_detected{
-                                lf->get_filename(),
-                                fmt::to_string(lf->get_text_format()),
-                            });
+                        md2attr_line mdal;
+
+                        mdal.with_source_path(source_path)
+                            .with_cancel_check(
+                                [&ctx]() { return ctx.is_cancelled(); });
+                        auto parse_res = md4cpp::parse(content_sf, mdal);
+                        if (parse_res.isOk()) {
+                            retval.rdr_content = parse_res.unwrap();
+                        } else if (ctx.is_cancelled()) {
+                            return retval;
+                        } else {
+                            retval.rdr_parsed = false;
+                            retval.rdr_content
+                                = lnav::console::user_message::error(
+                                      "unable to parse markdown file")
+                                      .with_reason(parse_res.unwrapErr())
+                                      .to_attr_line();
+                            retval.rdr_content.append("\n").append(
+                                attr_line_t::from_ansi_str(content.c_str()));
+                        }
+
+                        return retval;
+                    };
+
+                    if (background) {
+                        iter->fvs_pending_render
+                            = render_task::start(std::move(job));
+                        retval.rr_background_work += 1;
                     } else {
-                        auto view_content
-                            = lnav::console::user_message::error(
-                                  "unable to parse markdown file")
-                                  .with_reason(parse_res.unwrapErr())
-                                  .to_attr_line();
-                        view_content.append("\n").append(
-                            attr_line_t::from_ansi_str(
-                                read_file_res.rfr_content.c_str()));
-
-                        iter->fvs_text_source->replace_with(view_content);
+                        render_task::context ctx;
+
+                        this->apply_render(*iter, job(ctx));
                     }
                 } else {
                     log_error("unable to read markdown file: %s -- %s",
@@ -1015,33 +1232,86 @@ textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
                          lf->get_path_for_key().c_str());
                 iter->fvs_text_source = nullptr;
                 iter->fvs_error.clear();
+                iter->fvs_render_progress = std::make_shared<render_progress>();
+
+                auto job = [mtime = st.st_mtime,
+                            file_size = st.st_size,
+                            indexed_size = lf->get_index_size(),
+                            ranges = pretty_print_ranges(*lf),
+                            add_newlines = lf->has_line_metadata(),
+                            fd = auto_fd::dup_of(lf->get_fd()),
+                            progress = iter->fvs_render_progress](
+                               render_task::context& ctx) mutable {
+                    render_result retval;
+                    std::vector<attr_line_t> batch;
+                    auto flush_batch = [&batch, &progress]() {
+                        if (batch.empty()) {
+                            return;
+                        }
 
-                auto read_res = lf->read_file(logfile::read_format_t::plain);
-                if (read_res.isOk()) {
-                    auto read_file_res = read_res.unwrap();
-                    data_scanner ds(read_file_res.rfr_content);
-                    pretty_printer pp(&ds, {});
-                    attr_line_t pretty_al;
-
-                    pp.append_to(pretty_al);
-                    iter->fvs_mtime = st.st_mtime;
-                    iter->fvs_file_indexed_size = lf->get_index_size();
-                    iter->fvs_file_size = st.st_size;
-                    iter->fvs_text_source
-                        = std::make_unique<plain_text_source>();
-                    iter->fvs_text_source->set_text_format(
-                        lf->get_text_format());
-                    iter->fvs_text_source->register_view(this->tss_view);
-                    iter->fvs_text_source->replace_with(pretty_al);
+                        std::lock_guard<std::mutex> lg(progress->rp_mutex);
+                        for (auto& al : batch) {
+                            progress->rp_lines.emplace_back(std::move(al));
+                        }
+                        batch.clear();
+                    };
+                    pretty_printer pp([&batch, &flush_batch](attr_line_t&& al) {
+                        batch.emplace_back(std::move(al));
+                        if (batch.size() >= RENDER_BATCH_LINES) {
+                            flush_batch();
+                        }
+                    });
+                    line_buffer lb;
+                    size_t total_size = 0;
+                    size_t done_size = 0;
+
+                    for (const auto& fr : ranges) {
+                        total_size += fr.fr_size;
+                    }
+                    retval.rdr_mtime = mtime;
+                    retval.rdr_file_size = file_size;
+                    retval.rdr_file_indexed_size = indexed_size;
+                    retval.rdr_streamed = true;
+                    try {
+                        lb.set_fd(fd);
+                        for (const auto& fr : ranges) {
+                            if (ctx.is_cancelled()) {
+                                return retval;
+                            }
+                            auto read_res = lb.read_range(fr);
+                            if (read_res.isErr()) {
+                                retval.rdr_error = read_res.unwrapErr();
+                                return retval;
+                            }
+
+                            auto sbr = read_res.unwrap();
+                            pp.feed(sbr.to_string_fragment());
+                            if (add_newlines) {
+                                pp.feed(string_fragment::from_const("\n"));
+                            }
+                            done_size += fr.fr_size;
+                            ctx.set_progress(done_size, total_size);
+                        }
+                    } catch (const line_buffer::error& e) {
+                        retval.rdr_error = strerror(e.e_err);
+                        return retval;
+                    }
+                    pp.finish();
+                    flush_batch();
+
+                    return retval;
+                };
+
+                if (deadline && st.st_size >= BACKGROUND_WORK_SIZE) {
+                    log_info("pretty-printing in the background: %s",
+                             lf->get_path_for_key().c_str());
+                    iter->fvs_pending_render
+                        = render_task::start(std::move(job));
+                    retval.rr_background_work += 1;
                 } else {
-                    auto errmsg = read_res.unwrapErr();
-                    log_error("unable to read file to pretty-print: %s -- %s",
-                              lf->get_path_for_key().c_str(),
-                              errmsg.c_str());
-                    iter->fvs_mtime = st.st_mtime;
-                    iter->fvs_file_indexed_size = lf->get_index_size();
-                    iter->fvs_file_size = st.st_size;
-                    iter->fvs_error = errmsg;
+                    render_task::context ctx;
+
+                    this->apply_render(*iter, job(ctx));
                 }
             }
         } catch (const line_buffer::error& e) {
@@ -32,14 +32,18 @@
 
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "base/attr_line.hh"
 #include "base/file_range.hh"
+#include "base/future_util.hh"
 #include "document.sections.hh"
 #include "filter_observer.hh"
 #include "logfile.hh"
 #include "plain_text_source.hh"
+#include "text_format.hh"
 #include "text_overlay_menu.hh"
 #include "textview_curses.hh"
 
@@ -125,6 +129,17 @@ public:
     struct rescan_result_t {
         size_t rr_new_data{0};
         bool rr_scan_completed{true};
+        /**
+         * The number of files whose metadata or rendered content is still
+         * being generated in the background.
+         */
+        size_t rr_background_work{0};
+        /**
+         * The amount of the background work that is done and the total,
+         * which is zero if the progress cannot be measured.
+         */
+        size_t rr_background_done{0};
+        size_t rr_background_total{0};
     };
 
     rescan_result_t rescan_files(scan_callback& callback,
@@ -193,6 +208,51 @@ private:
         delete lfo;
     }
 
+    /**
+     * The output of the section discovery for a document, which can be
+     * performed on a worker thread.
+     */
+    struct discovery_result {
+        time_t dr_mtime{0};
+        file_ssize_t dr_file_size{0};
+        std::optional<text_format_meta_t> dr_text_meta;
+        lnav::document::metadata dr_metadata;
+    };
+
+    /**
+     * The output of rendering a Markdown document or pretty-printing a
+     * file with long lines, which can be performed on a worker thread.
+     */
+    struct render_result {
+        time_t rdr_mtime{0};
+        file_ssize_t rdr_file_size{0};
+        file_off_t rdr_file_indexed_size{0};
+        attr_line_t rdr_content;
+        /**
+         * True if the output was delivered through the render_progress
+         * instead of rdr_content.
+         */
+        bool rdr_streamed{false};
+        /** Set if the file could not be read, the output is incomplete. */
+        std::string rdr_error;
+        bool rdr_parsed{true};
+        std::string rdr_frontmatter;
+        text_format_t rdr_frontmatter_format{text_format_t::TF_UNKNOWN};
+    };
+
+    /**
+     * The lines produced so far by a streaming render, which are handed
+     * over to the view on each rescan so that the start of a large file
+     * can be read while the rest is still being formatted.
+     */
+    struct render_progress {
+        std::mutex rp_mutex;
+        std::vector<attr_line_t> rp_lines;
+    };
+
+    using discovery_task = lnav::futures::detached_task<discovery_result>;
+    using render_task = lnav::futures::detached_task<render_result>;
+
     struct file_view_state {
         explicit file_view_state(const std::shared_ptr<logfile>& f)
             : fvs_file(f)
@@ -226,8 +286,17 @@ private:
         std::string fvs_error;
         std::unique_ptr<plain_text_source> fvs_text_source;
         lnav::document::metadata fvs_metadata;
+        discovery_task fvs_pending_discovery;
+        render_task fvs_pending_render;
+        std::shared_ptr<render_progress> fvs_render_progress;
     };
 
+    void apply_discovery(file_view_state& fvs,
+                         scan_callback& callback,
+                         discovery_result dr);
+    void apply_render(file_view_state& fvs, render_result rdr);
+    size_t drain_render_progress(file_view_state& fvs);
+
     using file_iterator = std::deque<file_view_state>::iterator;
     using const_file_iterator = std::deque<file_view_state>::const_iterator;
 
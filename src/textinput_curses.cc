@@ -1677,6 +1677,7 @@ textinput_curses::do_update()
     }
     for (; y < y_max; y++) {
         ncplane_erase_region(this->tc_window, y, this->vc_x, 1, dim.dr_width);
+        damage_rows(this->tc_window, y);
     }
     if (this->tc_notice) {
         switch (this->tc_notice.value()) {
@@ -1417,6 +1417,40 @@ logfile_filter_state::reserve(size_t expected)
     this->tfs_mask.reserve(expected);
 }
 
+void
+logfile_filter_state::discard_lines(size_t count)
+{
+    count = std::min(count, this->tfs_mask.size());
+    // A set bit in the mask is a line that counted as a hit for that
+    // filter, so take those lines back out of the hit counts.
+    for (size_t lpc = 0; lpc < count; lpc++) {
+        auto mask = this->tfs_mask[lpc];
+
+        while (mask != 0) {
+            auto filter_index = __builtin_ctz(mask);
+
+            if (this->tfs_filter_hits[filter_index] > 0) {
+                this->tfs_filter_hits[filter_index] -= 1;
+            }
+            mask &= mask - 1;
+        }
+    }
+    this->tfs_mask.erase(this->tfs_mask.begin(),
+                         this->tfs_mask.begin() + count);
+    // The filter count is how far each filter has gotten through the
+    // lines, so it moves back with them.
+    for (auto& filter_count : this->tfs_filter_count) {
+        filter_count = filter_count > count ? filter_count - count : 0;
+    }
+
+    auto index_iter = std::lower_bound(
+        this->tfs_index.begin(), this->tfs_index.end(), count);
+    this->tfs_index.erase(this->tfs_index.begin(), index_iter);
+    for (auto& line : this->tfs_index) {
+        line -= count;
+    }
+}
+
 std::optional<size_t>
 logfile_filter_state::content_line_to_vis_line(uint32_t line)
 {
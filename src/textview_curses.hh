@@ -68,6 +68,12 @@ public:
 
     void reserve(size_t expected);
 
+    /**
+     * Drop the state for the given number of lines from the front, to
+     * match a call to logfile::discard_lines().
+     */
+    void discard_lines(size_t count);
+
     std::optional<size_t> content_line_to_vis_line(uint32_t line);
 
     const static int MAX_FILTERS = 32;
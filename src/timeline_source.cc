@@ -634,31 +634,9 @@ timeline_source::text_size_for_line(textview_curses& tc,
 bool
 timeline_source::rebuild_indexes()
 {
-    auto& bm = this->tss_view->get_bookmarks();
-    auto& bm_errs = bm[&textview_curses::BM_ERRORS];
-    auto& bm_warns = bm[&textview_curses::BM_WARNINGS];
-
-    bm_errs.clear();
-    bm_warns.clear();
-
-    this->gs_lower_bound = {};
-    this->gs_upper_bound = {};
-    this->gs_opid_width = 0;
-    this->gs_total_width = 0;
-    this->gs_filtered_count = 0;
-    this->gs_active_opids.clear();
-    this->gs_descriptions.clear();
-    this->gs_subid_map.clear();
-    this->gs_allocator.reset();
-    this->gs_preview_source.clear();
-    this->gs_preview_rows.clear();
-    this->gs_preview_status_source.get_description().clear();
-
-    auto min_log_time_opt = this->get_min_row_time();
-    auto max_log_time_opt = this->get_max_row_time();
-    auto max_desc_width = size_t{0};
+    std::vector<std::shared_ptr<logfile>> files;
 
-    for (const auto& [index, ld] : lnav::itertools::enumerate(this->gs_lss)) {
+    for (const auto& ld : this->gs_lss) {
         if (ld->get_file_ptr() == nullptr) {
             continue;
         }
@@ -666,80 +644,235 @@ timeline_source::rebuild_indexes()
             continue;
         }
 
-        ld->get_file_ptr()->enable_cache();
-        auto format = ld->get_file_ptr()->get_format();
-        safe::ReadAccess<logfile::safe_opid_state> r_opid_map(
-            ld->get_file_ptr()->get_opids());
-        for (const auto& pair : r_opid_map->los_opid_ranges) {
-            auto& otr = pair.second;
-            auto active_iter = this->gs_active_opids.find(pair.first);
-            if (active_iter == this->gs_active_opids.end()) {
-                auto opid = pair.first.to_owned(this->gs_allocator);
-                auto active_emp_res = this->gs_active_opids.emplace(
-                    opid,
-                    opid_row{
-                        opid,
-                        otr,
-                        string_fragment::invalid(),
-                    });
-                active_iter = active_emp_res.first;
-            } else {
-                active_iter->second.or_value |= otr;
+        files.emplace_back(ld->get_file());
+    }
+
+    auto full_rebuild = this->gs_full_rebuild_needed
+        || this->gs_time_filter_generation != this->ttt_time_filter_generation
+        || files.size() != this->gs_indexed_files.size();
+    for (size_t lpc = 0; lpc < files.size() && !full_rebuild; lpc++) {
+        const auto& indexed = this->gs_indexed_files[lpc];
+
+        if (indexed.if_file.lock() != files[lpc]
+            || indexed.if_opid_generation
+                != files[lpc]->get_opids().readAccess()->los_generation)
+        {
+            full_rebuild = true;
+        }
+    }
+
+    if (full_rebuild) {
+        if (!this->rebuild_all_rows(files)) {
+            return false;
+        }
+    } else {
+        this->update_changed_rows(files);
+    }
+
+    return true;
+}
+
+void
+timeline_source::merge_opid_range(opid_row& row,
+                                  bool first,
+                                  const log_format& format,
+                                  const opid_time_range& otr)
+{
+    if (first) {
+        row.or_value = otr;
+    } else {
+        row.or_value |= otr;
+    }
+
+    for (auto& sub : row.or_value.otr_sub_ops) {
+        auto subid_iter = this->gs_subid_map.find(sub.ostr_subid);
+
+        if (subid_iter == this->gs_subid_map.end()) {
+            subid_iter = this->gs_subid_map
+                             .emplace(sub.ostr_subid.to_owned(this->gs_allocator),
+                                      true)
+                             .first;
+        }
+        sub.ostr_subid = subid_iter->first;
+        if (sub.ostr_subid.length() > row.or_max_subid_width) {
+            row.or_max_subid_width = sub.ostr_subid.length();
+        }
+    }
+
+    if (otr.otr_description.lod_id) {
+        auto desc_id = otr.otr_description.lod_id.value();
+        auto desc_def_iter = format.lf_opid_description_def->find(desc_id);
+
+        if (desc_def_iter == format.lf_opid_description_def->end()) {
+            log_error("cannot find description: %s", row.or_name.data());
+        } else {
+            auto desc_key = opid_description_def_key{format.get_name(), desc_id};
+            auto desc_defs_iter
+                = row.or_description_defs.odd_defs.find(desc_key);
+            if (desc_defs_iter == row.or_description_defs.odd_defs.end()) {
+                row.or_description_defs.odd_defs.insert(desc_key,
+                                                        desc_def_iter->second);
             }
 
-            auto& row = active_iter->second;
-            for (auto& sub : active_iter->second.or_value.otr_sub_ops) {
-                auto subid_iter = this->gs_subid_map.find(sub.ostr_subid);
-
-                if (subid_iter == this->gs_subid_map.end()) {
-                    subid_iter = this->gs_subid_map
-                                     .emplace(sub.ostr_subid.to_owned(
-                                                  this->gs_allocator),
-                                              true)
-                                     .first;
-                }
-                sub.ostr_subid = subid_iter->first;
-                if (sub.ostr_subid.length()
-                    > active_iter->second.or_max_subid_width)
-                {
-                    active_iter->second.or_max_subid_width
-                        = sub.ostr_subid.length();
-                }
+            auto& all_descs = row.or_descriptions;
+            auto& curr_desc_m = all_descs[desc_key];
+            const auto& new_desc_v = otr.otr_description.lod_elements;
+
+            for (const auto& desc_pair : new_desc_v) {
+                curr_desc_m[desc_pair.first] = desc_pair.second;
             }
+        }
+    } else {
+        ensure(otr.otr_description.lod_elements.empty());
+    }
+    row.or_value.otr_description.lod_elements.clear();
+}
 
-            if (otr.otr_description.lod_id) {
-                auto desc_id = otr.otr_description.lod_id.value();
-                auto desc_def_iter
-                    = format->lf_opid_description_def->find(desc_id);
+bool
+timeline_source::finish_row(opid_row& row)
+{
+    std::string full_desc;
+    const auto& desc_defs = row.or_description_defs.odd_defs;
+    for (auto& desc : row.or_descriptions) {
+        auto desc_def_iter = desc_defs.find(desc.first);
+        if (desc_def_iter == desc_defs.end()) {
+            continue;
+        }
+        const auto& desc_def = desc_def_iter->second;
+        full_desc = desc_def.to_string(desc.second);
+    }
+    row.or_descriptions.clear();
+    auto full_desc_sf = string_fragment::from_str(full_desc);
+    auto desc_sf_iter = this->gs_descriptions.find(full_desc_sf);
+    if (desc_sf_iter == this->gs_descriptions.end()) {
+        desc_sf_iter
+            = this->gs_descriptions
+                  .emplace(full_desc_sf.to_owned(this->gs_allocator))
+                  .first;
+    }
+    row.or_description = *desc_sf_iter;
+    row.or_filtered = false;
+    row.or_name_filter_hits = 0;
+    row.or_desc_filter_hits = 0;
 
-                if (desc_def_iter == format->lf_opid_description_def->end()) {
-                    log_error("cannot find description: %s",
-                              active_iter->first.data());
-                } else {
-                    auto desc_key
-                        = opid_description_def_key{format->get_name(), desc_id};
-                    auto desc_defs_iter
-                        = row.or_description_defs.odd_defs.find(desc_key);
-                    if (desc_defs_iter
-                        == row.or_description_defs.odd_defs.end())
-                    {
-                        row.or_description_defs.odd_defs.insert(
-                            desc_key, desc_def_iter->second);
-                    }
+    if (!this->tss_apply_filters) {
+        return true;
+    }
 
-                    auto& all_descs = active_iter->second.or_descriptions;
-                    auto& curr_desc_m = all_descs[desc_key];
-                    const auto& new_desc_v = otr.otr_description.lod_elements;
+    shared_buffer sb_opid;
+    shared_buffer_ref sbr_opid;
+    sbr_opid.share(sb_opid, row.or_name.data(), row.or_name.length());
+    shared_buffer sb_desc;
+    shared_buffer_ref sbr_desc;
+    sbr_desc.share(sb_desc, full_desc.c_str(), full_desc.length());
 
-                    for (const auto& desc_pair : new_desc_v) {
-                        curr_desc_m[desc_pair.first] = desc_pair.second;
-                    }
+    auto filtered_in_count = size_t{0};
+    auto filtered_in = false;
+    auto filtered_out = false;
+    for (const auto& filt : this->tss_filters) {
+        if (!filt->is_enabled()) {
+            continue;
+        }
+        if (filt->get_type() == text_filter::INCLUDE) {
+            filtered_in_count += 1;
+        }
+        for (auto* hits : {&row.or_name_filter_hits, &row.or_desc_filter_hits})
+        {
+            const auto& sbr
+                = hits == &row.or_name_filter_hits ? sbr_opid : sbr_desc;
+
+            if (filt->matches(std::nullopt, sbr)) {
+                *hits |= 1U << filt->get_index();
+                switch (filt->get_type()) {
+                    case text_filter::INCLUDE:
+                        filtered_in = true;
+                        break;
+                    case text_filter::EXCLUDE:
+                        filtered_out = true;
+                        break;
+                    default:
+                        break;
                 }
-            } else {
-                ensure(otr.otr_description.lod_elements.empty());
             }
-            active_iter->second.or_value.otr_description.lod_elements.clear();
         }
+    }
+    this->update_filter_hits(row, 1);
+
+    const auto& otr = row.or_value;
+    auto min_log_time_opt = this->get_min_row_time();
+    auto max_log_time_opt = this->get_max_row_time();
+    if (min_log_time_opt && otr.otr_range.tr_end < min_log_time_opt.value()) {
+        filtered_out = true;
+    }
+    if (max_log_time_opt && max_log_time_opt.value() < otr.otr_range.tr_begin)
+    {
+        filtered_out = true;
+    }
+
+    if ((filtered_in_count > 0 && !filtered_in) || filtered_out) {
+        row.or_filtered = true;
+        this->gs_filtered_count += 1;
+        return false;
+    }
+
+    return true;
+}
+
+void
+timeline_source::update_filter_hits(const opid_row& row, int32_t amount)
+{
+    for (size_t lpc = 0; lpc < this->gs_filter_hits.size(); lpc++) {
+        for (auto hits : {row.or_name_filter_hits, row.or_desc_filter_hits}) {
+            if (hits & (1U << lpc)) {
+                this->gs_filter_hits[lpc] += amount;
+            }
+        }
+    }
+}
+
+bool
+timeline_source::rebuild_all_rows(
+    const std::vector<std::shared_ptr<logfile>>& files)
+{
+    this->gs_filtered_count = 0;
+    this->gs_time_order.clear();
+    this->gs_active_opids.clear();
+    this->gs_descriptions.clear();
+    this->gs_subid_map.clear();
+    this->gs_allocator.reset();
+    this->gs_preview_source.clear();
+    this->gs_preview_rows.clear();
+    this->gs_preview_status_source.get_description().clear();
+    this->gs_indexed_files.clear();
+    this->gs_full_rebuild_needed = true;
+    this->gs_time_filter_generation = this->ttt_time_filter_generation;
+
+    for (const auto& [index, lf] : lnav::itertools::enumerate(files)) {
+        lf->enable_cache();
+        auto format = lf->get_format();
+        safe::WriteAccess<logfile::safe_opid_state> w_opid_map(
+            lf->get_opids());
+        for (const auto& pair : w_opid_map->los_opid_ranges) {
+            auto active_iter = this->gs_active_opids.find(pair.first);
+            auto first = active_iter == this->gs_active_opids.end();
+            if (first) {
+                auto opid = pair.first.to_owned(this->gs_allocator);
+                active_iter = this->gs_active_opids
+                                  .emplace(opid,
+                                           opid_row{
+                                               opid,
+                                               {},
+                                               string_fragment::invalid(),
+                                           })
+                                  .first;
+            }
+
+            this->merge_opid_range(
+                active_iter->second, first, *format, pair.second);
+        }
+        w_opid_map->los_changed_opids.clear();
+        this->gs_indexed_files.emplace_back(
+            indexed_file{lf, w_opid_map->los_generation});
 
         if (this->gs_index_progress) {
             switch (this->gs_index_progress(
@@ -756,126 +889,221 @@ timeline_source::rebuild_indexes()
         this->gs_index_progress(std::nullopt);
     }
 
-    size_t filtered_in_count = 0;
-    for (const auto& filt : this->tss_filters) {
-        if (!filt->is_enabled()) {
-            continue;
-        }
-        if (filt->get_type() == text_filter::INCLUDE) {
-            filtered_in_count += 1;
-        }
-    }
     this->gs_filter_hits = {};
-    this->gs_time_order.clear();
     this->gs_time_order.reserve(this->gs_active_opids.size());
     for (auto& pair : this->gs_active_opids) {
-        auto& otr = pair.second.or_value;
-        std::string full_desc;
-        const auto& desc_defs = pair.second.or_description_defs.odd_defs;
-        for (auto& desc : pair.second.or_descriptions) {
-            auto desc_def_iter = desc_defs.find(desc.first);
-            if (desc_def_iter == desc_defs.end()) {
-                continue;
-            }
-            const auto& desc_def = desc_def_iter->second;
-            full_desc = desc_def.to_string(desc.second);
-        }
-        pair.second.or_descriptions.clear();
-        auto full_desc_sf = string_fragment::from_str(full_desc);
-        auto desc_sf_iter = this->gs_descriptions.find(full_desc_sf);
-        if (desc_sf_iter == this->gs_descriptions.end()) {
-            full_desc_sf = string_fragment::from_str(full_desc).to_owned(
-                this->gs_allocator);
+        if (this->finish_row(pair.second)) {
+            this->gs_time_order.emplace_back(pair.second);
         }
-        pair.second.or_description = full_desc_sf;
-
-        shared_buffer sb_opid;
-        shared_buffer_ref sbr_opid;
-        sbr_opid.share(
-            sb_opid, pair.second.or_name.data(), pair.second.or_name.length());
-        shared_buffer sb_desc;
-        shared_buffer_ref sbr_desc;
-        sbr_desc.share(sb_desc, full_desc.c_str(), full_desc.length());
-        if (this->tss_apply_filters) {
-            auto filtered_in = false;
-            auto filtered_out = false;
-            for (const auto& filt : this->tss_filters) {
-                if (!filt->is_enabled()) {
-                    continue;
-                }
-                for (const auto sbr : {&sbr_opid, &sbr_desc}) {
-                    if (filt->matches(std::nullopt, *sbr)) {
-                        this->gs_filter_hits[filt->get_index()] += 1;
-                        switch (filt->get_type()) {
-                            case text_filter::INCLUDE:
-                                filtered_in = true;
-                                break;
-                            case text_filter::EXCLUDE:
-                                filtered_out = true;
-                                break;
-                            default:
-                                break;
-                        }
-                    }
-                }
-            }
+    }
+    std::stable_sort(this->gs_time_order.begin(),
+                     this->gs_time_order.end(),
+                     std::less<const opid_row>{});
+    this->gs_full_rebuild_needed = false;
+    this->index_time_order();
 
-            if (min_log_time_opt
-                && otr.otr_range.tr_end < min_log_time_opt.value())
-            {
-                filtered_out = true;
-            }
-            if (max_log_time_opt
-                && max_log_time_opt.value() < otr.otr_range.tr_begin)
-            {
-                filtered_out = true;
+    return true;
+}
+
+void
+timeline_source::update_changed_rows(
+    const std::vector<std::shared_ptr<logfile>>& files)
+{
+    std::vector<std::reference_wrapper<opid_row>> changed_rows;
+
+    for (const auto& lf : files) {
+        safe::WriteAccess<logfile::safe_opid_state> w_opid_map(
+            lf->get_opids());
+
+        for (const auto& opid : w_opid_map->los_changed_opids) {
+            auto active_iter = this->gs_active_opids.find(opid);
+            if (active_iter == this->gs_active_opids.end()) {
+                auto opid_copy = opid.to_owned(this->gs_allocator);
+                active_iter = this->gs_active_opids
+                                  .emplace(opid_copy,
+                                           opid_row{
+                                               opid_copy,
+                                               {},
+                                               string_fragment::invalid(),
+                                           })
+                                  .first;
             }
 
-            if ((filtered_in_count > 0 && !filtered_in) || filtered_out) {
-                this->gs_filtered_count += 1;
+            auto& row = active_iter->second;
+            if (row.or_dirty) {
                 continue;
             }
+            row.or_dirty = true;
+            changed_rows.emplace_back(row);
+        }
+        w_opid_map->los_changed_opids.clear();
+    }
+
+    if (changed_rows.empty()) {
+        return;
+    }
+
+    log_debug("timeline: updating %zu of %zu operations",
+              changed_rows.size(),
+              this->gs_active_opids.size());
+
+    // Find where the first changed row is in the time order, using its
+    // range from before the update.  The rows before that are not touched
+    // by this update.  New and filtered rows are not in the order.
+    auto less_row = std::less<const opid_row>{};
+    auto first_changed = this->gs_time_order.size();
+    for (const auto& row_ref : changed_rows) {
+        auto lb = std::lower_bound(this->gs_time_order.begin(),
+                                   this->gs_time_order.end(),
+                                   row_ref,
+                                   less_row);
+        if (lb == this->gs_time_order.end()
+            || &lb->get() != &row_ref.get())
+        {
+            continue;
         }
+        first_changed = std::min(
+            first_changed,
+            (size_t) std::distance(this->gs_time_order.begin(), lb));
+    }
+
+    // Pull the changed rows out of the time order before their ranges are
+    // updated, the remaining rows are still sorted.
+    auto remove_iter = std::remove_if(
+        std::next(this->gs_time_order.begin(), first_changed),
+        this->gs_time_order.end(),
+        [](const auto& row_ref) { return row_ref.get().or_dirty; });
+    this->gs_time_order.erase(remove_iter, this->gs_time_order.end());
 
-        if (pair.second.or_name.length() > this->gs_opid_width) {
-            this->gs_opid_width = pair.second.or_name.length();
+    for (auto& row_ref : changed_rows) {
+        auto& row = row_ref.get();
+
+        this->update_filter_hits(row, -1);
+        if (row.or_filtered) {
+            this->gs_filtered_count -= 1;
         }
-        if (full_desc.size() > max_desc_width) {
-            max_desc_width = full_desc.size();
+        row.or_value.clear();
+        row.or_description_defs.odd_defs.clear();
+        row.or_descriptions.clear();
+        row.or_max_subid_width = 0;
+    }
+
+    for (const auto& lf : files) {
+        auto format = lf->get_format();
+        safe::ReadAccess<logfile::safe_opid_state> r_opid_map(
+            lf->get_opids());
+
+        if (r_opid_map->los_opid_ranges.empty()) {
+            continue;
         }
+        for (auto& row_ref : changed_rows) {
+            auto& row = row_ref.get();
+            auto otr_iter = r_opid_map->los_opid_ranges.find(row.or_name);
 
-        if (this->gs_lower_bound.tv_sec == 0
-            || pair.second.or_value.otr_range.tr_begin < this->gs_lower_bound)
-        {
-            this->gs_lower_bound = pair.second.or_value.otr_range.tr_begin;
+            if (otr_iter == r_opid_map->los_opid_ranges.end()) {
+                continue;
+            }
+            this->merge_opid_range(
+                row, row.or_dirty, *format, otr_iter->second);
+            row.or_dirty = false;
         }
-        if (this->gs_upper_bound.tv_sec == 0
-            || this->gs_upper_bound < pair.second.or_value.otr_range.tr_end)
-        {
-            this->gs_upper_bound = pair.second.or_value.otr_range.tr_end;
+    }
+
+    auto middle = this->gs_time_order.size();
+    for (auto& row_ref : changed_rows) {
+        auto& row = row_ref.get();
+
+        row.or_dirty = false;
+        if (this->finish_row(row)) {
+            this->gs_time_order.emplace_back(row);
         }
-        this->gs_time_order.emplace_back(pair.second);
     }
-    std::stable_sort(this->gs_time_order.begin(),
-                     this->gs_time_order.end(),
-                     std::less<const opid_row>{});
-    for (size_t lpc = 0; lpc < this->gs_time_order.size(); lpc++) {
+    auto middle_iter = std::next(this->gs_time_order.begin(), middle);
+    std::stable_sort(middle_iter, this->gs_time_order.end(), less_row);
+
+    // Only the part of the order starting at the first changed row, or
+    // where the earliest updated row now goes, needs to be merged and
+    // indexed again.
+    auto merge_start = first_changed;
+    if (middle_iter != this->gs_time_order.end()) {
+        auto lb = std::lower_bound(this->gs_time_order.begin(),
+                                   middle_iter,
+                                   *middle_iter,
+                                   less_row);
+        merge_start = std::min(
+            merge_start,
+            (size_t) std::distance(this->gs_time_order.begin(), lb));
+    }
+    merge_start = std::min(merge_start, middle);
+    std::inplace_merge(std::next(this->gs_time_order.begin(), merge_start),
+                       std::next(this->gs_time_order.begin(), middle),
+                       this->gs_time_order.end(),
+                       less_row);
+    this->index_time_order(merge_start);
+}
+
+/**
+ * Update the bookmarks, widths, and time bounds for the rows in the time
+ * order starting at the given index.  The bookmarks for the earlier rows
+ * are kept.  When starting past zero, the widths and the upper bound
+ * only grow until the next full rebuild.
+ */
+void
+timeline_source::index_time_order(size_t start)
+{
+    auto& bm = this->tss_view->get_bookmarks();
+    auto& bm_errs = bm[&textview_curses::BM_ERRORS];
+    auto& bm_warns = bm[&textview_curses::BM_WARNINGS];
+
+    if (start == 0) {
+        bm_errs.clear();
+        bm_warns.clear();
+        this->gs_upper_bound = {};
+        this->gs_opid_width = 0;
+        this->gs_max_desc_width = 0;
+    } else {
+        auto start_vl = vis_line_t(start);
+
+        bm_errs.erase(
+            std::lower_bound(bm_errs.begin(), bm_errs.end(), start_vl),
+            bm_errs.end());
+        bm_warns.erase(
+            std::lower_bound(bm_warns.begin(), bm_warns.end(), start_vl),
+            bm_warns.end());
+    }
+    // The order is sorted by the start time, so the first row has the
+    // lower bound.
+    this->gs_lower_bound = this->gs_time_order.empty()
+        ? timeval{}
+        : this->gs_time_order.front().get().or_value.otr_range.tr_begin;
+    for (size_t lpc = start; lpc < this->gs_time_order.size(); lpc++) {
         const auto& row = this->gs_time_order[lpc].get();
         if (row.or_value.otr_level_stats.lls_error_count > 0) {
             bm_errs.insert_once(vis_line_t(lpc));
         } else if (row.or_value.otr_level_stats.lls_warning_count > 0) {
             bm_warns.insert_once(vis_line_t(lpc));
         }
+
+        if (row.or_name.length() > this->gs_opid_width) {
+            this->gs_opid_width = row.or_name.length();
+        }
+        if ((size_t) row.or_description.length() > this->gs_max_desc_width) {
+            this->gs_max_desc_width = row.or_description.length();
+        }
+
+        if (this->gs_upper_bound.tv_sec == 0
+            || this->gs_upper_bound < row.or_value.otr_range.tr_end)
+        {
+            this->gs_upper_bound = row.or_value.otr_range.tr_end;
+        }
     }
 
     this->gs_opid_width = std::min(this->gs_opid_width, MAX_OPID_WIDTH);
     this->gs_total_width
-        = std::max<size_t>(22 + this->gs_opid_width + max_desc_width,
+        = std::max<size_t>(22 + this->gs_opid_width + this->gs_max_desc_width,
                            1 + 16 + 5 + 8 + 5 + 16 + 1 /* header */);
 
     this->tss_view->set_needs_update();
-
-    return true;
 }
 
 std::optional<vis_line_t>
@@ -1058,6 +1286,7 @@ timeline_source::text_selection_changed(textview_curses& tc)
 void
 timeline_source::text_filters_changed()
 {
+    this->gs_full_rebuild_needed = true;
     this->rebuild_indexes();
     this->tss_view->reload_data();
     this->tss_view->redo_search();
@@ -96,6 +96,15 @@ public:
     std::optional<vis_line_t> row_for_time(struct timeval time_bucket) override;
     std::optional<row_info> time_for_row(vis_line_t row) override;
 
+    /**
+     * Update the rows with the changes to the operations in the log files.
+     * The operation maps are only walked in full when the set of files or
+     * the filters have changed, otherwise the rows for the operations that
+     * the files report as changed are recomputed and merged back into the
+     * time order.
+     *
+     * @return false if the rebuild was interrupted.
+     */
     bool rebuild_indexes();
 
     std::pair<timeval, timeval> get_time_bounds_for(int line);
@@ -147,6 +156,10 @@ public:
                          lnav::map::small<size_t, std::string>>
             or_descriptions;
         size_t or_max_subid_width{0};
+        bool or_filtered{false};
+        bool or_dirty{false};
+        uint32_t or_name_filter_hits{0};
+        uint32_t or_desc_filter_hits{0};
 
         bool operator<(const opid_row& rhs) const
         {
@@ -164,23 +177,46 @@ public:
         }
     };
 
+    // The rows are referenced from gs_time_order, so they need to stay put
+    // when new opids are added.
     using timeline_opid_row_map
-        = robin_hood::unordered_map<string_fragment,
-                                    opid_row,
-                                    frag_hasher,
-                                    std::equal_to<string_fragment>>;
+        = robin_hood::unordered_node_map<string_fragment,
+                                         opid_row,
+                                         frag_hasher,
+                                         std::equal_to<string_fragment>>;
     using timeline_desc_map
         = robin_hood::unordered_set<string_fragment,
                                     frag_hasher,
                                     std::equal_to<string_fragment>>;
 
+    bool rebuild_all_rows(const std::vector<std::shared_ptr<logfile>>& files);
+    void update_changed_rows(
+        const std::vector<std::shared_ptr<logfile>>& files);
+    void merge_opid_range(opid_row& row,
+                          bool first,
+                          const log_format& format,
+                          const opid_time_range& otr);
+    bool finish_row(opid_row& row);
+    void update_filter_hits(const opid_row& row, int32_t amount);
+    void index_time_order(size_t start = 0);
+
     timeline_preview_overlay gs_preview_overlay;
     attr_line_t gs_rendered_line;
     size_t gs_opid_width{0};
+    size_t gs_max_desc_width{0};
     size_t gs_total_width{0};
     timeline_opid_row_map gs_active_opids;
     timeline_desc_map gs_descriptions;
     std::vector<std::reference_wrapper<opid_row>> gs_time_order;
+
+    struct indexed_file {
+        std::weak_ptr<logfile> if_file;
+        uint32_t if_opid_generation{0};
+    };
+
+    std::vector<indexed_file> gs_indexed_files;
+    uint32_t gs_time_filter_generation{0};
+    bool gs_full_rebuild_needed{true};
     timeval gs_lower_bound{};
     timeval gs_upper_bound{};
     size_t gs_filtered_count{0};
@@ -47,6 +47,7 @@
 #include "base/itertools.enumerate.hh"
 #include "base/itertools.hh"
 #include "base/lnav_log.hh"
+#include "base/string_util.hh"
 #include "config.h"
 #include "lnav_config.hh"
 #include "shlex.hh"
@@ -228,6 +229,62 @@ view_curses::awaiting_user_input()
     }
 }
 
+namespace {
+
+struct row_stamps {
+    uint64_t rs_next_stamp{1};
+    std::unordered_map<ncplane*, std::vector<uint64_t>> rs_planes;
+};
+
+row_stamps&
+get_row_stamps()
+{
+    static row_stamps retval;
+
+    return retval;
+}
+
+}  // namespace
+
+void
+view_curses::damage_rows(ncplane* window, int y, int height)
+{
+    auto& stamps = get_row_stamps();
+
+    if (y < 0 || height <= 0) {
+        return;
+    }
+
+    auto& rows = stamps.rs_planes[window];
+    if (rows.size() < (size_t) (y + height)) {
+        rows.resize(y + height);
+    }
+    for (auto lpc = y; lpc < y + height; lpc++) {
+        rows[lpc] = stamps.rs_next_stamp++;
+    }
+}
+
+void
+view_curses::damage_all()
+{
+    get_row_stamps().rs_planes.clear();
+}
+
+uint64_t
+view_curses::row_stamp(ncplane* window, int y)
+{
+    const auto& stamps = get_row_stamps();
+    auto iter = stamps.rs_planes.find(window);
+
+    if (iter == stamps.rs_planes.end() || y < 0
+        || (size_t) y >= iter->second.size())
+    {
+        return 0;
+    }
+
+    return iter->second[y];
+}
+
 view_curses::mvwattrline_result
 view_curses::mvwattrline(ncplane* window,
                          int y,
@@ -238,13 +295,19 @@ view_curses::mvwattrline(ncplane* window,
 {
     auto& sa = al.get_attrs();
     const auto& line = al.get_string();
-    std::vector<utf_to_display_adjustment> utf_adjustments;
+    // Scratch buffers are kept across calls since this is invoked for
+    // every visible line on every redraw.
+    thread_local std::vector<utf_to_display_adjustment> utf_adjustments;
+    thread_local std::string expanded_line;
 
     require(lr_chars.lr_end >= 0);
 
+    damage_rows(window, y);
+    utf_adjustments.clear();
+    expanded_line.clear();
+
     mvwattrline_result retval;
     auto line_width_chars = lr_chars.length();
-    std::string expanded_line;
     line_range lr_bytes;
     int char_index = 0;
 
@@ -260,6 +323,39 @@ view_curses::mvwattrline(ncplane* window,
     }
 
     for (size_t lpc = 0; lpc < line.size();) {
+        auto ascii_len = printable_ascii_prefix(
+            string_fragment::from_byte_range(line.data(), lpc, line.size()));
+
+        if (ascii_len > 0) {
+            // Printable ASCII is one byte per column, so the run can be
+            // copied as-is and the viewport boundaries that fall inside of
+            // it computed directly.  The result is the same as handling
+            // each character in the switch below.
+            int run_start = expanded_line.size();
+            int run_end_char = char_index + ascii_len;
+
+            if (char_index <= lr_chars.lr_start
+                && lr_chars.lr_start < run_end_char)
+            {
+                lr_bytes.lr_start
+                    = run_start + (lr_chars.lr_start - char_index);
+            }
+            if (lr_chars.lr_end < run_end_char
+                && (lr_bytes.lr_end == -1
+                    || (char_index <= lr_chars.lr_end
+                        && lr_chars.lr_end != lr_chars.lr_start)))
+            {
+                auto end_char = std::max(lr_chars.lr_end, char_index);
+
+                lr_bytes.lr_end = run_start + (end_char - char_index);
+                retval.mr_chars_out = end_char;
+            }
+            expanded_line.append(&line[lpc], ascii_len);
+            char_index = run_end_char;
+            lpc += ascii_len;
+            continue;
+        }
+
         int exp_start_index = expanded_line.size();
         auto ch = static_cast<unsigned char>(line[lpc]);
 
@@ -390,7 +486,9 @@ view_curses::mvwattrline(ncplane* window,
 
     text_attrs resolved_line_attrs[line_width_chars + 1];
 
-    std::stable_sort(sa.begin(), sa.end());
+    if (!std::is_sorted(sa.begin(), sa.end())) {
+        std::stable_sort(sa.begin(), sa.end());
+    }
     for (auto iter = sa.cbegin(); iter != sa.cend(); ++iter) {
         auto attr_range = iter->sa_range;
 
@@ -874,6 +972,10 @@ view_colors::init_roles(const lnav_theme& lt,
     const auto& default_theme = lnav_config.lc_ui_theme_defs["default"];
     std::string err;
 
+    // The colors for roles are about to change, so anything that is already
+    // on the screen needs to be redrawn.
+    view_curses::damage_all();
+
     size_t icon_index = 0;
     for (const auto& ic : {
              lt.lt_icon_hidden,
@@ -442,6 +442,26 @@ public:
                                           const struct line_range& lr,
                                           role_t base_role = role_t::VCR_TEXT);
 
+    /**
+     * Record that a row of the given plane has been drawn over.  Every call
+     * to mvwattrline() does this for the row it writes.  Code that writes
+     * to a plane through other means should call this so that views that
+     * skip redrawing unchanged rows know the row needs to be redrawn.
+     */
+    static void damage_rows(ncplane* window, int y, int height = 1);
+
+    /**
+     * Forget the state of every row, so that all views redraw everything on
+     * their next update.  Used when the theme or screen size changes.
+     */
+    static void damage_all();
+
+    /**
+     * @return A value that changes every time the given row is damaged, or
+     *   zero if nothing is known about the row.
+     */
+    static uint64_t row_stamp(ncplane* window, int y);
+
     bool vc_enabled{true};
 
 protected:
@@ -655,6 +655,7 @@ handle_winch(screen_curses* sc)
     }
 
     lnav_data.ld_winched = false;
+    view_curses::damage_all();
     for (auto& stat : lnav_data.ld_status) {
         stat.window_change();
     }
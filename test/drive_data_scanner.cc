@@ -31,6 +31,7 @@
 #    include <alloca.h>
 #endif
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 
@@ -61,6 +62,7 @@ main(int argc, char* argv[])
     int c, retval = EXIT_SUCCESS;
     bool prompt = false, is_log = false, pretty_print = false;
     bool scanner_details = false;
+    int bench_count = 0;
 
     {
         static auto builtin_formats
@@ -80,7 +82,7 @@ main(int argc, char* argv[])
         load_formats(paths, errors);
     }
 
-    while ((c = getopt(argc, argv, "pPls")) != -1) {
+    while ((c = getopt(argc, argv, "pPlsb:")) != -1) {
         switch (c) {
             case 'p':
                 prompt = true;
@@ -98,6 +100,10 @@ main(int argc, char* argv[])
                 scanner_details = true;
                 break;
 
+            case 'b':
+                bench_count = atoi(optarg);
+                break;
+
             default:
                 retval = EXIT_FAILURE;
                 break;
@@ -258,6 +264,29 @@ main(int argc, char* argv[])
                     out, "msg         :%s\n", sub_line.c_str() + body.lr_start);
                 fprintf(out, "format      :%s\n", msg_format.c_str());
 
+                if (bench_count > 0) {
+                    auto* trace_file = data_parser::TRACE_FILE;
+
+                    data_parser::TRACE_FILE = nullptr;
+                    auto start = std::chrono::steady_clock::now();
+                    for (int count = 0; count < bench_count; count++) {
+                        data_scanner bench_ds(sub_line, body.lr_start);
+                        data_parser bench_dp(&bench_ds);
+
+                        bench_dp.parse();
+                    }
+                    auto elapsed = std::chrono::steady_clock::now() - start;
+                    data_parser::TRACE_FILE = trace_file;
+
+                    fprintf(stderr,
+                            "%s: %d parses in %lldus\n",
+                            argv[lpc],
+                            bench_count,
+                            (long long) std::chrono::duration_cast<
+                                std::chrono::microseconds>(elapsed)
+                                .count());
+                }
+
                 if (pretty_print) {
                     data_scanner ds2(sub_line, body.lr_start);
                     pretty_printer pp(&ds2, sa);
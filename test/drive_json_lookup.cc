@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file drive_json_lookup.cc
+ *
+ * Times jget() with one and with several lookups per document and checks
+ * the results against SQLite's json_extract().
+ */
+
+#include <chrono>
+#include <string>
+
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "base/auto_mem.hh"
+#include "sqlite-extension-func.hh"
+
+static const char* CREATE_DOCS = R"(
+CREATE TABLE docs (doc TEXT);
+WITH RECURSIVE seq(n) AS (
+    SELECT 0 UNION ALL SELECT n + 1 FROM seq WHERE n < %d - 1
+)
+INSERT INTO docs SELECT json_object(
+    'id', n,
+    'name', 'user' || n,
+    'tags', json_array('alpha', 'beta', 'gamma'),
+    'req', json_object(
+        'method', 'GET',
+        'path', '/api/v1/items/' || n,
+        'status', 200 + n %% 5),
+    'msg', printf('%%.*c', 200, 'x')) FROM seq;
+)";
+
+struct bench_case {
+    const char* bc_name;
+    int bc_lookups;
+    const char* bc_query;
+    const char* bc_expected_query;
+};
+
+static const bench_case CASES[] = {
+    {
+        "single",
+        1,
+        "SELECT sum(jget(doc, '/req/status')) FROM docs",
+        "SELECT sum(json_extract(doc, '$.req.status')) FROM docs",
+    },
+    {
+        "multi",
+        4,
+        "SELECT sum(jget(doc, '/req/status') + jget(doc, '/id') "
+        "+ length(jget(doc, '/name')) + length(jget(doc, '/req/path'))) "
+        "FROM docs",
+        "SELECT sum(json_extract(doc, '$.req.status') "
+        "+ json_extract(doc, '$.id') + length(json_extract(doc, '$.name')) "
+        "+ length(json_extract(doc, '$.req.path'))) FROM docs",
+    },
+};
+
+static bool
+query_int(sqlite3* db, const char* query, int64_t& value_out)
+{
+    auto_mem<sqlite3_stmt> stmt(sqlite3_finalize);
+
+    if (sqlite3_prepare_v2(db, query, -1, stmt.out(), nullptr) != SQLITE_OK
+        || sqlite3_step(stmt.in()) != SQLITE_ROW)
+    {
+        fprintf(stderr,
+                "error: query failed -- %s\n  %s\n",
+                sqlite3_errmsg(db),
+                query);
+        return false;
+    }
+
+    value_out = sqlite3_column_int64(stmt.in(), 0);
+    return true;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int retval = EXIT_SUCCESS;
+    int row_count = argc > 1 ? atoi(argv[1]) : 10000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 1;
+    auto_mem<sqlite3> db(sqlite3_close);
+    auto_mem<char> errmsg(sqlite3_free);
+
+    if (sqlite3_open(":memory:", db.out()) != SQLITE_OK) {
+        fprintf(stderr, "error: unable to make sqlite memory database\n");
+        return EXIT_FAILURE;
+    }
+
+    sqlite_registration_func_t funcs[] = {
+        json_extension_functions,
+        nullptr,
+    };
+    register_sqlite_funcs(db.in(), funcs);
+
+    auto_mem<char> create_sql(sqlite3_free);
+    create_sql = sqlite3_mprintf(CREATE_DOCS, row_count);
+    if (sqlite3_exec(db.in(), create_sql.in(), nullptr, nullptr, errmsg.out())
+        != SQLITE_OK)
+    {
+        fprintf(stderr, "error: unable to create docs -- %s\n", errmsg.in());
+        return EXIT_FAILURE;
+    }
+
+    for (const auto& bc : CASES) {
+        int64_t expected = 0;
+        int64_t actual = 0;
+
+        if (!query_int(db.in(), bc.bc_expected_query, expected)) {
+            return EXIT_FAILURE;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int lpc = 0; lpc < rounds; lpc++) {
+            if (!query_int(db.in(), bc.bc_query, actual)) {
+                return EXIT_FAILURE;
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto calls = (double) row_count * bc.bc_lookups * rounds;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                      .count();
+
+        printf("%-8s %d lookup(s)/doc  %8.1f ns/call\n",
+               bc.bc_name,
+               bc.bc_lookups,
+               calls > 0 ? ns / calls : 0.0);
+        if (actual != expected) {
+            fprintf(stderr,
+                    "error: %s returned %lld, expected %lld\n",
+                    bc.bc_name,
+                    (long long) actual,
+                    (long long) expected);
+            retval = EXIT_FAILURE;
+        }
+    }
+
+    return retval;
+}
@@ -57,9 +57,10 @@ main(int argc, char* argv[])
     int offseti = 0;
     off_t offset = 0;
     int count = 1000;
+    int seek_every = 0;
     struct stat st;
 
-    while ((c = getopt(argc, argv, "o:i:n:c:")) != -1) {
+    while ((c = getopt(argc, argv, "o:i:n:c:s:")) != -1) {
         switch (c) {
             case 'o':
                 if (sscanf(optarg, "%d", &offseti) != 1) {
@@ -87,6 +88,14 @@ main(int argc, char* argv[])
                     retval = EXIT_FAILURE;
                 }
                 break;
+            case 's':
+                if (sscanf(optarg, "%d", &seek_every) != 1) {
+                    fprintf(stderr,
+                            "error: seek interval is not an integer -- %s\n",
+                            optarg);
+                    retval = EXIT_FAILURE;
+                }
+                break;
             case 'i': {
                 FILE* file;
 
@@ -193,6 +202,8 @@ main(int argc, char* argv[])
                 retval = EXIT_FAILURE;
             } else {
                 file_range range;
+                size_t line_count = 0;
+                std::mt19937 seek_gen;
 
                 while (true) {
                     auto load_result = lb.load_next_line(range);
@@ -208,6 +219,29 @@ main(int argc, char* argv[])
                     if (range.empty()) {
                         break;
                     }
+
+                    line_count += 1;
+                    if (seek_every > 0 && line_count % seek_every == 0
+                        && line_count <= index.size())
+                    {
+                        // Jump back to a line that has already been loaded
+                        // to check seeks while the file is being indexed.
+                        std::uniform_int_distribution<size_t> dist(
+                            0, line_count - 1);
+                        const auto& index_tuple = index[dist(seek_gen)];
+
+                        auto read_result = lb.read_range(
+                            {get<1>(index_tuple), get<2>(index_tuple)});
+
+                        assert(read_result.isOk());
+
+                        auto sbr = read_result.unwrap();
+
+                        assert(memcmp(sbr.get_data(),
+                                      &maddr[get<1>(index_tuple)],
+                                      sbr.length())
+                               == 0);
+                    }
                 }
                 do {
                     size_t lpc;
@@ -32,6 +32,9 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <new>
+
 #include "base/auto_fd.hh"
 #include "base/injector.bind.hh"
 #include "config.h"
@@ -42,6 +45,37 @@ using namespace std;
 
 static listview_curses lv;
 
+static std::atomic<size_t> ALLOC_COUNT{0};
+
+void*
+operator new(size_t size)
+{
+    ALLOC_COUNT += 1;
+    auto* retval = malloc(size == 0 ? 1 : size);
+    if (retval == nullptr) {
+        throw std::bad_alloc();
+    }
+    return retval;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+/**
+ * Stands in for L_FILE, the drive does not link in the log files.
+ */
+static constexpr string_attr_type<std::shared_ptr<logfile>> TEST_FILE(
+    "test-file");
+
 static auto bound_xterm_mouse = injector::bind<xterm_mouse>::to_singleton();
 
 class my_source : public list_data_source {
@@ -55,8 +89,11 @@ public:
                                  vector<attr_line_t>& rows)
     {
         for (auto& value_out : rows) {
-            value_out = (lv.is_selectable() && row == lv.get_selection()) ? "+"
-                                                                          : "";
+            // Reuse the storage of the row buffer from the last frame.
+            value_out.clear();
+            if (lv.is_selectable() && row == lv.get_selection()) {
+                value_out.al_string = "+";
+            }
 
             if (row == 0) {
                 value_out.al_string += " Hello";
@@ -75,6 +112,13 @@ public:
                     string_attr(line_range{1, 3}, VC_STYLE.value(mixed_style)));
             } else if (row < this->ms_rows) {
                 value_out.al_string += std::to_string(static_cast<int>(row));
+                if (row == this->ms_changed_row) {
+                    value_out.al_string += " changed";
+                }
+                if (this->ms_file) {
+                    value_out.with_attr(string_attr(
+                        line_range{0, -1}, TEST_FILE.value(this->ms_file)));
+                }
             } else {
                 assert(0);
             }
@@ -96,13 +140,108 @@ public:
     }
 
     int ms_rows;
+    int ms_changed_row{-1};
+    std::shared_ptr<logfile> ms_file;
 };
 
+/**
+ * Check that redrawing the view only re-renders the rows whose content
+ * changed, using the stamps that mvwattrline() leaves on each row it draws.
+ */
+static bool
+check_damage(listview_curses& lv, my_source& ms)
+{
+    auto* win = lv.get_window();
+    auto top = lv.get_y();
+    auto height = ms.ms_rows;
+    std::vector<uint64_t> stamps;
+    bool retval = true;
+
+    lv.do_update();
+    for (int lpc = 0; lpc < height; lpc++) {
+        stamps.push_back(view_curses::row_stamp(win, top + lpc));
+    }
+
+    lv.set_needs_update();
+    lv.do_update();
+    for (int lpc = 0; lpc < height; lpc++) {
+        if (view_curses::row_stamp(win, top + lpc) != stamps[lpc]) {
+            fprintf(stderr, "error: unchanged row %d was redrawn\n", lpc);
+            retval = false;
+        }
+    }
+
+    ms.ms_changed_row = 3;
+    lv.set_needs_update();
+    lv.do_update();
+    for (int lpc = 0; lpc < height; lpc++) {
+        auto redrawn = view_curses::row_stamp(win, top + lpc) != stamps[lpc];
+
+        if (redrawn != (lpc == ms.ms_changed_row)) {
+            fprintf(stderr,
+                    "error: row %d was %sredrawn\n",
+                    lpc,
+                    redrawn ? "" : "not ");
+            retval = false;
+        }
+    }
+
+    return retval;
+}
+
+/**
+ * Check that redrawing an unchanged view does not allocate and that the
+ * rows that were drawn do not keep the file attributes alive.
+ */
+static bool
+check_allocations(listview_curses& lv, my_source& ms)
+{
+    auto file_owner = std::make_shared<int>(0);
+    std::weak_ptr<int> file_ref = file_owner;
+    bool retval = true;
+
+    // The attribute is never dereferenced, an aliased pointer is enough to
+    // track the reference count.
+    ms.ms_file = std::shared_ptr<logfile>(
+        file_owner, reinterpret_cast<logfile*>(file_owner.get()));
+    file_owner.reset();
+    ms.ms_changed_row = -1;
+    lv.set_needs_update();
+    lv.do_update();
+
+    // The first frame sizes the buffers, the second should reuse them.
+    lv.set_needs_update();
+    lv.do_update();
+
+    auto* win = lv.get_window();
+    auto stamp = view_curses::row_stamp(win, lv.get_y() + 2);
+    auto before = ALLOC_COUNT.load();
+    lv.set_needs_update();
+    lv.do_update();
+    auto allocs = ALLOC_COUNT.load() - before;
+    if (allocs > 0) {
+        fprintf(stderr, "error: unchanged frame did %zu allocations\n", allocs);
+        retval = false;
+    }
+    if (view_curses::row_stamp(win, lv.get_y() + 2) != stamp) {
+        fprintf(stderr, "error: row with a file attribute was redrawn\n");
+        retval = false;
+    }
+
+    ms.ms_file.reset();
+    if (!file_ref.expired()) {
+        fprintf(stderr, "error: drawn rows kept the file alive\n");
+        retval = false;
+    }
+
+    return retval;
+}
+
 int
 main(int argc, char* argv[])
 {
     int c, retval = EXIT_SUCCESS;
-    bool wait_for_input = false, set_height = false;
+    bool wait_for_input = false, set_height = false, damage = false;
     const char* keys = nullptr;
     std::optional<int> rows;
 
@@ -120,12 +259,15 @@ main(int argc, char* argv[])
     auto pipe_err_handle
         = log_pipe_err(errpipe[0].release(), errpipe[1].release());
 
-    while ((c = getopt(argc, argv, "cy:t:k:l:r:h:w")) != -1) {
+    while ((c = getopt(argc, argv, "cdy:t:k:l:r:h:w")) != -1) {
         switch (c) {
             case 'c':
                 // Enable cursor mode
                 lv.set_selectable(true);
                 break;
+            case 'd':
+                damage = true;
+                break;
             case 'y':
                 lv.set_y(atoi(optarg));
                 break;
@@ -169,6 +311,17 @@ main(int argc, char* argv[])
             lv.set_height(vis_line_t(height - lv.get_y()));
         }
 
+        if (damage) {
+            ms.ms_rows = std::max(ms.ms_rows, 8);
+            lv.set_height(vis_line_t(ms.ms_rows));
+            if (!check_damage(lv, ms)) {
+                retval = EXIT_FAILURE;
+            }
+            if (!check_allocations(lv, ms)) {
+                retval = EXIT_FAILURE;
+            }
+        }
+
         if (keys != nullptr) {
             // Treats the string argument as a sequence of key presses (only
             // individual characters supported as key input)
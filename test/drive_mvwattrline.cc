@@ -27,11 +27,14 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <chrono>
+
 #include <locale.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "base/ansi_scrubber.hh"
 #include "base/injector.bind.hh"
 #include "config.h"
 #include "view_curses.hh"
@@ -44,9 +47,14 @@ main(int argc, char* argv[])
 {
     int c, retval = EXIT_SUCCESS;
     bool wait_for_input = false;
+    int bench_count = 0;
+    std::chrono::nanoseconds bench_time{0};
 
-    while ((c = getopt(argc, argv, "w")) != -1) {
+    while ((c = getopt(argc, argv, "b:w")) != -1) {
         switch (c) {
+            case 'b':
+                bench_count = atoi(optarg);
+                break;
             case 'w':
                 wait_for_input = true;
                 break;
@@ -116,6 +124,35 @@ main(int argc, char* argv[])
                         VC_STYLE.value(text_attrs::with_reverse())));
         view_curses::mvwattrline(win, y++, 0, al, lr);
 
+        if (bench_count > 0) {
+            // Time the scrub and render of lines that are as wide as a
+            // large terminal, with and without color and multibyte text.
+            std::string plain;
+            std::string colored;
+            std::string unicode;
+
+            for (int lpc = 0; lpc < 10; lpc++) {
+                plain.append("2024-01-01T00:00:00.000 INFO [main] request ok ");
+                colored.append("\x1b[32m2024-01-01T00:00:00.000\x1b[0m "
+                               "\x1b[1mINFO\x1b[0m [main] request ok ");
+                unicode.append(u8"2024-01-01 \u25b6 r\u00e9sum\u00e9 ok ");
+            }
+
+            struct line_range wide_lr(0, 500);
+            auto start = std::chrono::steady_clock::now();
+            for (int lpc = 0; lpc < bench_count; lpc++) {
+                for (const auto* str : {&plain, &colored, &unicode}) {
+                    auto line = *str;
+
+                    al.clear();
+                    scrub_ansi_string(line, &al.get_attrs());
+                    al.get_string() = std::move(line);
+                    view_curses::mvwattrline(win, 0, 0, al, wide_lr);
+                }
+            }
+            bench_time = std::chrono::steady_clock::now() - start;
+        }
+
         notcurses_render(sc.get_notcurses());
 
         if (wait_for_input) {
@@ -124,5 +161,14 @@ main(int argc, char* argv[])
         }
     }
 
+    if (bench_count > 0) {
+        fprintf(stderr,
+                "rendered %d iterations in %lld us\n",
+                bench_count,
+                (long long) std::chrono::duration_cast<
+                    std::chrono::microseconds>(bench_time)
+                    .count());
+    }
+
     return retval;
 }
@@ -38,6 +38,7 @@
 #include "doctest/doctest.h"
 #include "lnav_config.hh"
 #include "lnav_util.hh"
+#include "pretty_printer.hh"
 #include "ptimec.hh"
 #include "relative_time.hh"
 #include "shlex.hh"
@@ -320,3 +321,130 @@ TEST_CASE("data_scanner quote")
         dp.parse();
     }
 }
+
+TEST_CASE("data_scanner tokenize_lines")
+{
+    static const char INPUT[]
+        = "abc 123\n"
+          "key=value, other=\"q s\".\r\n"
+          "\n"
+          "[1, 2] (a) {b: c}\n"
+          "2024-01-02T03:04:05Z no newline";
+
+    auto buffer = string_fragment::from_const(INPUT);
+    std::vector<data_scanner::batch_token> tokens;
+
+    auto line_count
+        = data_scanner::tokenize_lines(buffer.to_string_view(), tokens, 10);
+    CHECK(line_count == 5);
+
+    auto tok_iter = tokens.begin();
+    auto lines = buffer.split_lines();
+    for (size_t line_index = 0; line_index < lines.size(); line_index++) {
+        auto line = lines[line_index];
+        data_scanner ds(line);
+
+        while (true) {
+            auto tok_res = ds.tokenize2();
+            if (!tok_res) {
+                break;
+            }
+
+            REQUIRE(tok_iter != tokens.end());
+            CHECK(tok_iter->bt_line == 10 + line_index);
+            CHECK(tok_iter->bt_token == tok_res->tr_token);
+            CHECK(buffer.sub_range(tok_iter->bt_capture.c_begin,
+                                   tok_iter->bt_capture.c_end)
+                  == tok_res->to_string_fragment());
+            CHECK(buffer.sub_range(tok_iter->bt_inner_capture.c_begin,
+                                   tok_iter->bt_inner_capture.c_end)
+                  == tok_res->inner_string_fragment());
+            ++tok_iter;
+        }
+    }
+    CHECK(tok_iter == tokens.end());
+}
+
+TEST_CASE("pretty_printer streaming")
+{
+    std::string input = "{\"items\": [";
+    for (int lpc = 0; lpc < 2000; lpc++) {
+        auto id = std::to_string(lpc);
+
+        if (lpc > 0) {
+            input.append(", ");
+        }
+        input.append("{\"id\": " + id + ", \"name\": \"item \\\"" + id
+                     + "\\\"\", \"tags\": [\"a\", 'b'], "
+                       "\"nested\": \"{\\\"k\\\": [1, 2]}\"}");
+    }
+    input.append("]}\n");
+
+    data_scanner ds(input);
+    pretty_printer whole_pp(&ds, {});
+    attr_line_t whole_al;
+    whole_pp.append_to(whole_al);
+    auto expected = whole_al.split_lines();
+    while (!expected.empty() && expected.back().empty()) {
+        expected.pop_back();
+    }
+
+    std::vector<attr_line_t> actual;
+    pretty_printer stream_pp(
+        [&actual](attr_line_t&& al) { actual.emplace_back(std::move(al)); });
+    auto rest = string_fragment::from_str(input);
+    while (!rest.empty()) {
+        auto piece = rest.sub_range(0, std::min(rest.length(), 1000));
+        stream_pp.feed(piece);
+        rest = rest.substr(piece.length());
+    }
+    stream_pp.finish();
+
+    REQUIRE(actual.size() == expected.size());
+    for (size_t lpc = 0; lpc < actual.size(); lpc++) {
+        CHECK(actual[lpc].get_string() == expected[lpc].get_string());
+    }
+}
+
+TEST_CASE("pretty_printer streaming flush")
+{
+    // Generate more than a megabyte of output from a single feed() so that
+    // lines are passed to the sink before finish() is called, along with a
+    // string value that is longer than the flush size.
+    std::string input = "{\"long\": \"";
+    input.append(1536 * 1024, 'x');
+    input.append("\", \"items\": [");
+    for (int lpc = 0; lpc < 20000; lpc++) {
+        auto id = std::to_string(lpc);
+
+        if (lpc > 0) {
+            input.append(", ");
+        }
+        input.append("{\"id\": " + id + ", \"name\": \"item " + id
+                     + "\", \"tags\": [\"a\", \"b\"]}");
+    }
+    input.append("]}\n");
+
+    data_scanner ds(input);
+    pretty_printer whole_pp(&ds, {});
+    attr_line_t whole_al;
+    whole_pp.append_to(whole_al);
+    auto expected = whole_al.split_lines();
+    while (!expected.empty() && expected.back().empty()) {
+        expected.pop_back();
+    }
+
+    std::vector<attr_line_t> actual;
+    pretty_printer stream_pp(
+        [&actual](attr_line_t&& al) { actual.emplace_back(std::move(al)); });
+    stream_pp.feed(string_fragment::from_str(input));
+    auto lines_before_finish = actual.size();
+    stream_pp.finish();
+
+    CHECK(lines_before_finish > 0);
+    CHECK(lines_before_finish < actual.size());
+    REQUIRE(actual.size() == expected.size());
+    for (size_t lpc = 0; lpc < actual.size(); lpc++) {
+        CHECK(actual[lpc].get_string() == expected[lpc].get_string());
+    }
+}
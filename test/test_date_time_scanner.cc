@@ -278,3 +278,200 @@ TEST_CASE("date_time_scanner")
         assert(strcmp(ts, buf) == 0);
     }
 }
+
+TEST_CASE("date_time_scanner prefix memo")
+{
+    setenv("TZ", "UTC", 1);
+
+    static const std::vector<std::vector<const char*>> SEQUENCES = {
+        {
+            "2024-05-01T13:42:58.123Z",
+            "2024-05-01T13:42:59.999Z",
+            "2024-05-01T13:42:59.5Z",
+            "2024-05-01T13:43:00.001Z",
+            "2024-05-01T13:59:59.000Z",
+            "2024-05-01T14:00:00.000Z",
+            "2024-05-01T23:59:59.999Z",
+            "2024-05-02T00:00:00.000Z",
+            "2024-05-02T00:00:00.000+0100",
+            "2024-05-02T00:00:01.000+0100",
+            "2024-05-02T00:00:01.000+0000",
+            "2024-12-31T23:59:59.999Z",
+            "2025-01-01T00:00:00.001Z",
+        },
+        {
+            "09/Aug/2023:21:41:44 +0000",
+            "09/Aug/2023:21:41:45 +0000",
+            "09/Aug/2023:21:41:45 -0700",
+            "09/Aug/2023:21:41:59 -0700",
+            "09/Aug/2023:21:42:00 -0700",
+            "09/Aug/2023:21:42:00 +0000",
+        },
+        {
+            "May 01 00:00:01",
+            "May 01 00:00:59",
+            "May 01 00:01:00",
+            "May 01 23:59:59",
+            "May 02 00:00:00",
+            "May 02 00:00:00.123",
+            "May 02 00:00:01.123456",
+        },
+        {
+            "2014-02-11 16:12:34",
+            "2014-02-11 16:12:34.123",
+            "2014-02-11 16:12:35",
+            "2014-02-11 16:12:35,456",
+            "2014-02-11 16:12:36.123.456",
+        },
+    };
+
+    for (const auto& seq : SEQUENCES) {
+        date_time_scanner dts;
+
+        for (const auto* ts : seq) {
+            date_time_scanner fresh_dts;
+            timeval tv, fresh_tv;
+            exttm tm, fresh_tm;
+
+            // Scan with the same locked format, but without the memo.
+            const auto ls = dts.unlock();
+            dts.relock(ls);
+            fresh_dts.relock(ls);
+            const auto* rc = dts.scan(ts, strlen(ts), nullptr, &tm, tv);
+            const auto* fresh_rc
+                = fresh_dts.scan(ts, strlen(ts), nullptr, &fresh_tm, fresh_tv);
+            INFO(std::string(ts));
+            REQUIRE(fresh_rc != nullptr);
+            CHECK(rc == fresh_rc);
+            CHECK(tv.tv_sec == fresh_tv.tv_sec);
+            CHECK(tv.tv_usec == fresh_tv.tv_usec);
+            CHECK(dts.dts_fmt_len == fresh_dts.dts_fmt_len);
+
+            char buf[64], fresh_buf[64];
+            dts.ftime(buf, sizeof(buf), nullptr, tm);
+            fresh_dts.ftime(fresh_buf, sizeof(fresh_buf), nullptr, fresh_tm);
+            CHECK(std::string(buf) == std::string(fresh_buf));
+        }
+    }
+
+    {
+        static const char* TIMES[] = {
+            "22:46:03,471",
+            "22:46:04,471",
+            "22:46:04,9",
+            "22:47:00,000",
+        };
+        const char* fmt[] = {
+            "%H:%M:%S,%L",
+            nullptr,
+        };
+        date_time_scanner dts;
+
+        for (const auto* ts : TIMES) {
+            date_time_scanner fresh_dts;
+            timeval tv, fresh_tv;
+            exttm tm, fresh_tm;
+
+            const auto ls = dts.unlock();
+            dts.relock(ls);
+            fresh_dts.relock(ls);
+            const auto* rc = dts.scan(ts, strlen(ts), fmt, &tm, tv);
+            const auto* fresh_rc
+                = fresh_dts.scan(ts, strlen(ts), fmt, &fresh_tm, fresh_tv);
+            INFO(std::string(ts));
+            REQUIRE(fresh_rc != nullptr);
+            CHECK(rc == fresh_rc);
+            CHECK(tv.tv_sec == fresh_tv.tv_sec);
+            CHECK(tv.tv_usec == fresh_tv.tv_usec);
+        }
+    }
+}
+
+TEST_CASE("date_time_scanner shapes")
+{
+    setenv("TZ", "UTC", 1);
+
+    static const char* NOT_TIMES[] = {
+        "Brown fox jumps over the lazy dog",
+        "12:0U1:02",
+        "May 01 00:0x:01",
+        "at java.lang.Thread.run(Thread.java:748)",
+    };
+
+    for (const auto* not_time : NOT_TIMES) {
+        date_time_scanner dts;
+        timeval tv;
+        exttm tm;
+
+        INFO(not_time);
+        CHECK(dts.scan(not_time, strlen(not_time), nullptr, &tm, tv)
+              == nullptr);
+    }
+
+    {
+        const auto* ts = "May 01 00:00:01 host prog: msg";
+        date_time_scanner dts;
+        timeval tv;
+        exttm tm;
+
+        const auto* rc = dts.scan(ts, strlen(ts), nullptr, &tm, tv);
+        REQUIRE(rc != nullptr);
+        CHECK(rc - ts == 15);
+        CHECK(std::string(PTIMEC_FORMAT_STR[dts.dts_fmt_lock])
+              == "%b %d %H:%M:%S");
+    }
+}
+
+TEST_CASE("date_time_scanner shapes round-trip")
+{
+    setenv("TZ", "UTC", 1);
+
+    exttm sample;
+    time_t sample_time = 1661620921;
+    gmtime_r(&sample_time, &sample.et_tm);
+    sample.et_nsec = 694554000;
+    sample.et_gmtoff = -7 * 60 * 60;
+    sample.et_flags
+        = ETF_DAY_SET | ETF_MONTH_SET | ETF_YEAR_SET | ETF_ZONE_SET;
+
+    for (int lpc = 0; PTIMEC_FORMAT_STR[lpc] != nullptr; lpc++) {
+        char buf[128];
+        off_t off = 0;
+
+        PTIMEC_FORMATS[lpc].pf_ffunc(buf, off, sizeof(buf), sample);
+        buf[off] = '\0';
+        if (strcmp(PTIMEC_FORMAT_STR[lpc], "@%@") == 0) {
+            // There is no formatter for TAI64N labels, so build one.
+            off = snprintf(buf,
+                           sizeof(buf),
+                           "@%016llx%08x",
+                           0x400000000000000aULL + sample_time,
+                           0);
+        }
+
+        INFO(PTIMEC_FORMAT_STR[lpc]);
+        INFO(buf);
+
+        // Find the format that trying each one in order would pick, which
+        // is the format itself unless an earlier one also accepts the text.
+        auto expected = -1;
+        for (int prev = 0; prev <= lpc && expected == -1; prev++) {
+            date_time_scanner dts;
+            timeval tv;
+            exttm tm;
+
+            dts.relock({prev, -1});
+            if (dts.scan(buf, off, nullptr, &tm, tv) != nullptr) {
+                expected = prev;
+            }
+        }
+        REQUIRE(expected != -1);
+
+        date_time_scanner dts;
+        timeval tv;
+        exttm tm;
+
+        REQUIRE(dts.scan(buf, off, nullptr, &tm, tv) != nullptr);
+        CHECK(dts.dts_fmt_lock == expected);
+    }
+}
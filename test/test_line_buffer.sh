@@ -75,4 +75,132 @@ run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.gz lb-3.dat
 
 check_output "Random gzipped reads don't match input" <<EOF
 All done
-EOF
\ No newline at end of file
+EOF
+
+run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.gz lb-3.dat
+
+check_output "Random gzipped reads with a saved index don't match input" <<EOF
+All done
+EOF
+
+> lb-6.dat
+while test $(wc -c < lb-6.dat) -le 40000000 ; do
+    cat lb-2.dat >> lb-6.dat
+done
+gzip -c -1 lb-6.dat > lb-6.gz
+grep -b '$' lb-6.dat | cut -f 1 -d : > lb-6.index
+
+run_test ./drive_line_buffer -s 5000 -i lb-6.index -n 1 lb-6.gz lb-6.dat
+
+check_output "Seeks while indexing a large gzip member don't match input" <<EOF
+All done
+EOF
+
+> lb-4.gz
+> lb-4.dat
+while test $(wc -c < lb-4.gz) -le 9000000 ; do
+    cat lb-2.dat >> lb-4.dat
+    gzip -c -1 lb-2.dat >> lb-4.gz
+done
+grep -b '$' lb-4.dat | cut -f 1 -d : > lb-4.index
+
+run_test ./drive_line_buffer -c 100000000 lb-4.gz
+
+check_output "Multi-member gzip output doesn't match input" < lb-4.dat
+
+run_test ./drive_line_buffer -i lb-4.index -n 10 lb-4.gz lb-4.dat
+
+check_output "Random multi-member gzip reads don't match input" <<EOF
+All done
+EOF
+
+run_test ./drive_line_buffer -s 5000 -i lb-4.index -n 1 lb-4.gz lb-4.dat
+
+check_output "Seeks while indexing a multi-member gzip don't match input" <<EOF
+All done
+EOF
+if [ "$BZIP2_SUPPORT" -eq 1 ] && [ x"$BZIP2_CMD" != x"" ] ; then
+    $BZIP2_CMD -z -c lb-3.dat > lb-3.bz2
+
+    run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.bz2 lb-3.dat
+
+    check_output "Random bzip2 reads don't match input" <<EOF
+All done
+EOF
+fi
+
+le32() {
+    printf "$(printf '\\%03o\\%03o\\%03o\\%03o' \
+        $(($1 & 255)) $((($1 >> 8) & 255)) \
+        $((($1 >> 16) & 255)) $((($1 >> 24) & 255)))"
+}
+
+if [ "$ZSTD_SUPPORT" -eq 1 ] && [ x"$ZSTD_CMD" != x"" ] ; then
+    $ZSTD_CMD -q -c lb-3.dat > lb-3.zst
+
+    run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.zst lb-3.dat
+
+    check_output "Random zstd reads don't match input" <<EOF
+All done
+EOF
+
+    > lb-5.zst
+    > lb-5.dat
+    while test $(wc -c < lb-5.zst) -le 9000000 ; do
+        cat lb-2.dat >> lb-5.dat
+        $ZSTD_CMD -q -c lb-2.dat >> lb-5.zst
+    done
+    grep -b '$' lb-5.dat | cut -f 1 -d : > lb-5.index
+
+    run_test ./drive_line_buffer -c 100000000 lb-5.zst
+
+    check_output "Multi-frame zstd output doesn't match input" < lb-5.dat
+
+    run_test ./drive_line_buffer -i lb-5.index -n 10 lb-5.zst lb-5.dat
+
+    check_output "Random multi-frame zstd reads don't match input" <<EOF
+All done
+EOF
+
+    # Frames that are small enough to be cached and decompressed in
+    # parallel, with and without a seek table.
+    split -b 1000000 lb-3.dat lb-8.part.
+    > lb-8.zst
+    > lb-9.zst
+    > lb-9.table
+    frames=0
+    for part in lb-8.part.*; do
+        $ZSTD_CMD -q -c $part >> lb-8.zst
+        $ZSTD_CMD -q -c --no-content-size $part > lb-9.frame
+        cat lb-9.frame >> lb-9.zst
+        le32 $(wc -c < lb-9.frame) >> lb-9.table
+        le32 $(wc -c < $part) >> lb-9.table
+        frames=$((frames + 1))
+    done
+    le32 0x184D2A5E >> lb-9.zst
+    le32 $(($(wc -c < lb-9.table) + 9)) >> lb-9.zst
+    cat lb-9.table >> lb-9.zst
+    le32 ${frames} >> lb-9.zst
+    printf '\000' >> lb-9.zst
+    le32 0x8F92EAB1 >> lb-9.zst
+
+    run_test ./drive_line_buffer -c 100000000 lb-8.zst
+
+    check_output "Small-frame zstd output doesn't match input" < lb-3.dat
+
+    run_test ./drive_line_buffer -s 5000 -i lb-3.index -n 10 lb-8.zst lb-3.dat
+
+    check_output "Random small-frame zstd reads don't match input" <<EOF
+All done
+EOF
+
+    run_test ./drive_line_buffer -c 100000000 lb-9.zst
+
+    check_output "Seekable zstd output doesn't match input" < lb-3.dat
+
+    run_test ./drive_line_buffer -s 5000 -i lb-3.index -n 10 lb-9.zst lb-3.dat
+
+    check_output "Random seekable zstd reads don't match input" <<EOF
+All done
+EOF
+fi
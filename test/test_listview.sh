@@ -81,3 +81,8 @@ run_test ./scripty -n -e ${srcdir}/listview_output_cursor.6 -- \
     ./drive_listview  -r 30 -h 10 -c -k '  b' < /dev/null
 
 on_error_fail_with "Listview Cursor Mode: didn't moved up on page jump?"
+
+# Only the rows that changed are drawn again
+run_test ./scripty -n -- ./drive_listview -d < /dev/null
+
+on_error_fail_with "Listview redrew rows that did not change?"
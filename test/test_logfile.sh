@@ -747,3 +747,164 @@ touch -t 202411030000 ${test_dir}/logfile_dst.0
 run_cap_test env TZ=America/Los_Angeles ${lnav_test} -n \
     -c ':set-file-timezone America/Los_Angeles' \
     ${test_dir}/logfile_dst.0
+
+cat > stream-a.log <<EOF
+192.168.1.1 - - [20/Jul/2009:22:59:26 +0000] "GET /a1 HTTP/1.0" 200 134 "-" "test"
+192.168.1.1 - - [20/Jul/2009:22:59:30 +0000] "GET /a2 HTTP/1.0" 404 46 "-" "test"
+192.168.1.1 - - [20/Jul/2009:22:59:34 +0000] "GET /a3 HTTP/1.0" 200 46 "-" "test"
+EOF
+
+cat > stream-b.log <<EOF
+192.168.1.2 - - [20/Jul/2009:22:59:28 +0000] "GET /b1 HTTP/1.0" 200 134 "-" "test"
+192.168.1.2 - - [20/Jul/2009:22:59:32 +0000] "GET /b2 HTTP/1.0" 500 46 "-" "test"
+EOF
+
+run_test ${lnav_test} -s \
+    -c ':filter-out /a2' \
+    stream-a.log stream-b.log
+
+check_output "streamed files are not merged by time" <<EOF
+192.168.1.1 - - [20/Jul/2009:22:59:26 +0000] "GET /a1 HTTP/1.0" 200 134 "-" "test"
+192.168.1.2 - - [20/Jul/2009:22:59:28 +0000] "GET /b1 HTTP/1.0" 200 134 "-" "test"
+192.168.1.2 - - [20/Jul/2009:22:59:32 +0000] "GET /b2 HTTP/1.0" 500 46 "-" "test"
+192.168.1.1 - - [20/Jul/2009:22:59:34 +0000] "GET /a3 HTTP/1.0" 200 46 "-" "test"
+EOF
+
+run_test ${lnav_test} -s \
+    -c ':set-min-log-level error' \
+    stream-a.log stream-b.log
+
+check_output "min-log-level is not applied when streaming" <<EOF
+192.168.1.1 - - [20/Jul/2009:22:59:30 +0000] "GET /a2 HTTP/1.0" 404 46 "-" "test"
+192.168.1.2 - - [20/Jul/2009:22:59:32 +0000] "GET /b2 HTTP/1.0" 500 46 "-" "test"
+EOF
+
+run_test ${lnav_test} -s \
+    -c ':filter-out /a2' \
+    -c ':write-raw-to stream-out.log' \
+    stream-a.log stream-b.log
+
+check_output "streamed messages were written to stdout" <<EOF
+EOF
+
+run_test cat stream-out.log
+
+check_output "streamed messages were not written to the file" <<EOF
+192.168.1.1 - - [20/Jul/2009:22:59:26 +0000] "GET /a1 HTTP/1.0" 200 134 "-" "test"
+192.168.1.2 - - [20/Jul/2009:22:59:28 +0000] "GET /b1 HTTP/1.0" 200 134 "-" "test"
+192.168.1.2 - - [20/Jul/2009:22:59:32 +0000] "GET /b2 HTTP/1.0" 500 46 "-" "test"
+192.168.1.1 - - [20/Jul/2009:22:59:34 +0000] "GET /a3 HTTP/1.0" 200 46 "-" "test"
+EOF
+rm -f stream-out.log
+
+# The memory used when streaming should not grow with the size of the input.
+for scale in 1 10; do
+    awk -v count=$((scale * 20000)) 'BEGIN {
+        for (i = 0; i < count; i++) {
+            printf("192.168.1.1 - - [20/Jul/2009:22:59:26 +0000] \"GET /x%d HTTP/1.0\" 200 134 \"-\" \"test\"\n", i);
+        }
+    }' > stream-${scale}x.log
+    ${lnav_test} -d stream-${scale}x.err -s \
+        -c ':filter-in /x1 ' \
+        stream-${scale}x.log > /dev/null
+done
+
+rss_1x=$(sed -n -e 's/.*max_rss=\([0-9]*\).*/\1/p' stream-1x.err)
+rss_10x=$(sed -n -e 's/.*max_rss=\([0-9]*\).*/\1/p' stream-10x.err)
+if test -z "${rss_1x}" -o -z "${rss_10x}"; then
+    echo "error: max_rss was not logged when streaming"
+    exit 1
+fi
+if test "${rss_10x}" -gt $((rss_1x + rss_1x / 10)); then
+    echo "error: streaming memory grew from ${rss_1x} to ${rss_10x}"
+    exit 1
+fi
+rm -f stream-1x.log stream-10x.log
+
+for i in $(seq 0 47); do
+    printf '192.168.1.1 - - [%02d/Jul/2009:%02d:00:00 +0000] "GET /x%02d HTTP/1.0" 200 134 "-" "test"\n' \
+        $((20 + i / 24)) $((i % 24)) $i
+done > retention.0
+
+run_test ${lnav_test} -n \
+    -c ":goto 5" \
+    -c ":mark" \
+    -c ":goto 40" \
+    -c ":mark" \
+    -c ":config /tuning/logfile/retention/max-age 12h" \
+    -c ":rebuild" \
+    -c ";SELECT count(*) AS total FROM access_log" \
+    -c ":write-csv-to -" \
+    -c ";SELECT log_line, cs_uri_stem FROM access_log WHERE log_mark = 1" \
+    -c ":write-csv-to -" \
+    -c ";SELECT selection FROM lnav_views WHERE name = 'log'" \
+    -c ":write-csv-to -" \
+    retention.0
+
+check_output "max-age retention did not drop the old messages" <<EOF
+total
+13
+log_line,cs_uri_stem
+5,/x40
+selection
+5
+EOF
+
+run_test ${lnav_test} -n \
+    -c ":filter-out /x0" \
+    -c ":filter-out /x4" \
+    -c ":config /tuning/logfile/retention/max-age 12h" \
+    -c ":rebuild" \
+    -c ";SELECT hits FROM lnav_view_filter_stats ORDER BY filter_id" \
+    -c ":write-csv-to -" \
+    retention.0
+
+check_output "retention did not update the filter hit counts" <<EOF
+hits
+0
+8
+EOF
+
+for i in $(seq 0 47); do
+    if test $i -ge 36; then
+        printf 'www.example.com '
+    fi
+    printf '192.168.1.1 - - [%02d/Jul/2009:%02d:00:00 +0000] "GET /x%02d HTTP/1.0" 200 134\n' \
+        $((20 + i / 24)) $((i % 24)) $i
+done > retention.1
+
+run_test ${lnav_test} -n \
+    -c ":config /tuning/logfile/retention/max-age 12h" \
+    -c ":rebuild" \
+    -c ";SELECT log_line, log_format_regex FROM access_log WHERE log_line < 3" \
+    -c ":write-csv-to -" \
+    retention.1
+
+check_output "retention did not shift the pattern locks" <<EOF
+log_line,log_format_regex
+0,std
+1,std-vhost
+2,std-vhost
+EOF
+
+run_test ${lnav_test} -n \
+    -c ":goto 40" \
+    -c ":mark" \
+    -c ":config /tuning/logfile/retention/max-size 840" \
+    -c ":rebuild" \
+    -c ";SELECT count(*) AS total FROM access_log" \
+    -c ":write-csv-to -" \
+    -c ";SELECT log_line, cs_uri_stem FROM access_log WHERE log_mark = 1" \
+    -c ":write-csv-to -" \
+    -c ";SELECT selection FROM lnav_views WHERE name = 'log'" \
+    -c ":write-csv-to -" \
+    retention.0
+
+check_output "max-size retention did not drop the old messages" <<EOF
+total
+10
+log_line,cs_uri_stem
+2,/x40
+selection
+2
+EOF
@@ -94,3 +94,67 @@ run_cap_test ${lnav_test} -d sql_index.err -n \
     -c ":write-csv-to -" \
     -c ":switch-to-view log" \
     ${test_dir}/logfile_shop_access_log.0
+
+run_test ${lnav_test} -n \
+    -c ";SELECT log_line, cs_uri_stem FROM access_log WHERE cs_uri_stem LIKE '%/VMKERNEL.gz'" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_access_log.0
+
+check_output "LIKE constraint on a format column is not prescreened correctly?" <<EOF
+log_line,cs_uri_stem
+2,/vmw/vSphere/default/vmkernel.gz
+EOF
+
+run_test ${lnav_test} -n \
+    -c ";SELECT log_line, cs_uri_stem FROM access_log WHERE cs_uri_stem GLOB '*/vmk*' AND cs_uri_stem NOT GLOB '*VMK*'" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_access_log.0
+
+check_output "GLOB constraint on a format column is not prescreened correctly?" <<EOF
+log_line,cs_uri_stem
+1,/vmw/vSphere/default/vmkboot.gz
+2,/vmw/vSphere/default/vmkernel.gz
+EOF
+
+run_test ${lnav_test} -n \
+    -c ";SELECT log_line, cs_uri_stem FROM access_log WHERE c_ip GLOB '*[0123456789]*' AND cs_uri_stem GLOB '*vmk[aeiou]*'" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_access_log.0
+
+check_output "GLOB bracket expression is prescreened as a literal?" <<EOF
+log_line,cs_uri_stem
+2,/vmw/vSphere/default/vmkernel.gz
+EOF
+
+run_test ${lnav_test} -n \
+    -c ":create-log-index access_log c_ip" \
+    -c ";SELECT log_line FROM access_log WHERE c_ip = '192.168.202.254'" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_access_log.0
+
+check_output "create-log-index is not working?" <<EOF
+log_line
+0
+1
+2
+EOF
+
+rm -f sql_index.err
+run_test ${lnav_test} -d sql_index.err -n \
+    -c ":create-log-index access_log c_ip cs_method" \
+    -c ";SELECT log_line FROM access_log WHERE c_ip = '34.247.132.53'" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_output "create-log-index with several columns is not working?" <<EOF
+log_line
+33
+332
+630
+EOF
+
+visited=$(sed -n -e 's/.*rows visited \([0-9]*\).*/\1/p' sql_index.err | tail -1)
+if test -z "${visited}" || test "${visited}" -gt 10; then
+    echo "error: the index was not used, visited ${visited} rows"
+    exit 1
+fi
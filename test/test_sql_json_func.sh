@@ -76,6 +76,13 @@ run_cap_test ./drive_sql "select typeof(jget('[null, true, 20, 30, 4.0]', '/4'))
 
 run_cap_test ./drive_sql "select jget('[null, true, 20, 30, 40', '/0/foo')"
 
+JGET_SELECT_MULTI=$(cat <<EOF
+SELECT jget(j, '/a') AS a, jget(j, '/b/1') AS b1, jget(j, '/b') AS b, jget(j, '/c/d', 'none') AS cd, jget(j, '/c/e', 'none') AS ce FROM (SELECT '{"a": 1, "b": [true, "x"], "c": {"d": null}}' AS j)
+EOF
+)
+
+run_cap_test ./drive_sql "$JGET_SELECT_MULTI"
+
 run_cap_test ./drive_sql "select json_group_object(key) from (select 1 as key)"
 
 GROUP_SELECT_1=$(cat <<EOF
@@ -131,4 +138,7 @@ EOF
 
 run_cap_test ./drive_sql "$GROUP_ARRAY_SELECT_2"
 
-run_cap_test ./drive_sql "SELECT json_group_array(column1) FROM (VALUES (1)) WHERE 0"
\ No newline at end of file
+run_cap_test ./drive_sql "SELECT json_group_array(column1) FROM (VALUES (1)) WHERE 0"
+run_test ./drive_json_lookup 1000
+
+on_error_fail_with "jget() lookups do not match json_extract()"
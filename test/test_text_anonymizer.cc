@@ -31,6 +31,7 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest/doctest.h"
+#include "fmt/format.h"
 #include "text_anonymizer.hh"
 
 TEST_CASE("ipv4")
@@ -129,3 +130,58 @@ TEST_CASE("xml")
     CHECK(ta.next(string_fragment::from_const("<o:gupdate xmlns:o=\"http://www.google.com/update2/request\" protocol=\"2.0\" version=\"KeystoneDaemon-1.2.0.7709\" ismachine=\"1\" requestid=\"{0DFDBCD1-5E29-4DFC-BD99-31A2397198FE}\">")) ==
           "<o:gupdate  xmlns:o=\"http://achondroplasia.example.com/aback2/abandoned\" protocol=\"2.0\" version=\"KeystoneDaemon-1.2.0.7709\" ismachine=\"1\" requestid=\"{1ca0a968-cbe9-e75b-d00b-4859609878ea}\">");
 }
+
+TEST_CASE("batch")
+{
+    std::vector<std::string> lines;
+    for (int lpc = 0; lpc < 1000; lpc++) {
+        lines.emplace_back(
+            fmt::format(FMT_STRING("{} connected from 192.168.{}.{} as "
+                                   "user{}@example{}.org"),
+                        lpc % 97,
+                        lpc % 13,
+                        lpc % 251,
+                        lpc % 37,
+                        lpc % 23));
+        lines.emplace_back(fmt::format(
+            FMT_STRING("GET https://bob{}:pw@host{}.example.com/path{}/"
+                       "file{}?id={}"),
+            lpc % 11,
+            lpc % 29,
+            lpc % 7,
+            lpc % 41,
+            lpc));
+        lines.emplace_back(fmt::format(
+            FMT_STRING("opened /var/log/app{}/file{}.log mac "
+                       "f2:09:1a:a2:e3:{:02x}"),
+            lpc % 5,
+            lpc % 61,
+            lpc % 256));
+        lines.emplace_back(fmt::format(
+            FMT_STRING("state is Constants.STATE_{} for \"quoted value {}\""),
+            lpc % 19,
+            lpc % 43));
+        lines.emplace_back(
+            fmt::format(FMT_STRING("fe80::1887:2f2d:bc2e:{:x} sent {} bytes to "
+                                   "node{}"),
+                        lpc % 300,
+                        lpc,
+                        lpc % 53));
+    }
+
+    lnav::text_anonymizer serial_ta;
+    std::vector<std::string> expected;
+    for (const auto& line : lines) {
+        expected.emplace_back(serial_ta.next(line));
+    }
+
+    for (size_t threads : {1, 2, 3, 8}) {
+        lnav::text_anonymizer ta;
+        auto mid = lines.begin() + lines.size() / 3;
+        auto actual = ta.next_batch({lines.begin(), mid}, threads);
+        auto rest = ta.next_batch({mid, lines.end()}, threads);
+
+        actual.insert(actual.end(), rest.begin(), rest.end());
+        CHECK(actual == expected);
+    }
+}
@@ -56,3 +56,11 @@ run_cap_test ${lnav_test} -n \
     -c ':switch-to-view timeline' \
     -c ':hide-lines-after 2011-11-03 00:20:30' \
     ${test_dir}/logfile_bro_http.log.0
+
+# The operations added after the timeline was built are merged in
+run_cap_test ${lnav_test} -n \
+    -c ':switch-to-view timeline' \
+    -c ";UPDATE all_logs set log_opid = 'test1' where log_line in (1, 3, 6)" \
+    -c ':switch-to-view log' \
+    -c ':switch-to-view timeline' \
+    ${test_dir}/logfile_glog.0